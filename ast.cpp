@@ -8,19 +8,82 @@
 namespace Sass {
   using namespace std;
 
-  bool Compound_Selector::operator<(const Compound_Selector& rhs) const
+  int Simple_Selector::compare(const Simple_Selector& rhs) const
   {
+    const string* l = name_key();
+    const string* r = rhs.name_key();
+    if (l && r) {
+      // names carry their sigil, so equal names imply equal kinds
+      return l->compare(*r);
+    }
     To_String to_string;
-    // ugly
-    return const_cast<Compound_Selector*>(this)->perform(&to_string) <
-           const_cast<Compound_Selector&>(rhs).perform(&to_string);
+    return const_cast<Simple_Selector*>(this)->perform(&to_string).compare(
+           const_cast<Simple_Selector&>(rhs).perform(&to_string));
   }
 
-  bool Complex_Selector::operator<(const Complex_Selector& rhs) const
+  size_t Simple_Selector::hash() const
   {
+    if (const string* k = name_key()) return hash_key(*k);
     To_String to_string;
-    return const_cast<Complex_Selector*>(this)->perform(&to_string) <
-           const_cast<Complex_Selector&>(rhs).perform(&to_string);
+    return hash_key(const_cast<Simple_Selector*>(this)->perform(&to_string));
+  }
+
+  size_t Compound_Selector::hash() const
+  {
+    if (!hash_) {
+      size_t h = length();
+      for (size_t i = 0, L = length(); i < L; ++i) {
+        h = h * 31 + (*const_cast<Compound_Selector*>(this))[i]->hash();
+      }
+      hash_ = h ? h : 1;
+    }
+    return hash_;
+  }
+
+  int Compound_Selector::compare(const Compound_Selector& rhs) const
+  {
+    if (this == &rhs) return 0;
+    size_t lh = hash(), rh = rhs.hash();
+    if (lh != rh) return lh < rh ? -1 : 1;
+    Compound_Selector& l = *const_cast<Compound_Selector*>(this);
+    Compound_Selector& r = const_cast<Compound_Selector&>(rhs);
+    for (size_t i = 0, L = length(), R = rhs.length(); i < L && i < R; ++i) {
+      int c = l[i]->compare(*r[i]);
+      if (c) return c;
+    }
+    if (length() == rhs.length()) return 0;
+    return length() < rhs.length() ? -1 : 1;
+  }
+
+  bool Compound_Selector::operator==(const Compound_Selector& rhs) const
+  { return compare(rhs) == 0; }
+
+  bool Compound_Selector::operator<(const Compound_Selector& rhs) const
+  { return compare(rhs) < 0; }
+
+  size_t Complex_Selector::hash() const
+  {
+    size_t h = combinator();
+    if (head()) h = h * 31 + head()->hash();
+    if (tail()) h = h * 31 + tail()->hash();
+    return h;
+  }
+
+  int Complex_Selector::compare(const Complex_Selector& rhs) const
+  {
+    if (this == &rhs) return 0;
+    Compound_Selector* lh = head();
+    Compound_Selector* rh = rhs.head();
+    if (!lh != !rh) return lh ? 1 : -1;
+    if (lh) {
+      int c = lh->compare(*rh);
+      if (c) return c;
+    }
+    if (combinator() != rhs.combinator()) return combinator() < rhs.combinator() ? -1 : 1;
+    Complex_Selector* lt = tail();
+    Complex_Selector* rt = rhs.tail();
+    if (!lt != !rt) return lt ? 1 : -1;
+    return lt ? lt->compare(*rt) : 0;
   }
 
   Compound_Selector* Compound_Selector::unify_with(Compound_Selector* rhs, Context& ctx)
@@ -36,9 +99,8 @@ namespace Sass {
 
   Compound_Selector* Simple_Selector::unify_with(Compound_Selector* rhs, Context& ctx)
   {
-    To_String to_string;
     for (size_t i = 0, L = rhs->length(); i < L; ++i)
-    { if (perform(&to_string) == (*rhs)[i]->perform(&to_string)) return rhs; }
+    { if (*this == *(*rhs)[i]) return rhs; }
 
     // check for pseudo elements because they need to come last
     size_t i, L;
@@ -143,34 +205,33 @@ namespace Sass {
 
   bool Compound_Selector::is_superselector_of(Compound_Selector* rhs)
   {
-    To_String to_string;
-
     Simple_Selector* lbase = base();
     Simple_Selector* rbase = rhs->base();
 
-    set<string> lset, rset;
+    set<Simple_Selector*, Simple_Selector_Less> lset, rset;
+    Simple_Selector_Less less;
 
     // TODO: check pseudo-elements once we store semantic info for them
     if (!lbase) // no lbase; just see if the left-hand qualifiers are a subset of the right-hand selector
     {
       for (size_t i = 0, L = length(); i < L; ++i)
-      { lset.insert((*this)[i]->perform(&to_string)); }
+      { lset.insert((*this)[i]); }
       for (size_t i = 0, L = rhs->length(); i < L; ++i)
-      { rset.insert((*rhs)[i]->perform(&to_string)); }
-      return includes(rset.begin(), rset.end(), lset.begin(), lset.end());
+      { rset.insert((*rhs)[i]); }
+      return includes(rset.begin(), rset.end(), lset.begin(), lset.end(), less);
     }
     else { // there's an lbase
       for (size_t i = 1, L = length(); i < L; ++i)
-      { lset.insert((*this)[i]->perform(&to_string)); }
+      { lset.insert((*this)[i]); }
       if (rbase)
       {
-        if (lbase->perform(&to_string) != rbase->perform(&to_string)) // if there's an rbase, make sure they match
+        if (!(*lbase == *rbase)) // if there's an rbase, make sure they match
         { return false; }
         else // the bases do match, so compare qualifiers
         {
           for (size_t i = 1, L = rhs->length(); i < L; ++i)
-          { rset.insert((*rhs)[i]->perform(&to_string)); }
-          return includes(rset.begin(), rset.end(), lset.begin(), lset.end());
+          { rset.insert((*rhs)[i]); }
+          return includes(rset.begin(), rset.end(), lset.begin(), lset.end(), less);
         }
       }
     }
@@ -356,7 +417,6 @@ namespace Sass {
 
   Compound_Selector* Compound_Selector::minus(Compound_Selector* rhs, Context& ctx)
   {
-    To_String to_string;
     Compound_Selector* result = new (ctx.mem) Compound_Selector(path(), position());
 
     // not very efficient because it needs to preserve order
@@ -365,7 +425,7 @@ namespace Sass {
       bool found = false;
       for (size_t j = 0, M = rhs->length(); j < M; ++j)
       {
-        if ((*this)[i]->perform(&to_string) == (*rhs)[j]->perform(&to_string))
+        if (*(*this)[i] == *(*rhs)[j])
         {
           found = true;
           break;
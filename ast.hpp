@@ -45,7 +45,9 @@
 #include "sass.h"
 #endif
 
+#ifndef SASS_UNITS
 #include "units.hpp"
+#endif
 
 #ifndef SASS_ERROR_HANDLING
 #include "error_handling.hpp"
@@ -106,10 +108,10 @@ namespace Sass {
   class Expression;
   class Selector;
   class AST_Node {
-    ADD_PROPERTY(string, path);
+    ADD_PROPERTY(const char*, path);
     ADD_PROPERTY(Position, position);
   public:
-    AST_Node(string path, Position position) : path_(path), position_(position) { }
+    AST_Node(const char* path, Position position) : path_(path), position_(position) { }
     virtual ~AST_Node() = 0;
     // virtual Block* block() { return 0; }
     ATTACH_OPERATIONS();
@@ -123,7 +125,7 @@ namespace Sass {
   /////////////////////////////////////////////////////////////////////////
   class Statement : public AST_Node {
   public:
-    Statement(string path, Position position) : AST_Node(path, position) { }
+    Statement(const char* path, Position position) : AST_Node(path, position) { }
     virtual ~Statement() = 0;
     // needed for rearranging nested rulesets during CSS emission
     virtual bool   is_hoistable() { return false; }
@@ -146,7 +148,7 @@ namespace Sass {
       else                   has_non_hoistable_ = true;
     };
   public:
-    Block(string path, Position position, size_t s = 0, bool r = false)
+    Block(const char* path, Position position, size_t s = 0, bool r = false)
     : Statement(path, position),
       Vectorized<Statement*>(s),
       is_root_(r), has_hoistable_(false), has_non_hoistable_(false)
@@ -161,7 +163,7 @@ namespace Sass {
   class Has_Block : public Statement {
     ADD_PROPERTY(Block*, block);
   public:
-    Has_Block(string path, Position position, Block* b)
+    Has_Block(const char* path, Position position, Block* b)
     : Statement(path, position), block_(b)
     { }
     virtual ~Has_Block() = 0;
@@ -176,7 +178,7 @@ namespace Sass {
   class Ruleset : public Has_Block {
     ADD_PROPERTY(Selector*, selector);
   public:
-    Ruleset(string path, Position position, Selector* s, Block* b)
+    Ruleset(const char* path, Position position, Selector* s, Block* b)
     : Has_Block(path, position, b), selector_(s)
     { }
     // nested rulesets need to be hoisted out of their enclosing blocks
@@ -191,7 +193,7 @@ namespace Sass {
   class Propset : public Has_Block {
     ADD_PROPERTY(String*, property_fragment);
   public:
-    Propset(string path, Position position, String* pf, Block* b = 0)
+    Propset(const char* path, Position position, String* pf, Block* b = 0)
     : Has_Block(path, position, b), property_fragment_(pf)
     { }
     ATTACH_OPERATIONS();
@@ -205,7 +207,7 @@ namespace Sass {
     ADD_PROPERTY(List*, media_queries);
     ADD_PROPERTY(Selector*, enclosing_selector);
   public:
-    Media_Block(string path, Position position, List* mqs, Block* b)
+    Media_Block(const char* path, Position position, List* mqs, Block* b)
     : Has_Block(path, position, b), media_queries_(mqs), enclosing_selector_(0)
     { }
     bool is_hoistable() { return true; }
@@ -221,7 +223,7 @@ namespace Sass {
     ADD_PROPERTY(Selector*, selector);
     ADD_PROPERTY(Expression*, value);
   public:
-    At_Rule(string path, Position position, string kwd, Selector* sel = 0, Block* b = 0)
+    At_Rule(const char* path, Position position, string kwd, Selector* sel = 0, Block* b = 0)
     : Has_Block(path, position, b), keyword_(kwd), selector_(sel), value_(0) // set value manually if needed
     { }
     ATTACH_OPERATIONS();
@@ -235,7 +237,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, value);
     ADD_PROPERTY(bool, is_important);
   public:
-    Declaration(string path, Position position,
+    Declaration(const char* path, Position position,
                 String* prop, Expression* val, bool i = false)
     : Statement(path, position), property_(prop), value_(val), is_important_(i)
     { }
@@ -253,7 +255,7 @@ namespace Sass {
     ADD_PROPERTY(bool, is_guarded);
     ADD_PROPERTY(bool, is_global);
   public:
-    Assignment(string path, Position position,
+    Assignment(const char* path, Position position,
                string var, Expression* val,
                bool guarded = false,
                bool global = false)
@@ -270,7 +272,7 @@ namespace Sass {
     vector<string>         files_;
     vector<Expression*> urls_;
   public:
-    Import(string path, Position position)
+    Import(const char* path, Position position)
     : Statement(path, position),
       files_(vector<string>()), urls_(vector<Expression*>())
     { }
@@ -282,7 +284,7 @@ namespace Sass {
   class Import_Stub : public Statement {
     ADD_PROPERTY(string, file_name);
   public:
-    Import_Stub(string path, Position position, string f)
+    Import_Stub(const char* path, Position position, string f)
     : Statement(path, position), file_name_(f)
     { }
     ATTACH_OPERATIONS();
@@ -294,7 +296,7 @@ namespace Sass {
   class Warning : public Statement {
     ADD_PROPERTY(Expression*, message);
   public:
-    Warning(string path, Position position, Expression* msg)
+    Warning(const char* path, Position position, Expression* msg)
     : Statement(path, position), message_(msg)
     { }
     ATTACH_OPERATIONS();
@@ -306,7 +308,7 @@ namespace Sass {
   class Comment : public Statement {
     ADD_PROPERTY(String*, text);
   public:
-    Comment(string path, Position position, String* txt)
+    Comment(const char* path, Position position, String* txt)
     : Statement(path, position), text_(txt)
     { }
     ATTACH_OPERATIONS();
@@ -320,7 +322,7 @@ namespace Sass {
     ADD_PROPERTY(Block*, consequent);
     ADD_PROPERTY(Block*, alternative);
   public:
-    If(string path, Position position, Expression* pred, Block* con, Block* alt = 0)
+    If(const char* path, Position position, Expression* pred, Block* con, Block* alt = 0)
     : Statement(path, position), predicate_(pred), consequent_(con), alternative_(alt)
     { }
     ATTACH_OPERATIONS();
@@ -335,7 +337,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, upper_bound);
     ADD_PROPERTY(bool, is_inclusive);
   public:
-    For(string path, Position position,
+    For(const char* path, Position position,
         string var, Expression* lo, Expression* hi, Block* b, bool inc)
     : Has_Block(path, position, b),
       variable_(var), lower_bound_(lo), upper_bound_(hi), is_inclusive_(inc)
@@ -350,7 +352,7 @@ namespace Sass {
     ADD_PROPERTY(string, variable);
     ADD_PROPERTY(Expression*, list);
   public:
-    Each(string path, Position position, string var, Expression* lst, Block* b)
+    Each(const char* path, Position position, string var, Expression* lst, Block* b)
     : Has_Block(path, position, b), variable_(var), list_(lst)
     { }
     ATTACH_OPERATIONS();
@@ -362,7 +364,7 @@ namespace Sass {
   class While : public Has_Block {
     ADD_PROPERTY(Expression*, predicate);
   public:
-    While(string path, Position position, Expression* pred, Block* b)
+    While(const char* path, Position position, Expression* pred, Block* b)
     : Has_Block(path, position, b), predicate_(pred)
     { }
     ATTACH_OPERATIONS();
@@ -374,7 +376,7 @@ namespace Sass {
   class Return : public Statement {
     ADD_PROPERTY(Expression*, value);
   public:
-    Return(string path, Position position, Expression* val)
+    Return(const char* path, Position position, Expression* val)
     : Statement(path, position), value_(val)
     { }
     ATTACH_OPERATIONS();
@@ -386,7 +388,7 @@ namespace Sass {
   class Extension : public Statement {
     ADD_PROPERTY(Selector*, selector);
   public:
-    Extension(string path, Position position, Selector* s)
+    Extension(const char* path, Position position, Selector* s)
     : Statement(path, position), selector_(s)
     { }
     ATTACH_OPERATIONS();
@@ -401,7 +403,7 @@ namespace Sass {
   class Parameters;
   typedef Environment<AST_Node*> Env;
   typedef const char* Signature;
-  typedef Expression* (*Native_Function)(Env&, Env&, Context&, Signature, const string&, Position, Backtrace*);
+  typedef Expression* (*Native_Function)(Env&, Env&, Context&, Signature, const char*, Position, Backtrace*);
   typedef const char* Signature;
   class Definition : public Has_Block {
   public:
@@ -416,7 +418,7 @@ namespace Sass {
     ADD_PROPERTY(bool, is_overload_stub);
     ADD_PROPERTY(Signature, signature);
   public:
-    Definition(string path,
+    Definition(const char* path,
                Position position,
                string n,
                Parameters* params,
@@ -433,7 +435,7 @@ namespace Sass {
       is_overload_stub_(false),
       signature_(0)
     { }
-    Definition(string path,
+    Definition(const char* path,
                Position position,
                Signature sig,
                string n,
@@ -451,7 +453,7 @@ namespace Sass {
       is_overload_stub_(overload_stub),
       signature_(sig)
     { }
-    Definition(string path,
+    Definition(const char* path,
                Position position,
                Signature sig,
                string n,
@@ -482,7 +484,7 @@ namespace Sass {
     ADD_PROPERTY(string, name);
     ADD_PROPERTY(Arguments*, arguments);
   public:
-    Mixin_Call(string path, Position position, string n, Arguments* args, Block* b = 0)
+    Mixin_Call(const char* path, Position position, string n, Arguments* args, Block* b = 0)
     : Has_Block(path, position, b), name_(n), arguments_(args)
     { }
     ATTACH_OPERATIONS();
@@ -493,7 +495,7 @@ namespace Sass {
   ///////////////////////////////////////////////////
   class Content : public Statement {
   public:
-    Content(string path, Position position) : Statement(path, position) { }
+    Content(const char* path, Position position) : Statement(path, position) { }
     ATTACH_OPERATIONS();
   };
 
@@ -520,7 +522,7 @@ namespace Sass {
     ADD_PROPERTY(bool, is_interpolant);
     ADD_PROPERTY(Concrete_Type, concrete_type);
   public:
-    Expression(string path, Position position,
+    Expression(const char* path, Position position,
                bool d = false, bool i = false, Concrete_Type ct = NONE)
     : AST_Node(path, position),
       is_delayed_(d), is_interpolant_(i), concrete_type_(ct)
@@ -545,7 +547,7 @@ namespace Sass {
     ADD_PROPERTY(Separator, separator);
     ADD_PROPERTY(bool, is_arglist);
   public:
-    List(string path, Position position,
+    List(const char* path, Position position,
          size_t size = 0, Separator sep = SPACE, bool argl = false)
     : Expression(path, position),
       Vectorized<Expression*>(size),
@@ -576,7 +578,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, left);
     ADD_PROPERTY(Expression*, right);
   public:
-    Binary_Expression(string path, Position position,
+    Binary_Expression(const char* path, Position position,
                       Type t, Expression* lhs, Expression* rhs)
     : Expression(path, position), type_(t), left_(lhs), right_(rhs)
     { }
@@ -593,7 +595,7 @@ namespace Sass {
     ADD_PROPERTY(Type, type);
     ADD_PROPERTY(Expression*, operand);
   public:
-    Unary_Expression(string path, Position position, Type t, Expression* o)
+    Unary_Expression(const char* path, Position position, Type t, Expression* o)
     : Expression(path, position), type_(t), operand_(o)
     { }
     ATTACH_OPERATIONS();
@@ -607,10 +609,10 @@ namespace Sass {
     ADD_PROPERTY(Arguments*, arguments);
     ADD_PROPERTY(void*, cookie);
   public:
-    Function_Call(string path, Position position, string n, Arguments* args, void* cookie)
+    Function_Call(const char* path, Position position, string n, Arguments* args, void* cookie)
     : Expression(path, position), name_(n), arguments_(args), cookie_(cookie)
     { concrete_type(STRING); }
-    Function_Call(string path, Position position, string n, Arguments* args)
+    Function_Call(const char* path, Position position, string n, Arguments* args)
     : Expression(path, position), name_(n), arguments_(args), cookie_(0)
     { concrete_type(STRING); }
     ATTACH_OPERATIONS();
@@ -623,7 +625,7 @@ namespace Sass {
     ADD_PROPERTY(String*, name);
     ADD_PROPERTY(Arguments*, arguments);
   public:
-    Function_Call_Schema(string path, Position position, String* n, Arguments* args)
+    Function_Call_Schema(const char* path, Position position, String* n, Arguments* args)
     : Expression(path, position), name_(n), arguments_(args)
     { concrete_type(STRING); }
     ATTACH_OPERATIONS();
@@ -635,7 +637,7 @@ namespace Sass {
   class Variable : public Expression {
     ADD_PROPERTY(string, name);
   public:
-    Variable(string path, Position position, string n)
+    Variable(const char* path, Position position, string n)
     : Expression(path, position), name_(n)
     { }
     ATTACH_OPERATIONS();
@@ -652,7 +654,7 @@ namespace Sass {
     ADD_PROPERTY(Type, type);
     ADD_PROPERTY(string, value);
   public:
-    Textual(string path, Position position, Type t, string val)
+    Textual(const char* path, Position position, Type t, string val)
     : Expression(path, position, true), type_(t), value_(val)
     { }
     ATTACH_OPERATIONS();
@@ -663,113 +665,30 @@ namespace Sass {
   ////////////////////////////////////////////////
   class Number : public Expression {
     ADD_PROPERTY(double, value);
-    vector<string> numerator_units_;
-    vector<string> denominator_units_;
+    Units units_;
   public:
-    Number(string path, Position position, double val, string u = "")
+    Number(const char* path, Position position, double val, string u = "")
     : Expression(path, position),
       value_(val),
-      numerator_units_(vector<string>()),
-      denominator_units_(vector<string>())
-    {
-      if (!u.empty()) numerator_units_.push_back(u);
-      concrete_type(NUMBER);
-    }
-    vector<string>& numerator_units()   { return numerator_units_; }
-    vector<string>& denominator_units() { return denominator_units_; }
+      units_(intern_unit(u))
+    { concrete_type(NUMBER); }
+    Number(const char* path, Position position, double val, Unit u)
+    : Expression(path, position),
+      value_(val),
+      units_(u)
+    { concrete_type(NUMBER); }
+    Units& units() { return units_; }
     string type() { return "number"; }
     static string type_name() { return "number"; }
     string unit()
-    {
-      stringstream u;
-      for (size_t i = 0, S = numerator_units_.size(); i < S; ++i) {
-        if (i) u << '*';
-        u << numerator_units_[i];
-      }
-      if (!denominator_units_.empty()) u << '/';
-      for (size_t i = 0, S = denominator_units_.size(); i < S; ++i) {
-        if (i) u << '*';
-        u << denominator_units_[i];
-      }
-      return u.str();
-    }
+    { return units_.to_string(); }
     bool is_unitless()
-    { return numerator_units_.empty() && denominator_units_.empty(); }
-    void normalize(string to = "")
-    {
-      // (multiple passes because I'm too tired to think up something clever)
-      // Find a unit to convert everything to, if one isn't provided.
-      if (to.empty()) {
-        for (size_t i = 0, S = numerator_units_.size(); i < S; ++i) {
-          string u(numerator_units_[i]);
-          if (string_to_unit(u) == INCOMMENSURABLE) {
-            continue;
-          }
-          else {
-            to = u;
-            break;
-          }
-        }
-      }
-      if (to.empty()) {
-        for (size_t i = 0, S = denominator_units_.size(); i < S; ++i) {
-          string u(denominator_units_[i]);
-          if (string_to_unit(u) == INCOMMENSURABLE) {
-            continue;
-          }
-          else {
-            to = u;
-            break;
-          }
-        }
-      }
-      // Now loop through again and do all the conversions.
-      for (size_t i = 0, S = numerator_units_.size(); i < S; ++i) {
-        string from(numerator_units_[i]);
-        if (string_to_unit(from) == INCOMMENSURABLE) continue;
-        value_ *= conversion_factor(from, to);
-        numerator_units_[i] = to;
-      }
-      for (size_t i = 0, S = denominator_units_.size(); i < S; ++i) {
-        string from(denominator_units_[i]);
-        if (string_to_unit(from) == INCOMMENSURABLE) continue;
-        value_ /= conversion_factor(from, to);
-        denominator_units_[i] = to;
-      }
-      // Now divide out identical units in the numerator and denominator.
-      vector<string> ncopy;
-      ncopy.reserve(numerator_units_.size());
-      for (vector<string>::iterator n = numerator_units_.begin();
-           n != numerator_units_.end();
-           ++n) {
-        vector<string>::iterator d = find(denominator_units_.begin(),
-                                          denominator_units_.end(),
-                                          *n);
-        if (d != denominator_units_.end()) {
-          denominator_units_.erase(d);
-        }
-        else {
-          ncopy.push_back(*n);
-        }
-      }
-      numerator_units_ = ncopy;
-      // Sort the units to make them pretty and, well, normal.
-      sort(numerator_units_.begin(), numerator_units_.end());
-      sort(denominator_units_.begin(), denominator_units_.end());
-    }
+    { return units_.empty(); }
+    void normalize(Unit to = UNITLESS)
+    { value_ = units_.normalize(value_, to); }
     // useful for making one number compatible with another
-    string find_convertible_unit()
-    {
-      for (size_t i = 0, S = numerator_units_.size(); i < S; ++i) {
-        string u(numerator_units_[i]);
-        if (string_to_unit(u) != INCOMMENSURABLE) return u;
-      }
-      for (size_t i = 0, S = denominator_units_.size(); i < S; ++i) {
-        string u(denominator_units_[i]);
-        if (string_to_unit(u) != INCOMMENSURABLE) return u;
-      }
-      return string();
-    }
+    Unit find_convertible_unit()
+    { return units_.convertible(); }
     ATTACH_OPERATIONS();
   };
 
@@ -783,7 +702,7 @@ namespace Sass {
     ADD_PROPERTY(double, a);
     ADD_PROPERTY(string, disp);
   public:
-    Color(string path, Position position, double r, double g, double b, double a = 1, const string disp = "")
+    Color(const char* path, Position position, double r, double g, double b, double a = 1, const string disp = "")
     : Expression(path, position), r_(r), g_(g), b_(b), a_(a), disp_(disp)
     { concrete_type(COLOR); }
     string type() { return "color"; }
@@ -797,7 +716,7 @@ namespace Sass {
   class Boolean : public Expression {
     ADD_PROPERTY(bool, value);
   public:
-    Boolean(string path, Position position, bool val) : Expression(path, position), value_(val)
+    Boolean(const char* path, Position position, bool val) : Expression(path, position), value_(val)
     { concrete_type(BOOLEAN); }
     virtual operator bool() { return value_; }
     string type() { return "bool"; }
@@ -813,7 +732,7 @@ namespace Sass {
   class String : public Expression {
     ADD_PROPERTY(bool, needs_unquoting);
   public:
-    String(string path, Position position, bool unq = false, bool delayed = false)
+    String(const char* path, Position position, bool unq = false, bool delayed = false)
     : Expression(path, position, delayed), needs_unquoting_(unq)
     { concrete_type(STRING); }
     static string type_name() { return "string"; }
@@ -829,7 +748,7 @@ namespace Sass {
   class String_Schema : public String, public Vectorized<Expression*> {
     ADD_PROPERTY(char, quote_mark);
   public:
-    String_Schema(string path, Position position, size_t size = 0, bool unq = false, char qm = '\0')
+    String_Schema(const char* path, Position position, size_t size = 0, bool unq = false, char qm = '\0')
     : String(path, position, unq), Vectorized<Expression*>(size), quote_mark_(qm)
     { }
     string type() { return "string"; }
@@ -843,16 +762,16 @@ namespace Sass {
   class String_Constant : public String {
     ADD_PROPERTY(string, value);
   public:
-    String_Constant(string path, Position position, string val, bool unq = false)
+    String_Constant(const char* path, Position position, string val, bool unq = false)
     : String(path, position, unq, true), value_(val)
     { }
-    String_Constant(string path, Position position, const char* beg, bool unq = false)
+    String_Constant(const char* path, Position position, const char* beg, bool unq = false)
     : String(path, position, unq, true), value_(string(beg))
     { }
-    String_Constant(string path, Position position, const char* beg, const char* end, bool unq = false)
+    String_Constant(const char* path, Position position, const char* beg, const char* end, bool unq = false)
     : String(path, position, unq, true), value_(string(beg, end-beg))
     { }
-    String_Constant(string path, Position position, const Token& tok, bool unq = false)
+    String_Constant(const char* path, Position position, const Token& tok, bool unq = false)
     : String(path, position, unq, true), value_(string(tok.begin, tok.end))
     { }
     string type() { return "string"; }
@@ -871,7 +790,7 @@ namespace Sass {
     ADD_PROPERTY(bool, is_negated);
     ADD_PROPERTY(bool, is_restricted);
   public:
-    Media_Query(string path, Position position,
+    Media_Query(const char* path, Position position,
                 String* t = 0, size_t s = 0, bool n = false, bool r = false)
     : Expression(path, position), Vectorized<Media_Query_Expression*>(s),
       media_type_(t), is_negated_(n), is_restricted_(r)
@@ -887,7 +806,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, value);
     ADD_PROPERTY(bool, is_interpolated);
   public:
-    Media_Query_Expression(string path, Position position,
+    Media_Query_Expression(const char* path, Position position,
                            Expression* f, Expression* v, bool i = false)
     : Expression(path, position), feature_(f), value_(v), is_interpolated_(i)
     { }
@@ -899,7 +818,7 @@ namespace Sass {
   //////////////////
   class Null : public Expression {
   public:
-    Null(string path, Position position) : Expression(path, position) { concrete_type(NULL_VAL); }
+    Null(const char* path, Position position) : Expression(path, position) { concrete_type(NULL_VAL); }
     string type() { return "null"; }
     static string type_name() { return "null"; }
     bool is_invisible() { return true; }
@@ -915,7 +834,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, expression);
     ADD_PROPERTY(Env*, environment);
   public:
-    Thunk(string path, Position position, Expression* exp, Env* env = 0)
+    Thunk(const char* path, Position position, Expression* exp, Env* env = 0)
     : Expression(path, position), expression_(exp), environment_(env)
     { }
   };
@@ -928,7 +847,7 @@ namespace Sass {
     ADD_PROPERTY(Expression*, default_value);
     ADD_PROPERTY(bool, is_rest_parameter);
   public:
-    Parameter(string p, Position pos,
+    Parameter(const char* p, Position pos,
               string n, Expression* def = 0, bool rest = false)
     : AST_Node(p, pos), name_(n), default_value_(def), is_rest_parameter_(rest)
     {
@@ -975,7 +894,7 @@ namespace Sass {
       }
     }
   public:
-    Parameters(string path, Position position)
+    Parameters(const char* path, Position position)
     : AST_Node(path, position),
       Vectorized<Parameter*>(),
       has_optional_parameters_(false),
@@ -992,7 +911,7 @@ namespace Sass {
     ADD_PROPERTY(string, name);
     ADD_PROPERTY(bool, is_rest_argument);
   public:
-    Argument(string p, Position pos, Expression* val, string n = "", bool rest = false)
+    Argument(const char* p, Position pos, Expression* val, string n = "", bool rest = false)
     : Expression(p, pos), value_(val), name_(n), is_rest_argument_(rest)
     {
       if (!name_.empty() && is_rest_argument_) {
@@ -1043,7 +962,7 @@ namespace Sass {
       }
     }
   public:
-    Arguments(string path, Position position)
+    Arguments(const char* path, Position position)
     : Expression(path, position),
       Vectorized<Argument*>(),
       has_named_arguments_(false),
@@ -1059,7 +978,7 @@ namespace Sass {
     ADD_PROPERTY(bool, has_reference);
     ADD_PROPERTY(bool, has_placeholder);
   public:
-    Selector(string path, Position position, bool r = false, bool h = false)
+    Selector(const char* path, Position position, bool r = false, bool h = false)
     : AST_Node(path, position), has_reference_(r), has_placeholder_(h)
     { }
     virtual ~Selector() = 0;
@@ -1075,7 +994,7 @@ namespace Sass {
   class Selector_Schema : public Selector {
     ADD_PROPERTY(String*, contents);
   public:
-    Selector_Schema(string path, Position position, String* c)
+    Selector_Schema(const char* path, Position position, String* c)
     : Selector(path, position), contents_(c)
     { }
     ATTACH_OPERATIONS();
@@ -1086,22 +1005,34 @@ namespace Sass {
   ////////////////////////////////////////////
   class Simple_Selector : public Selector {
   public:
-    Simple_Selector(string path, Position position)
+    Simple_Selector(const char* path, Position position)
     : Selector(path, position)
     { }
     virtual ~Simple_Selector() = 0;
     virtual Compound_Selector* unify_with(Compound_Selector*, Context&);
     virtual bool is_pseudo_element() { return false; }
+    // Structural identity: equal iff both print the same. Selectors that are
+    // just a name compare it directly; the rest compare their printed form.
+    virtual const string* name_key() const { return 0; }
+    int compare(const Simple_Selector& rhs) const;
+    size_t hash() const;
+    bool operator==(const Simple_Selector& rhs) const { return compare(rhs) == 0; }
+    bool operator<(const Simple_Selector& rhs) const  { return compare(rhs) < 0; }
   };
   inline Simple_Selector::~Simple_Selector() { }
 
+  struct Simple_Selector_Less {
+    bool operator()(const Simple_Selector* l, const Simple_Selector* r) const
+    { return *l < *r; }
+  };
+
   /////////////////////////////////////
   // Parent references (i.e., the "&").
   /////////////////////////////////////
   class Selector_Reference : public Simple_Selector {
     ADD_PROPERTY(Selector*, selector);
   public:
-    Selector_Reference(string path, Position position, Selector* r = 0)
+    Selector_Reference(const char* path, Position position, Selector* r = 0)
     : Simple_Selector(path, position), selector_(r)
     { has_reference(true); }
     virtual int specificity()
@@ -1118,10 +1049,11 @@ namespace Sass {
   class Selector_Placeholder : public Simple_Selector {
     ADD_PROPERTY(string, name);
   public:
-    Selector_Placeholder(string path, Position position, string n)
+    Selector_Placeholder(const char* path, Position position, string n)
     : Simple_Selector(path, position), name_(n)
     { has_placeholder(true); }
     virtual Selector_Placeholder* find_placeholder();
+    virtual const string* name_key() const { return &name_; }
     ATTACH_OPERATIONS();
   };
 
@@ -1131,7 +1063,7 @@ namespace Sass {
   class Type_Selector : public Simple_Selector {
     ADD_PROPERTY(string, name);
   public:
-    Type_Selector(string path, Position position, string n)
+    Type_Selector(const char* path, Position position, string n)
     : Simple_Selector(path, position), name_(n)
     { }
     virtual int specificity()
@@ -1140,6 +1072,7 @@ namespace Sass {
       else               return 1;
     }
     virtual Compound_Selector* unify_with(Compound_Selector*, Context&);
+    virtual const string* name_key() const { return &name_; }
     ATTACH_OPERATIONS();
   };
 
@@ -1149,7 +1082,7 @@ namespace Sass {
   class Selector_Qualifier : public Simple_Selector {
     ADD_PROPERTY(string, name);
   public:
-    Selector_Qualifier(string path, Position position, string n)
+    Selector_Qualifier(const char* path, Position position, string n)
     : Simple_Selector(path, position), name_(n)
     { }
     virtual int specificity()
@@ -1158,6 +1091,7 @@ namespace Sass {
       else                  return Constants::SPECIFICITY_BASE;
     }
     virtual Compound_Selector* unify_with(Compound_Selector*, Context&);
+    virtual const string* name_key() const { return &name_; }
     ATTACH_OPERATIONS();
   };
 
@@ -1169,7 +1103,7 @@ namespace Sass {
     ADD_PROPERTY(string, matcher);
     ADD_PROPERTY(String*, value); // might be interpolated
   public:
-    Attribute_Selector(string path, Position position, string n, string m, String* v)
+    Attribute_Selector(const char* path, Position position, string n, string m, String* v)
     : Simple_Selector(path, position), name_(n), matcher_(m), value_(v)
     { }
     ATTACH_OPERATIONS();
@@ -1182,7 +1116,7 @@ namespace Sass {
     ADD_PROPERTY(string, name);
     ADD_PROPERTY(String*, expression);
   public:
-    Pseudo_Selector(string path, Position position, string n, String* expr = 0)
+    Pseudo_Selector(const char* path, Position position, string n, String* expr = 0)
     : Simple_Selector(path, position), name_(n), expression_(expr)
     { }
     virtual int specificity()
@@ -1214,7 +1148,7 @@ namespace Sass {
     ADD_PROPERTY(string, name);
     ADD_PROPERTY(Selector*, selector);
   public:
-    Wrapped_Selector(string path, Position position, string n, Selector* sel)
+    Wrapped_Selector(const char* path, Position position, string n, Selector* sel)
     : Simple_Selector(path, position), name_(n), selector_(sel)
     { }
     ATTACH_OPERATIONS();
@@ -1227,17 +1161,23 @@ namespace Sass {
   class Compound_Selector : public Selector, public Vectorized<Simple_Selector*> {
   private:
     set<Complex_Selector> sources_;
+    mutable size_t hash_; // cached structural hash; 0 until computed
   protected:
     void adjust_after_pushing(Simple_Selector* s)
     {
       if (s->has_reference())   has_reference(true);
       if (s->has_placeholder()) has_placeholder(true);
+      hash_ = 0;
     }
   public:
-    Compound_Selector(string path, Position position, size_t s = 0)
+    Compound_Selector(const char* path, Position position, size_t s = 0)
     : Selector(path, position),
-      Vectorized<Simple_Selector*>(s)
+      Vectorized<Simple_Selector*>(s),
+      hash_(0)
     { }
+    size_t hash() const;
+    int compare(const Compound_Selector& rhs) const;
+    bool operator==(const Compound_Selector& rhs) const;
     bool operator<(const Compound_Selector& rhs) const;
     Compound_Selector* unify_with(Compound_Selector* rhs, Context& ctx);
     virtual Selector_Placeholder* find_placeholder();
@@ -1282,7 +1222,7 @@ namespace Sass {
     ADD_PROPERTY(Compound_Selector*, head);
     ADD_PROPERTY(Complex_Selector*, tail);
   public:
-    Complex_Selector(string path, Position position,
+    Complex_Selector(const char* path, Position position,
                          Combinator c,
                          Compound_Selector* h,
                          Complex_Selector* t)
@@ -1307,7 +1247,10 @@ namespace Sass {
       if (tail()) sum += tail()->specificity();
       return sum;
     }
-    bool operator<(const Complex_Selector& rhs) const;
+    size_t hash() const;
+    int compare(const Complex_Selector& rhs) const;
+    bool operator==(const Complex_Selector& rhs) const { return compare(rhs) == 0; }
+    bool operator<(const Complex_Selector& rhs) const  { return compare(rhs) < 0; }
     set<Complex_Selector> sources()
     {
       set<Complex_Selector> srcs;
@@ -1345,7 +1288,7 @@ namespace Sass {
       if (c->has_placeholder()) has_placeholder(true);
     }
   public:
-    Selector_List(string path, Position position, size_t s = 0)
+    Selector_List(const char* path, Position position, size_t s = 0)
     : Selector(path, position), Vectorized<Complex_Selector*>(s)
     { }
     virtual Selector_Placeholder* find_placeholder();
@@ -12,12 +12,12 @@ namespace Sass {
 
   struct Backtrace {
 
-    Backtrace* parent;
-    string     path;
-    Position   position;
-    string     caller;
+    Backtrace*  parent;
+    const char* path;
+    Position    position;
+    string      caller;
 
-    Backtrace(Backtrace* prn, string pth, Position position, string c)
+    Backtrace(Backtrace* prn, const char* pth, Position position, string c)
     : parent(prn),
       path(pth),
       position(position),
@@ -0,0 +1,556 @@
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
+
+#ifndef SASS_BYTECODE
+#include "bytecode.hpp"
+#endif
+
+#ifndef SASS_AST
+#include "ast.hpp"
+#endif
+
+#ifndef SASS_OPERATION
+#include "operation.hpp"
+#endif
+
+#ifndef SASS_FUNCTION_MEMO
+#include "function_memo.hpp"
+#endif
+
+#include "eval.hpp"
+#include "context.hpp"
+#include "color_names.hpp"
+#include "prelexer.hpp"
+
+namespace Sass {
+
+  // Turns a function body into a Bytecode::Function, or finds a statement
+  // it can't and says so.
+  class Bytecode_Compiler : public Operation_CRTP<void, Bytecode_Compiler> {
+    typedef Bytecode::Instruction Instruction;
+
+    Env*                 env;
+    Context&             ctx;
+    Bytecode::Function&  f;
+    map<string, size_t>  slot_of;
+    vector<size_t>       open_scopes;
+    vector<size_t>       free_loads; // LOAD_FREEs of names that may get a slot later
+
+    size_t emit(Bytecode::Opcode op, AST_Node* node = 0, size_t arg = 0, double number = 0)
+    {
+      Instruction in = { op, arg, number, node };
+      f.code.push_back(in);
+      return f.code.size() - 1;
+    }
+
+    void patch(size_t at) { f.code[at].arg = f.code.size(); }
+
+    size_t slot(const string& name)
+    {
+      map<string, size_t>::iterator s = slot_of.find(name);
+      if (s != slot_of.end()) return s->second;
+      f.slots.push_back(name);
+      return slot_of[name] = f.slots.size() - 1;
+    }
+
+    void add_once(vector<size_t>& v, size_t x)
+    { if (find(v.begin(), v.end(), x) == v.end()) v.push_back(x); }
+
+  public:
+    bool compiled;
+
+    Bytecode_Compiler(Env* env, Context& ctx, Bytecode::Function& f)
+    : env(env), ctx(ctx), f(f), slot_of(map<string, size_t>()), open_scopes(vector<size_t>()),
+      free_loads(vector<size_t>()), compiled(true)
+    { }
+    using Operation<void>::operator();
+
+    void definition(Definition* def)
+    {
+      Parameters* params = def->parameters();
+      for (size_t i = 0, L = params ? params->length() : 0; i < L; ++i) slot((*params)[i]->name());
+      f.parameters = f.slots.size();
+      def->block()->perform(this);
+      for (size_t i = 0, S = free_loads.size(); i < S; ++i) {
+        Instruction& in = f.code[free_loads[i]];
+        map<string, size_t>::iterator s = slot_of.find(static_cast<Variable*>(in.node)->name());
+        if (s != slot_of.end()) {
+          in.op = Bytecode::LOAD;
+          in.arg = s->second;
+        }
+      }
+    }
+
+    // statements
+
+    void operator()(Block* b)
+    { for (size_t i = 0, L = b->length(); i < L && compiled; ++i) (*b)[i]->perform(this); }
+
+    void operator()(Assignment* a)
+    {
+      // !default looks at the innermost frame only, which slots don't keep
+      if (a->is_guarded()) {
+        compiled = false;
+        return;
+      }
+      a->value()->perform(this);
+      size_t s = slot(a->variable());
+      emit(Bytecode::STORE, 0, s);
+      if (s >= f.parameters) add_once(f.assigned, s);
+      for (size_t i = 0, S = open_scopes.size(); i < S; ++i) add_once(f.scopes[open_scopes[i]].assigned, s);
+    }
+
+    void operator()(If* i)
+    {
+      i->predicate()->perform(this);
+      size_t to_alternative = emit(Bytecode::JUMP_UNLESS);
+      i->consequent()->perform(this);
+      if (i->alternative()) {
+        size_t to_end = emit(Bytecode::JUMP);
+        patch(to_alternative);
+        i->alternative()->perform(this);
+        patch(to_end);
+      }
+      else {
+        patch(to_alternative);
+      }
+    }
+
+    void loop(Bytecode::Opcode op, AST_Node* node, const string& variable, Block* body)
+    {
+      Bytecode::Scope scope;
+      scope.variable = slot(variable);
+      f.scopes.push_back(scope);
+      size_t s = f.scopes.size() - 1;
+      emit(op, node, s);
+      size_t next = emit(Bytecode::NEXT);
+      open_scopes.push_back(s);
+      body->perform(this);
+      open_scopes.pop_back();
+      emit(Bytecode::JUMP, 0, next);
+      patch(next);
+      emit(Bytecode::END_LOOP);
+    }
+
+    void operator()(For* l)
+    {
+      l->lower_bound()->perform(this);
+      l->upper_bound()->perform(this);
+      loop(Bytecode::FOR, l, l->variable(), l->block());
+    }
+
+    void operator()(Each* e)
+    {
+      e->list()->perform(this);
+      loop(Bytecode::EACH, e, e->variable(), e->block());
+    }
+
+    void operator()(While* w)
+    {
+      size_t top = f.code.size();
+      w->predicate()->perform(this);
+      size_t to_end = emit(Bytecode::JUMP_UNLESS);
+      w->block()->perform(this);
+      emit(Bytecode::JUMP, 0, top);
+      patch(to_end);
+    }
+
+    void operator()(Return* r)
+    {
+      r->value()->perform(this);
+      emit(Bytecode::RETURN);
+    }
+
+    void operator()(Warning* w) { emit(Bytecode::EXEC_LOCAL, w); }
+
+    // expressions
+
+    void operator()(List* l)
+    {
+      for (size_t i = 0, L = l->length(); i < L; ++i) (*l)[i]->perform(this);
+      emit(Bytecode::LIST, l, l->length());
+    }
+
+    void operator()(Binary_Expression* b)
+    {
+      switch (b->type()) {
+        case Binary_Expression::AND:
+        case Binary_Expression::OR: {
+          b->left()->perform(this);
+          size_t to_end = emit(b->type() == Binary_Expression::AND ? Bytecode::AND : Bytecode::OR);
+          b->right()->perform(this);
+          patch(to_end);
+        } break;
+        case Binary_Expression::DIV:
+          // a '/' used as a separator stays as it is
+          if (b->is_delayed()) {
+            emit(Bytecode::PUSH, b);
+            break;
+          }
+        default:
+          b->left()->perform(this);
+          b->right()->perform(this);
+          emit(Bytecode::BINARY, b);
+          break;
+      }
+    }
+
+    void operator()(Unary_Expression* u)
+    {
+      u->operand()->perform(this);
+      emit(Bytecode::UNARY, u);
+    }
+
+    void operator()(Function_Call* c)
+    {
+      AST_Node** binding = env->lookup(c->name() + "[f]");
+      Definition* def = binding ? static_cast<Definition*>(*binding) : 0;
+      // unknown functions become strings, if() evaluates lazily and some
+      // built-ins look at the caller's variables; Eval knows about those
+      if (!def || c->name() == "if" ||
+          (!def->block() && !def->c_function() && !def->is_overload_stub() &&
+           !Function_Memo::is_pure(def->native_function()))) {
+        emit(Bytecode::EVAL_LOCAL, c);
+        return;
+      }
+      Arguments* args = c->arguments();
+      for (size_t i = 0, L = args->length(); i < L; ++i) {
+        // as Eval does when it first evaluates the argument
+        undelayed((*args)[i]->value(), ctx)->perform(this);
+      }
+      emit(Bytecode::CALL, c, args->length());
+    }
+
+    void operator()(Variable* v)
+    {
+      map<string, size_t>::iterator s = slot_of.find(v->name());
+      if (s != slot_of.end()) emit(Bytecode::LOAD, v, s->second);
+      else free_loads.push_back(emit(Bytecode::LOAD_FREE, v));
+    }
+
+    void operator()(Textual* t)
+    {
+      Unit unit;
+      switch (t->type()) {
+        case Textual::NUMBER:     unit = UNITLESS; break;
+        case Textual::PERCENTAGE: unit = PERCENT; break;
+        case Textual::DIMENSION:  unit = intern_unit(Token(Prelexer::number(t->value().c_str())).to_string()); break;
+        default:                  emit(Bytecode::EVAL, t); return;
+      }
+      emit(Bytecode::PUSH_NUMBER, t, unit, atof(t->value().c_str()));
+    }
+
+    void operator()(Number* n)
+    {
+      Value v = boxed(n);
+      double number;
+      Unit unit;
+      if (as_number(v, number, unit) && !n->is_delayed() && !n->is_interpolant()) emit(Bytecode::PUSH_NUMBER, n, unit, number);
+      else emit(Bytecode::PUSH, n);
+    }
+
+    void operator()(String_Constant* s)
+    {
+      // color names are made into new colors each time
+      if (!s->is_delayed() && name_to_color(s->value()) >= 0) emit(Bytecode::EVAL, s);
+      else emit(Bytecode::PUSH, s);
+    }
+
+    void operator()(Color* c)   { emit(Bytecode::PUSH, c); }
+    void operator()(Boolean* b) { emit(Bytecode::PUSH, b); }
+    void operator()(Null* n)    { emit(Bytecode::PUSH, n); }
+
+    template <typename U>
+    void fallback(U x)
+    {
+      if (dynamic_cast<Expression*>(x)) emit(Bytecode::EVAL_LOCAL, x);
+      else compiled = false;
+    }
+  };
+
+  Bytecode::Bytecode()
+  : functions(map<Definition*, Function*>()), stack(vector<Value>()),
+    loops(vector<Loop>()), created(vector<size_t>())
+  { }
+
+  Bytecode::Bytecode(const Bytecode&)
+  : functions(map<Definition*, Function*>()), stack(vector<Value>()),
+    loops(vector<Loop>()), created(vector<size_t>())
+  { }
+
+  Bytecode& Bytecode::operator=(const Bytecode& other)
+  {
+    if (this != &other) {
+      for (map<Definition*, Function*>::iterator f = functions.begin(); f != functions.end(); ++f) delete f->second;
+      functions.clear();
+    }
+    return *this;
+  }
+
+  Bytecode::~Bytecode()
+  {
+    for (map<Definition*, Function*>::iterator f = functions.begin(); f != functions.end(); ++f) delete f->second;
+  }
+
+  Bytecode::Function* Bytecode::compiled(Definition* def, Env& env, Context& ctx)
+  {
+    map<Definition*, Function*>::iterator found = functions.find(def);
+    Function* f = 0;
+    if (found != functions.end()) {
+      f = found->second;
+    }
+    else {
+      f = new Function();
+      Bytecode_Compiler compiler(def->environment(), ctx, *f);
+      compiler.definition(def);
+      if (!compiler.compiled) {
+        delete f;
+        f = 0;
+      }
+      functions[def] = f;
+    }
+    if (!f) return 0;
+    // an assignment to a variable from outside lands there
+    for (size_t i = 0, S = f->assigned.size(); i < S; ++i) {
+      if (env.lookup(f->slots[f->assigned[i]])) return 0;
+    }
+    return f;
+  }
+
+  // An environment in which Eval sees the call's variables as they are now.
+  Env* Bytecode::locals(Function* f, size_t base, Env& scratch, Context& ctx)
+  {
+    for (size_t i = 0, S = f->slots.size(); i < S; ++i) {
+      if (stack[base + i].tag != Value::UNSET) scratch[f->slots[i]] = box(stack[base + i], ctx);
+    }
+    return &scratch;
+  }
+
+  static Expression* unwrapped(AST_Node* binding)
+  {
+    Expression* value = static_cast<Expression*>(binding);
+    if (typeid(*value) == typeid(Argument)) value = static_cast<Argument*>(value)->value();
+    return value;
+  }
+
+  Expression* Bytecode::run(Function* f, Context& ctx, Eval& eval)
+  {
+    // leaves the shared stacks as they were, however the call ends
+    struct Unwind {
+      Bytecode& vm;
+      size_t stack, loops, created;
+      ~Unwind()
+      {
+        vm.stack.resize(stack);
+        vm.loops.resize(loops);
+        vm.created.resize(created);
+      }
+    } unwind = { *this, stack.size(), loops.size(), created.size() };
+
+    Env& env = *eval.env;
+    size_t base = stack.size();
+    Value unset = { Value::UNSET, 0, 0, 0, 0 };
+    stack.resize(base + f->slots.size(), unset);
+    for (size_t i = 0; i < f->parameters; ++i) {
+      AST_Node** binding = env.current_frame().find(f->slots[i], hash_key(f->slots[i]));
+      if (binding) {
+        stack[base + i] = boxed(unwrapped(*binding));
+      }
+    }
+
+    const Instruction* code = &f->code[0];
+    for (size_t pc = 0, S = f->code.size(); pc < S; ) {
+      const Instruction& in = code[pc++];
+      switch (in.op) {
+
+        case PUSH: {
+          stack.push_back(boxed(static_cast<Expression*>(in.node)));
+        } break;
+
+        case PUSH_NUMBER: {
+          stack.push_back(unboxed_number(in.number, in.arg, in.node->path(), in.node));
+        } break;
+
+        case EVAL: {
+          stack.push_back(boxed(in.node->perform(&eval)));
+        } break;
+
+        case EVAL_LOCAL:
+        case EXEC_LOCAL: {
+          Env scratch;
+          scratch.link(env);
+          eval.env = locals(f, base, scratch, ctx);
+          Expression* result = in.node->perform(&eval);
+          eval.env = &env;
+          if (in.op == EVAL_LOCAL) stack.push_back(boxed(result));
+        } break;
+
+        case LOAD:
+          if (stack[base + in.arg].tag != Value::UNSET) {
+            stack.push_back(stack[base + in.arg]);
+            break;
+          }
+          // not yet assigned, or a loop variable outside its loop
+        case LOAD_FREE: {
+          Variable* var = static_cast<Variable*>(in.node);
+          AST_Node** binding = env.lookup(var->name());
+          if (!binding) error("unbound variable " + var->name(), var->path(), var->position());
+          stack.push_back(boxed(unwrapped(*binding)));
+        } break;
+
+        case STORE: {
+          stack[base + in.arg] = stack.back();
+          stack.pop_back();
+        } break;
+
+        case BINARY: {
+          Binary_Expression* b = static_cast<Binary_Expression*>(in.node);
+          Value r = stack.back();
+          stack.pop_back();
+          Value& l = stack.back();
+          Value result;
+          if (op_unboxed(b, l, r, result)) l = result;
+          else l = boxed(op_binary(ctx, b, box(l, ctx), box(r, ctx)));
+        } break;
+
+        case UNARY: {
+          Unary_Expression* u = static_cast<Unary_Expression*>(in.node);
+          Value& operand = stack.back();
+          double n;
+          Unit unit;
+          if (as_number(operand, n, unit)) {
+            operand = unboxed_number(u->type() == Unary_Expression::MINUS ? -n : n, unit, operand.path, operand.node);
+          }
+          else {
+            operand = boxed(op_unary(ctx, u, box(operand, ctx)));
+          }
+        } break;
+
+        case AND:
+          if (!is_true(stack.back())) pc = in.arg;
+          else stack.pop_back();
+          break;
+
+        case OR:
+          if (is_true(stack.back())) pc = in.arg;
+          else stack.pop_back();
+          break;
+
+        case LIST: {
+          List* l = static_cast<List*>(in.node);
+          List* ll = new (ctx.mem) List(l->path(), l->position(), in.arg, l->separator(), l->is_arglist());
+          size_t first = stack.size() - in.arg;
+          for (size_t i = first, S = stack.size(); i < S; ++i) *ll << box(stack[i], ctx);
+          stack.resize(first);
+          stack.push_back(boxed(ll));
+        } break;
+
+        case CALL: {
+          Function_Call* c = static_cast<Function_Call*>(in.node);
+          Arguments* as = c->arguments();
+          Arguments* args = new (ctx.mem) Arguments(as->path(), as->position());
+          size_t first = stack.size() - in.arg;
+          for (size_t i = 0; i < in.arg; ++i) {
+            Argument* a = (*as)[i];
+            Expression* val = undelayed(box(stack[first + i], ctx), ctx);
+            if (a->is_rest_argument() && val->concrete_type() != Expression::LIST) {
+              List* wrapper = new (ctx.mem) List(val->path(), val->position(), 0, List::COMMA, true);
+              *wrapper << val;
+              val = wrapper;
+            }
+            *args << new (ctx.mem) Argument(a->path(), a->position(), val, a->name(), a->is_rest_argument());
+          }
+          stack.resize(first);
+          stack.push_back(boxed(eval.call(c, args)));
+        } break;
+
+        case JUMP:
+          pc = in.arg;
+          break;
+
+        case JUMP_UNLESS: {
+          bool condition = is_true(stack.back());
+          stack.pop_back();
+          if (!condition) pc = in.arg;
+        } break;
+
+        case FOR:
+        case EACH: {
+          const Scope& scope = f->scopes[in.arg];
+          Loop loop;
+          loop.scope = in.arg;
+          loop.saved = stack[base + scope.variable];
+          loop.unset = created.size();
+          loop.i = loop.end = 0;
+          loop.index = 0;
+          if (in.op == FOR) {
+            For* l = static_cast<For*>(in.node);
+            Value high = stack.back();
+            stack.pop_back();
+            Value low = stack.back();
+            stack.pop_back();
+            Expression* bounds[] = { box(low, ctx), box(high, ctx) };
+            if (bounds[0]->concrete_type() != Expression::NUMBER) {
+              error("lower bound of `@for` directive must be numeric", bounds[0]->path(), bounds[0]->position());
+            }
+            if (bounds[1]->concrete_type() != Expression::NUMBER) {
+              error("upper bound of `@for` directive must be numeric", bounds[1]->path(), bounds[1]->position());
+            }
+            loop.i = static_cast<Number*>(bounds[0])->value();
+            loop.end = static_cast<Number*>(bounds[1])->value();
+            if (l->is_inclusive()) ++loop.end;
+            loop.list = 0;
+            loop.origin = bounds[0];
+          }
+          else {
+            loop.list = box(stack.back(), ctx);
+            stack.pop_back();
+            loop.origin = 0;
+          }
+          for (size_t i = 0, A = scope.assigned.size(); i < A; ++i) {
+            if (stack[base + scope.assigned[i]].tag == Value::UNSET) created.push_back(scope.assigned[i]);
+          }
+          loops.push_back(loop);
+        } break;
+
+        case NEXT: {
+          Loop& loop = loops.back();
+          Value& variable = stack[base + f->scopes[loop.scope].variable];
+          if (!loop.list) {
+            if (!(loop.i < loop.end)) {
+              pc = in.arg;
+              break;
+            }
+            variable = unboxed_number(loop.i, 0, loop.origin->path(), loop.origin);
+            ++loop.i;
+          }
+          else {
+            bool is_list = loop.list->concrete_type() == Expression::LIST;
+            size_t length = is_list ? static_cast<List*>(loop.list)->length() : 1;
+            if (loop.index >= length) {
+              pc = in.arg;
+              break;
+            }
+            variable = boxed(is_list ? unwrapped((*static_cast<List*>(loop.list))[loop.index]) : loop.list);
+            ++loop.index;
+          }
+        } break;
+
+        case END_LOOP: {
+          Loop& loop = loops.back();
+          for (size_t i = loop.unset, C = created.size(); i < C; ++i) stack[base + created[i]] = unset;
+          created.resize(loop.unset);
+          stack[base + f->scopes[loop.scope].variable] = loop.saved;
+          loops.pop_back();
+        } break;
+
+        case RETURN:
+          return box(stack.back(), ctx);
+      }
+    }
+    return 0;
+  }
+
+}
@@ -0,0 +1,120 @@
+#define SASS_BYTECODE
+
+#include <string>
+#include <vector>
+#include <map>
+
+#ifndef SASS_ENVIRONMENT
+#include "environment.hpp"
+#endif
+
+#ifndef SASS_VALUE
+#include "value.hpp"
+#endif
+
+namespace Sass {
+  using std::string;
+  using std::vector;
+  using std::map;
+
+  class AST_Node;
+  class Expression;
+  class Definition;
+  class Eval;
+  struct Context;
+  typedef Environment<AST_Node*> Env;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Function bodies compiled to a stack machine, as an alternative to letting
+  // Eval walk them. Parameters, loop variables and the variables a body
+  // assigns live in numbered slots instead of environment frames, and
+  // values are kept unboxed (see value.hpp) until they leave the machine.
+  // Whatever the compiler doesn't handle itself is handed to Eval, so the
+  // results are Eval's: a body with statements it doesn't know isn't
+  // compiled at all, and an expression it doesn't know is evaluated by Eval
+  // in an environment made from the slots. A call whose body assigns a
+  // variable that already exists outside it is left to Eval too, as the
+  // assignment lands there.
+  /////////////////////////////////////////////////////////////////////////////
+  class Bytecode {
+  public:
+    enum Opcode {
+      PUSH,        // node: a value to push as it is
+      PUSH_NUMBER, // number, arg: a number and its unit, made at node
+      EVAL,        // node: an expression that doesn't read variables
+      EVAL_LOCAL,  // node: an expression Eval needs the locals for
+      EXEC_LOCAL,  // node: likewise for a statement (@warn)
+      LOAD,        // arg: slot; node: the variable, for looking further out
+      LOAD_FREE,   // node: a variable from outside the function
+      STORE,       // arg: slot
+      BINARY,      // node: the operation; pops both operands
+      UNARY,       // node: the operation
+      AND,         // arg: target; jumps keeping a false left-hand side
+      OR,          // arg: target; jumps keeping a true left-hand side
+      LIST,        // node: the list; arg: how many elements to pop
+      CALL,        // node: the call; arg: how many arguments to pop
+      JUMP,        // arg: target
+      JUMP_UNLESS, // arg: target; pops the condition
+      FOR,         // node: the loop; arg: its scope; pops both bounds
+      EACH,        // node: the loop; arg: its scope; pops the list
+      NEXT,        // arg: target; sets the loop variable, or jumps when done
+      END_LOOP,    // restores the variables of the innermost loop's scope
+      RETURN
+    };
+
+    struct Instruction {
+      Opcode    op;
+      size_t    arg;
+      double    number;
+      AST_Node* node;
+    };
+
+    // the variables a loop shadows and the ones it may create
+    struct Scope {
+      size_t         variable;
+      vector<size_t> assigned;
+    };
+
+    struct Function {
+      vector<Instruction> code;
+      vector<Scope>       scopes;
+      vector<string>      slots;      // names, the parameters first
+      size_t              parameters;
+      vector<size_t>      assigned;   // slots that must not exist outside
+    };
+
+    Bytecode();
+    // A copy starts out without compiled bodies, as they're only a cache;
+    // C++98 wants a Context copyable for `Context ctx = Context::Data()`.
+    Bytecode(const Bytecode&);
+    Bytecode& operator=(const Bytecode&);
+    ~Bytecode();
+
+    // The compiled body of def, if this call (whose parameters are bound in
+    // env) can run it; compiles it the first time, making whatever nodes it
+    // needs in ctx.mem.
+    Function* compiled(Definition* def, Env& env, Context& ctx);
+    // Runs a body with eval's environment and backtrace as set up for the
+    // call. Returns the value of its @return, or null if there wasn't one.
+    Expression* run(Function* f, Context& ctx, Eval& eval);
+
+  private:
+    struct Loop {
+      size_t      scope;
+      Value       saved;    // the loop variable's value outside the loop
+      size_t      unset;    // where its created variables start in `created`
+      double      i, end;   // @for
+      Expression* origin;   // the lower bound, where its numbers are made
+      Expression* list;     // @each, over a list or a single value
+      size_t      index;
+    };
+
+    Env*        locals(Function* f, size_t base, Env& scratch, Context& ctx);
+
+    map<Definition*, Function*> functions; // null for bodies that aren't compiled
+    vector<Value>               stack;     // the slots and operands of every active call
+    vector<Loop>                loops;
+    vector<size_t>              created;
+  };
+
+}
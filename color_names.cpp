@@ -0,0 +1,417 @@
+#ifndef SASS_COLOR_NAMES
+#include "color_names.hpp"
+#endif
+
+namespace Sass {
+
+
+  const char* const color_names[] =
+  {
+    "aliceblue",
+    "antiquewhite",
+    "aqua",
+    "aquamarine",
+    "azure",
+    "beige",
+    "bisque",
+    "black",
+    "blanchedalmond",
+    "blue",
+    "blueviolet",
+    "brown",
+    "burlywood",
+    "cadetblue",
+    "chartreuse",
+    "chocolate",
+    "coral",
+    "cornflowerblue",
+    "cornsilk",
+    "crimson",
+    "cyan",
+    "darkblue",
+    "darkcyan",
+    "darkgoldenrod",
+    "darkgray",
+    "darkgrey",
+    "darkgreen",
+    "darkkhaki",
+    "darkmagenta",
+    "darkolivegreen",
+    "darkorange",
+    "darkorchid",
+    "darkred",
+    "darksalmon",
+    "darkseagreen",
+    "darkslateblue",
+    "darkslategray",
+    "darkslategrey",
+    "darkturquoise",
+    "darkviolet",
+    "deeppink",
+    "deepskyblue",
+    "dimgray",
+    "dimgrey",
+    "dodgerblue",
+    "firebrick",
+    "floralwhite",
+    "forestgreen",
+    "fuchsia",
+    "gainsboro",
+    "ghostwhite",
+    "gold",
+    "goldenrod",
+    "gray",
+    "grey",
+    "green",
+    "greenyellow",
+    "honeydew",
+    "hotpink",
+    "indianred",
+    "indigo",
+    "ivory",
+    "khaki",
+    "lavender",
+    "lavenderblush",
+    "lawngreen",
+    "lemonchiffon",
+    "lightblue",
+    "lightcoral",
+    "lightcyan",
+    "lightgoldenrodyellow",
+    "lightgray",
+    "lightgrey",
+    "lightgreen",
+    "lightpink",
+    "lightsalmon",
+    "lightseagreen",
+    "lightskyblue",
+    "lightslategray",
+    "lightslategrey",
+    "lightsteelblue",
+    "lightyellow",
+    "lime",
+    "limegreen",
+    "linen",
+    "magenta",
+    "maroon",
+    "mediumaquamarine",
+    "mediumblue",
+    "mediumorchid",
+    "mediumpurple",
+    "mediumseagreen",
+    "mediumslateblue",
+    "mediumspringgreen",
+    "mediumturquoise",
+    "mediumvioletred",
+    "midnightblue",
+    "mintcream",
+    "mistyrose",
+    "moccasin",
+    "navajowhite",
+    "navy",
+    "oldlace",
+    "olive",
+    "olivedrab",
+    "orange",
+    "orangered",
+    "orchid",
+    "palegoldenrod",
+    "palegreen",
+    "paleturquoise",
+    "palevioletred",
+    "papayawhip",
+    "peachpuff",
+    "peru",
+    "pink",
+    "plum",
+    "powderblue",
+    "purple",
+    "red",
+    "rosybrown",
+    "royalblue",
+    "saddlebrown",
+    "salmon",
+    "sandybrown",
+    "seagreen",
+    "seashell",
+    "sienna",
+    "silver",
+    "skyblue",
+    "slateblue",
+    "slategray",
+    "slategrey",
+    "snow",
+    "springgreen",
+    "steelblue",
+    "tan",
+    "teal",
+    "thistle",
+    "tomato",
+    "turquoise",
+    "violet",
+    "wheat",
+    "white",
+    "whitesmoke",
+    "yellow",
+    "yellowgreen",
+    // sentinel value
+    0
+  };
+
+  const double color_values[] =
+  {
+    0xf0, 0xf8, 0xff,
+    0xfa, 0xeb, 0xd7,
+    0x00, 0xff, 0xff,
+    0x7f, 0xff, 0xd4,
+    0xf0, 0xff, 0xff,
+    0xf5, 0xf5, 0xdc,
+    0xff, 0xe4, 0xc4,
+    0x00, 0x00, 0x00,
+    0xff, 0xeb, 0xcd,
+    0x00, 0x00, 0xff,
+    0x8a, 0x2b, 0xe2,
+    0xa5, 0x2a, 0x2a,
+    0xde, 0xb8, 0x87,
+    0x5f, 0x9e, 0xa0,
+    0x7f, 0xff, 0x00,
+    0xd2, 0x69, 0x1e,
+    0xff, 0x7f, 0x50,
+    0x64, 0x95, 0xed,
+    0xff, 0xf8, 0xdc,
+    0xdc, 0x14, 0x3c,
+    0x00, 0xff, 0xff,
+    0x00, 0x00, 0x8b,
+    0x00, 0x8b, 0x8b,
+    0xb8, 0x86, 0x0b,
+    0xa9, 0xa9, 0xa9,
+    0xa9, 0xa9, 0xa9,
+    0x00, 0x64, 0x00,
+    0xbd, 0xb7, 0x6b,
+    0x8b, 0x00, 0x8b,
+    0x55, 0x6b, 0x2f,
+    0xff, 0x8c, 0x00,
+    0x99, 0x32, 0xcc,
+    0x8b, 0x00, 0x00,
+    0xe9, 0x96, 0x7a,
+    0x8f, 0xbc, 0x8f,
+    0x48, 0x3d, 0x8b,
+    0x2f, 0x4f, 0x4f,
+    0x2f, 0x4f, 0x4f,
+    0x00, 0xce, 0xd1,
+    0x94, 0x00, 0xd3,
+    0xff, 0x14, 0x93,
+    0x00, 0xbf, 0xff,
+    0x69, 0x69, 0x69,
+    0x69, 0x69, 0x69,
+    0x1e, 0x90, 0xff,
+    0xb2, 0x22, 0x22,
+    0xff, 0xfa, 0xf0,
+    0x22, 0x8b, 0x22,
+    0xff, 0x00, 0xff,
+    0xdc, 0xdc, 0xdc,
+    0xf8, 0xf8, 0xff,
+    0xff, 0xd7, 0x00,
+    0xda, 0xa5, 0x20,
+    0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80,
+    0x00, 0x80, 0x00,
+    0xad, 0xff, 0x2f,
+    0xf0, 0xff, 0xf0,
+    0xff, 0x69, 0xb4,
+    0xcd, 0x5c, 0x5c,
+    0x4b, 0x00, 0x82,
+    0xff, 0xff, 0xf0,
+    0xf0, 0xe6, 0x8c,
+    0xe6, 0xe6, 0xfa,
+    0xff, 0xf0, 0xf5,
+    0x7c, 0xfc, 0x00,
+    0xff, 0xfa, 0xcd,
+    0xad, 0xd8, 0xe6,
+    0xf0, 0x80, 0x80,
+    0xe0, 0xff, 0xff,
+    0xfa, 0xfa, 0xd2,
+    0xd3, 0xd3, 0xd3,
+    0xd3, 0xd3, 0xd3,
+    0x90, 0xee, 0x90,
+    0xff, 0xb6, 0xc1,
+    0xff, 0xa0, 0x7a,
+    0x20, 0xb2, 0xaa,
+    0x87, 0xce, 0xfa,
+    0x77, 0x88, 0x99,
+    0x77, 0x88, 0x99,
+    0xb0, 0xc4, 0xde,
+    0xff, 0xff, 0xe0,
+    0x00, 0xff, 0x00,
+    0x32, 0xcd, 0x32,
+    0xfa, 0xf0, 0xe6,
+    0xff, 0x00, 0xff,
+    0x80, 0x00, 0x00,
+    0x66, 0xcd, 0xaa,
+    0x00, 0x00, 0xcd,
+    0xba, 0x55, 0xd3,
+    0x93, 0x70, 0xd8,
+    0x3c, 0xb3, 0x71,
+    0x7b, 0x68, 0xee,
+    0x00, 0xfa, 0x9a,
+    0x48, 0xd1, 0xcc,
+    0xc7, 0x15, 0x85,
+    0x19, 0x19, 0x70,
+    0xf5, 0xff, 0xfa,
+    0xff, 0xe4, 0xe1,
+    0xff, 0xe4, 0xb5,
+    0xff, 0xde, 0xad,
+    0x00, 0x00, 0x80,
+    0xfd, 0xf5, 0xe6,
+    0x80, 0x80, 0x00,
+    0x6b, 0x8e, 0x23,
+    0xff, 0xa5, 0x00,
+    0xff, 0x45, 0x00,
+    0xda, 0x70, 0xd6,
+    0xee, 0xe8, 0xaa,
+    0x98, 0xfb, 0x98,
+    0xaf, 0xee, 0xee,
+    0xd8, 0x70, 0x93,
+    0xff, 0xef, 0xd5,
+    0xff, 0xda, 0xb9,
+    0xcd, 0x85, 0x3f,
+    0xff, 0xc0, 0xcb,
+    0xdd, 0xa0, 0xdd,
+    0xb0, 0xe0, 0xe6,
+    0x80, 0x00, 0x80,
+    0xff, 0x00, 0x00,
+    0xbc, 0x8f, 0x8f,
+    0x41, 0x69, 0xe1,
+    0x8b, 0x45, 0x13,
+    0xfa, 0x80, 0x72,
+    0xf4, 0xa4, 0x60,
+    0x2e, 0x8b, 0x57,
+    0xff, 0xf5, 0xee,
+    0xa0, 0x52, 0x2d,
+    0xc0, 0xc0, 0xc0,
+    0x87, 0xce, 0xeb,
+    0x6a, 0x5a, 0xcd,
+    0x70, 0x80, 0x90,
+    0x70, 0x80, 0x90,
+    0xff, 0xfa, 0xfa,
+    0x00, 0xff, 0x7f,
+    0x46, 0x82, 0xb4,
+    0xd2, 0xb4, 0x8c,
+    0x00, 0x80, 0x80,
+    0xd8, 0xbf, 0xd8,
+    0xff, 0x63, 0x47,
+    0x40, 0xe0, 0xd0,
+    0xee, 0x82, 0xee,
+    0xf5, 0xde, 0xb3,
+    0xff, 0xff, 0xff,
+    0xf5, 0xf5, 0xf5,
+    0xff, 0xff, 0x00,
+    0x9a, 0xcd, 0x32,
+    // sentinel value
+    0xfff
+  };
+
+  // generated by test/test_color_names.cpp --generate
+  static const unsigned int color_name_initials = 0x16efdef;
+  static const size_t shortest_color_name = 3;
+  static const size_t longest_color_name  = 20;
+
+  static const unsigned int color_name_displacements[color_hash_buckets] = {
+    0, 0, 0, 3, 0, 4, 3, 2, 5, 0, 0, 0,
+    1, 0, 4, 1, 1, 1, 6, 0, 1, 0, 0, 4,
+    1, 1, 0, 2, 0, 1, 3, 33, 1, 0, 0, 4,
+    0, 9, 3, 2, 2, 3, 0, 1, 0, 5, 2, 0,
+    7, 0, 2, 0, 0, 5, 0, 1, 0, 2, 8, 1,
+    7, 1, 0, 1
+  };
+
+  static const unsigned char color_name_slots[color_hash_slots] = {
+    0, 95, 22, 136, 139, 0, 108, 105, 59, 146, 73, 0,
+    8, 0, 112, 0, 0, 28, 0, 0, 147, 134, 0, 51,
+    0, 7, 0, 0, 0, 116, 107, 32, 97, 0, 0, 0,
+    49, 31, 45, 0, 0, 0, 0, 0, 0, 44, 58, 0,
+    83, 135, 117, 0, 0, 17, 2, 0, 0, 0, 40, 30,
+    0, 0, 123, 35, 0, 0, 98, 113, 0, 0, 130, 6,
+    0, 0, 143, 80, 138, 71, 47, 60, 0, 68, 43, 0,
+    62, 0, 5, 133, 0, 0, 20, 74, 50, 3, 10, 0,
+    39, 0, 0, 0, 16, 0, 0, 0, 76, 0, 25, 29,
+    128, 0, 27, 0, 23, 0, 79, 81, 0, 11, 96, 0,
+    102, 0, 66, 52, 127, 132, 141, 0, 121, 41, 0, 70,
+    0, 18, 122, 33, 55, 54, 53, 0, 0, 4, 26, 120,
+    0, 64, 0, 67, 0, 36, 0, 89, 0, 0, 103, 111,
+    75, 1, 144, 38, 13, 100, 65, 0, 93, 0, 21, 142,
+    0, 99, 0, 86, 0, 0, 0, 87, 69, 63, 37, 0,
+    46, 0, 0, 137, 0, 124, 104, 0, 78, 145, 57, 0,
+    0, 0, 0, 126, 85, 101, 0, 42, 0, 77, 115, 140,
+    0, 0, 56, 106, 0, 0, 0, 0, 118, 0, 0, 84,
+    131, 0, 12, 0, 72, 19, 0, 0, 48, 110, 0, 109,
+    88, 24, 129, 90, 0, 92, 34, 94, 0, 0, 0, 61,
+    125, 119, 0, 91, 14, 0, 0, 0, 114, 0, 0, 82,
+    0, 0, 15, 9
+  };
+
+  static const unsigned int color_value_displacements[color_hash_buckets] = {
+    0, 0, 0, 5, 1, 0, 1, 0, 1, 1, 2, 0,
+    1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 2, 0, 0, 1, 0, 1, 4, 1, 2, 1, 1,
+    0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 6, 1,
+    0, 1, 0, 0, 3, 1, 2, 1, 0, 6, 0, 2,
+    2, 9, 7, 0
+  };
+
+  static const unsigned char color_value_slots[color_hash_slots] = {
+    8, 45, 0, 0, 0, 75, 30, 89, 0, 58, 90, 120,
+    98, 107, 11, 84, 0, 0, 0, 0, 51, 111, 39, 64,
+    0, 135, 0, 0, 16, 70, 115, 0, 62, 0, 81, 0,
+    0, 85, 0, 0, 92, 0, 0, 29, 128, 77, 0, 17,
+    93, 0, 0, 6, 134, 105, 40, 9, 145, 0, 0, 0,
+    44, 96, 21, 0, 0, 127, 113, 0, 74, 0, 28, 0,
+    0, 131, 76, 136, 0, 24, 121, 0, 0, 57, 65, 0,
+    0, 0, 0, 0, 0, 15, 124, 68, 112, 117, 78, 104,
+    141, 122, 91, 52, 12, 0, 119, 0, 35, 0, 97, 33,
+    0, 0, 0, 0, 0, 0, 0, 82, 0, 0, 0, 0,
+    0, 0, 53, 61, 0, 0, 14, 138, 59, 0, 143, 0,
+    0, 0, 0, 144, 47, 100, 10, 50, 0, 95, 0, 83,
+    0, 67, 0, 114, 0, 46, 32, 0, 0, 88, 146, 0,
+    0, 27, 108, 0, 0, 0, 0, 87, 94, 38, 0, 0,
+    0, 125, 0, 0, 23, 34, 109, 48, 42, 0, 126, 0,
+    0, 102, 41, 0, 0, 140, 36, 86, 0, 0, 0, 0,
+    0, 0, 0, 0, 19, 80, 110, 116, 66, 1, 137, 0,
+    0, 13, 0, 60, 0, 5, 56, 0, 0, 69, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 20, 31, 0, 139, 106,
+    4, 99, 55, 0, 103, 101, 2, 123, 18, 0, 0, 7,
+    0, 0, 0, 0, 71, 0, 133, 129, 130, 142, 26, 73,
+    22, 118, 147, 63
+  };
+
+  static int value_of(size_t i)
+  {
+    return int(color_values[i*3])*0x10000 +
+           int(color_values[i*3+1])*0x100 +
+           int(color_values[i*3+2]);
+  }
+
+  int name_to_color(const string& name)
+  {
+    // most strings that get here are font names and keywords, so turn away
+    // anything that can't be a color before hashing
+    size_t length = name.length();
+    if (length < shortest_color_name || length > longest_color_name) return -1;
+    unsigned char initial = name[0];
+    if (initial < 'a' || initial > 'z' || !(color_name_initials & (1u << (initial - 'a')))) return -1;
+    unsigned int h = color_name_hash(name.data(), length);
+    size_t i = color_name_slots[color_hash_slot(h, color_name_displacements[color_hash_bucket(h)])];
+    if (!i-- || name != color_names[i]) return -1;
+    return value_of(i);
+  }
+
+  const char* color_to_name(int rgb)
+  {
+    if (rgb < 0 || rgb > 0xffffff) return 0;
+    unsigned int h = color_value_hash(rgb);
+    size_t i = color_value_slots[color_hash_slot(h, color_value_displacements[color_hash_bucket(h)])];
+    if (!i-- || value_of(i) != rgb) return 0;
+    return color_names[i];
+  }
+
+}
@@ -7,6 +7,11 @@
 #define PATH_SEP ':'
 #endif
 
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define SASS_USE_PTHREADS
+#include <pthread.h>
+#endif
+
 #ifndef SASS_AST
 #include "ast.hpp"
 #endif
@@ -23,7 +28,6 @@
 #include "contextualize.hpp"
 #include "extend.hpp"
 #include "copy_c_str.hpp"
-#include "color_names.hpp"
 #include "functions.hpp"
 #include "backtrace.hpp"
 
@@ -31,10 +35,19 @@
 #include "prelexer.hpp"
 #endif
 
+#ifndef SASS_MUTEX
+#include "mutex.hpp"
+#endif
+
 #include <iomanip>
 #include <iostream>
 #include <cstring>
 #include <sstream>
+#include <ctime>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
 
 namespace Sass {
   using namespace Constants;
@@ -44,6 +57,7 @@ namespace Sass {
 
   Context::Context(Context::Data initializers)
   : mem(Memory_Manager<AST_Node>()),
+    parse_arenas         (vector<Memory_Manager<AST_Node>*>()),
     source_c_str         (initializers.source_c_str()),
     sources              (vector<const char*>()),
     include_paths        (initializers.include_paths()),
@@ -51,6 +65,7 @@ namespace Sass {
     style_sheets         (map<string, Block*>()),
     source_map           (resolve_relative_path(initializers.output_path(), initializers.source_map_file(), get_cwd())),
     c_functions          (vector<Sass_C_Function_Descriptor>()),
+    path_table           (set<string>()),
     image_path           (make_canonical_path(initializers.image_path())),
     output_path          (make_canonical_path(initializers.output_path())),
     source_comments      (initializers.source_comments()),
@@ -58,11 +73,20 @@ namespace Sass {
     output_style         (initializers.output_style()),
     source_map_file      (make_canonical_path(initializers.source_map_file())),
     omit_source_map_url  (initializers.omit_source_map_url()),
-    names_to_colors      (map<string, Color*>()),
-    colors_to_names      (map<int, string>()),
     precision            (initializers.precision()),
+    parse_threads        (initializers.parse_threads()),
+    parse_cache          (initializers.parse_cache()),
+    import_cache         (initializers.import_cache()),
+    imports              (Import_Cache::Session(initializers.import_cache())),
+    fs_calls             (0),
+    stats                (initializers.stats()),
+    profiler             (initializers.profiler()),
+    memoize_functions    (initializers.memoize_functions()),
+    function_memo        (Function_Memo()),
+    use_bytecode         (initializers.use_bytecode()),
+    bytecode             (),
     extensions           (multimap<Compound_Selector, Complex_Selector*>()),
-    subset_map           (Subset_Map<string, pair<Complex_Selector*, Compound_Selector*> >())
+    subset_map           (Subset_Map<Simple_Selector*, pair<Complex_Selector*, Compound_Selector*>, Simple_Selector_Less>())
   {
     __resolve_imports = NULL;
 
@@ -71,8 +95,6 @@ namespace Sass {
     collect_include_paths(initializers.include_paths_c_str());
     collect_include_paths(initializers.include_paths_array());
 
-    setup_color_map();
-
     string entry_point = initializers.entry_point();
     if (!entry_point.empty()) {
       string result(add_file(entry_point));
@@ -83,24 +105,9 @@ namespace Sass {
   }
 
   Context::~Context()
-  { for (size_t i = 0; i < sources.size(); ++i) delete[] sources[i]; }
-
-  void Context::setup_color_map()
   {
-    size_t i = 0;
-    while (color_names[i]) {
-      string name(color_names[i]);
-      Color* value = new (mem) Color("[COLOR TABLE]", Position(),
-                                     color_values[i*3],
-                                     color_values[i*3+1],
-                                     color_values[i*3+2]);
-      names_to_colors[name] = value;
-      int numval = color_values[i*3]*0x10000;
-      numval += color_values[i*3+1]*0x100;
-      numval += color_values[i*3+2];
-      colors_to_names[numval] = name;
-      ++i;
-    }
+    for (size_t i = 0; i < sources.size(); ++i) File::release_file(const_cast<char*>(sources[i]));
+    for (size_t i = 0; i < parse_arenas.size(); ++i) delete parse_arenas[i];
   }
 
   void Context::collect_include_paths(const char* paths_str)
@@ -146,61 +153,83 @@ namespace Sass {
   }
 
   string Context::add_file(string path)
+  {
+    Loaded_File file;
+    string full_path(locate_file(path, file, included_files, fs_calls));
+    if (file.contents) queue_file(file);
+    return full_path;
+  }
+
+  string Context::add_file(string dir, string rel_filepath)
+  {
+    Loaded_File file;
+    string full_path(locate_file(dir, rel_filepath, file, included_files, fs_calls));
+    if (file.contents) queue_file(file);
+    return full_path;
+  }
+
+  // Finds and reads an imported file without touching the queue, so that
+  // parse workers can call it concurrently. Returns the key of the style
+  // sheet; file.contents stays null if it was already queued (or missing).
+  string Context::locate_file(string path, Loaded_File& file, vector<string>& tried, size_t& fs_calls) const
   {
     using namespace File;
-    char* contents = 0;
-    string real_path;
     path = make_canonical_path(path);
     for (size_t i = 0, S = include_paths.size(); i < S; ++i) {
       string full_path(join_paths(include_paths[i], path));
-      included_files.push_back(full_path);
+      tried.push_back(full_path);
       if (style_sheets.count(full_path)) return full_path;
-      contents = resolve_and_load(full_path, real_path);
-      if (contents) {
-        sources.push_back(contents);
-        included_files.push_back(real_path);
-        queue.push_back(make_pair(full_path, contents));
-        source_map.files.push_back(resolve_relative_path(real_path, source_map_file, cwd));
-        style_sheets[full_path] = 0;
+      file.contents = resolve_and_load(full_path, file.real_path, &imports, &fs_calls);
+      if (file.contents) {
+        tried.push_back(file.real_path);
+        file.full_path = full_path;
         return full_path;
       }
     }
     return string();
   }
 
-  string Context::add_file(string dir, string rel_filepath)
+  string Context::locate_file(string dir, string rel_filepath, Loaded_File& file, vector<string>& tried, size_t& fs_calls) const
   {
     using namespace File;
-    char* contents = 0;
-    string real_path;
     rel_filepath = make_canonical_path(rel_filepath);
     string full_path(join_paths(dir, rel_filepath));
     if (style_sheets.count(full_path)) return full_path;
-    contents = resolve_and_load(full_path, real_path);
-    if (contents) {
-      sources.push_back(contents);
-      included_files.push_back(real_path);
-      queue.push_back(make_pair(full_path, contents));
-      source_map.files.push_back(resolve_relative_path(real_path, source_map_file, cwd));
-      style_sheets[full_path] = 0;
+    file.contents = resolve_and_load(full_path, file.real_path, &imports, &fs_calls);
+    if (file.contents) {
+      tried.push_back(file.real_path);
+      file.full_path = full_path;
       return full_path;
     }
     for (size_t i = 0, S = include_paths.size(); i < S; ++i) {
       string full_path(join_paths(include_paths[i], rel_filepath));
       if (style_sheets.count(full_path)) return full_path;
-      contents = resolve_and_load(full_path, real_path);
-      if (contents) {
-        sources.push_back(contents);
-        included_files.push_back(real_path);
-        queue.push_back(make_pair(full_path, contents));
-        source_map.files.push_back(resolve_relative_path(real_path, source_map_file, cwd));
-        style_sheets[full_path] = 0;
+      file.contents = resolve_and_load(full_path, file.real_path, &imports, &fs_calls);
+      if (file.contents) {
+        tried.push_back(file.real_path);
+        file.full_path = full_path;
         return full_path;
       }
     }
     return string();
   }
 
+  void Context::queue_file(const Loaded_File& file)
+  {
+    // another worker in the same batch may have read it first
+    if (style_sheets.count(file.full_path)) {
+      File::release_file(file.contents);
+      return;
+    }
+    sources.push_back(file.contents);
+    queue.push_back(make_pair(file.full_path, file.contents));
+    source_map.files.push_back(resolve_relative_path(file.real_path, source_map_file, cwd));
+    style_sheets[file.full_path] = 0;
+  }
+
+  const char* Context::intern_path(const string& path)
+  { return path_table.insert(path).first->c_str(); }
+
   void register_function(Context&, Signature sig, Native_Function f, Env* env);
   void register_function(Context&, Signature sig, Native_Function f, size_t arity, Env* env);
   void register_overload_stub(Context&, string name, Env* env);
@@ -208,21 +237,303 @@ namespace Sass {
   void register_c_functions(Context&, Env* env, Sass_C_Function_Descriptor*);
   void register_c_function(Context&, Env* env, Sass_C_Function_Descriptor);
 
-  char* Context::compile_file()
+  Block* Context::parse_queue()
   {
+#ifdef SASS_USE_PTHREADS
+    // a custom importer is user code and may not be reentrant
+    if (parse_threads > 1 && !__resolve_imports) return parse_queue_in_parallel();
+#endif
     Block* root = 0;
     for (size_t i = 0; i < queue.size(); ++i) {
-      Parser p(Parser::from_c_str(queue[i].second, *this, queue[i].first, Position(1 + i, 1, 1)));
-      Block* ast = p.parse();
+      Block* ast = parse_file(i, intern_path(queue[i].first), 0, 0);
       if (i == 0) root = ast;
       style_sheets[queue[i].first] = ast;
     }
+    return root;
+  }
+
+  // Parses queue[i], or takes its tree from the parse cache. A cached tree
+  // is only used if replaying its imports resolves them to the same files;
+  // either way, the imports end up queued exactly as a fresh parse would.
+  Block* Context::parse_file(size_t i, const char* path, Memory_Manager<AST_Node>* arena, Pending_Imports* pending)
+  {
+    const string& key = queue[i].first;
+    const char* contents = queue[i].second;
+    Position source_position(1 + i, 1, 1);
+    // a custom importer may resolve differently from one compile to the next
+    if (!parse_cache || __resolve_imports) {
+      return Parser::from_c_str(contents, *this, path, source_position, arena, pending).parse();
+    }
+
+    if (Parse_Cache::Entry* cached = parse_cache->find(key, contents, source_maps ? source_position.file : 0)) {
+      // the replay records into a scratch list, as a failed one is followed
+      // by a parse that records the imports all over again
+      Pending_Imports replayed;
+      Parser p(Parser::from_c_str(contents, *this, path, source_position, arena, &replayed));
+      bool same_files = true;
+      for (size_t j = 0, S = cached->imports.size(); same_files && j < S; ++j) {
+        const Import_Request& imp = cached->imports[j];
+        string resolved(imp.relative ? p.import_file(imp.dir, imp.path) : p.import_file(imp.path));
+        same_files = resolved == imp.resolved;
+      }
+      if (pending) pending->fs_calls += replayed.fs_calls;
+      else         fs_calls += replayed.fs_calls;
+      if (same_files) {
+        if (pending) {
+          pending->files.insert(pending->files.end(), replayed.files.begin(), replayed.files.end());
+          pending->included_files.insert(pending->included_files.end(), replayed.included_files.begin(), replayed.included_files.end());
+        }
+        else {
+          for (size_t f = 0, F = replayed.files.size(); f < F; ++f) queue_file(replayed.files[f]);
+          included_files.insert(included_files.end(), replayed.included_files.begin(), replayed.included_files.end());
+        }
+        parse_cache->count_hit();
+        return cached->root;
+      }
+      for (size_t f = 0, F = replayed.files.size(); f < F; ++f) File::release_file(replayed.files[f].contents);
+    }
+
+    Parse_Cache::Entry* entry = new Parse_Cache::Entry(key, contents, source_position.file);
+    Parser p(Parser::from_c_str(contents, *this, entry->path.c_str(), source_position, &entry->mem, pending));
+    p.import_log = &entry->imports;
+    try {
+      entry->root = p.parse();
+    }
+    catch (...) {
+      delete entry;
+      throw;
+    }
+    if (stats) {
+      // the parse workers each count into their own pending imports
+      size_t& nodes = pending ? pending->nodes : stats->nodes;
+      size_t& node_bytes = pending ? pending->node_bytes : stats->node_bytes;
+      nodes += entry->mem.allocation_count();
+      node_bytes += entry->mem.bytes_allocated();
+    }
+    parse_cache->insert(entry);
+    return entry->root;
+  }
+
+#ifdef SASS_USE_PTHREADS
+  // One breadth-first level of the import graph: the queue entries in
+  // [begin, end), which can all be parsed without waiting on each other.
+  struct Parse_Batch {
+    Context&                           ctx;
+    size_t                             begin;
+    size_t                             end;
+    size_t                             next;
+    pthread_mutex_t                    next_lock;
+    vector<const char*>                paths;
+    vector<Block*>                     asts;
+    vector<Context::Pending_Imports>   imports;
+    vector<Error*>                     errors;
+    vector<bool>                       out_of_memory;
+
+    Parse_Batch(Context& ctx, size_t begin, size_t end)
+    : ctx(ctx), begin(begin), end(end), next(begin),
+      paths(vector<const char*>(end - begin)),
+      asts(vector<Block*>(end - begin)),
+      imports(vector<Context::Pending_Imports>(end - begin)),
+      errors(vector<Error*>(end - begin)),
+      out_of_memory(vector<bool>(end - begin))
+    { pthread_mutex_init(&next_lock, 0); }
+
+    ~Parse_Batch()
+    {
+      pthread_mutex_destroy(&next_lock);
+      for (size_t i = 0, S = errors.size(); i < S; ++i) delete errors[i];
+    }
+  };
+
+  struct Parse_Worker {
+    Parse_Batch*              batch;
+    Memory_Manager<AST_Node>* arena;
+    pthread_t                 thread;
+    bool                      started;
+  };
+
+  static void* run_parse_worker(void* arg)
+  {
+    Parse_Worker* worker = static_cast<Parse_Worker*>(arg);
+    Parse_Batch& batch = *worker->batch;
+    while (true) {
+      pthread_mutex_lock(&batch.next_lock);
+      size_t i = batch.next++;
+      pthread_mutex_unlock(&batch.next_lock);
+      if (i >= batch.end) break;
+      size_t k = i - batch.begin;
+      try {
+        batch.asts[k] = batch.ctx.parse_file(i, batch.paths[k], worker->arena, &batch.imports[k]);
+      }
+      catch (Error& e) {
+        batch.errors[k] = new Error(e);
+      }
+      catch (bad_alloc&) {
+        batch.out_of_memory[k] = true;
+      }
+    }
+    return 0;
+  }
+
+  // Parses the queue one import level at a time, spreading each level over
+  // up to parse_threads workers with an arena apiece. Files discovered by a
+  // level are queued in file order once it is done, so the queue, and with
+  // it every file index, ends up exactly as a serial parse would leave it.
+  Block* Context::parse_queue_in_parallel()
+  {
+    for (size_t begin = 0, end = queue.size(); begin < end; begin = end, end = queue.size()) {
+      Parse_Batch batch(*this, begin, end);
+      for (size_t i = begin; i < end; ++i) batch.paths[i - begin] = intern_path(queue[i].first);
+
+      vector<Parse_Worker> workers(min(parse_threads, end - begin));
+      for (size_t w = 0, W = workers.size(); w < W; ++w) {
+        workers[w].batch = &batch;
+        workers[w].arena = new Memory_Manager<AST_Node>();
+        parse_arenas.push_back(workers[w].arena);
+        // the calling thread takes the first share itself; if a thread
+        // can't be started, the remaining workers just pick up its files
+        workers[w].started = w > 0 && !pthread_create(&workers[w].thread, 0, run_parse_worker, &workers[w]);
+      }
+      run_parse_worker(&workers[0]);
+      for (size_t w = 1, W = workers.size(); w < W; ++w) {
+        if (workers[w].started) pthread_join(workers[w].thread, 0);
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+        size_t k = i - begin;
+        if (batch.errors[k] || batch.out_of_memory[k]) {
+          for (size_t j = k; j < end - begin; ++j) {
+            for (size_t f = 0, F = batch.imports[j].files.size(); f < F; ++f) File::release_file(batch.imports[j].files[f].contents);
+          }
+          if (batch.out_of_memory[k]) throw bad_alloc();
+          throw Error(*batch.errors[k]);
+        }
+        style_sheets[queue[i].first] = batch.asts[k];
+        included_files.insert(included_files.end(), batch.imports[k].included_files.begin(), batch.imports[k].included_files.end());
+        fs_calls += batch.imports[k].fs_calls;
+        if (stats) {
+          stats->nodes += batch.imports[k].nodes;
+          stats->node_bytes += batch.imports[k].node_bytes;
+        }
+        for (size_t f = 0, F = batch.imports[k].files.size(); f < F; ++f) queue_file(batch.imports[k].files[f]);
+      }
+    }
+    return queue.empty() ? 0 : style_sheets[queue[0].first];
+  }
+#endif
+
+  // The built-in function definitions are made once per process, by the
+  // first compile, and shared by every compile after it. Their signatures
+  // are parsed by a context of their own, whose arena keeps the definitions
+  // alive; each compile copies the bindings into its global frame, so user
+  // definitions still shadow them there.
+  static Env* shared_built_ins = 0;
+#ifndef SASS_USE_PTHREADS
+  // Windows hosts compile on several threads too (node-sass on the libuv pool)
+  static Mutex built_ins_lock;
+#endif
+
+  static void build_built_in_functions()
+  {
+    Context* host = new Context(Context::Data().source_c_str(0)
+                                               .entry_point("")
+                                               .output_path("")
+                                               .image_path("")
+                                               .include_paths_c_str(0)
+                                               .include_paths_array(0)
+                                               .include_paths(vector<string>())
+                                               .source_comments(false)
+                                               .source_maps(false)
+                                               .output_style(NESTED)
+                                               .source_map_file("")
+                                               .omit_source_map_url(false)
+                                               .precision(5)
+                                               .parse_threads(0)
+                                               .parse_cache(0)
+                                               .import_cache(0)
+                                               .stats(0)
+                                               .profiler(0)
+                                               .memoize_functions(false)
+                                               .use_bytecode(false));
+    Env* functions = new Env();
+    register_built_in_functions(*host, functions);
+    shared_built_ins = functions;
+  }
+
+  static const Env& built_in_functions()
+  {
+#ifdef SASS_USE_PTHREADS
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, build_built_in_functions);
+#else
+    built_ins_lock.lock();
+    try {
+      if (!shared_built_ins) build_built_in_functions();
+    }
+    catch (...) {
+      built_ins_lock.unlock();
+      throw;
+    }
+    built_ins_lock.unlock();
+#endif
+    return *shared_built_ins;
+  }
+
+  char* Context::compile_file()
+  {
+    Emitter output;
+    compile_file(output);
+    return output.c_str();
+  }
+
+  static double wall_clock()
+  {
+#ifdef _WIN32
+    // where clock() measures wall time anyway
+    return double(clock()) / CLOCKS_PER_SEC;
+#else
+    timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec + now.tv_usec / 1e6;
+#endif
+  }
+
+  // Charges the time since the last call to the phase just finished.
+  struct Phase_Timer {
+    Compile_Stats* stats;
+    double         wall;
+    clock_t        cpu;
+
+    Phase_Timer(Compile_Stats* stats)
+    : stats(stats), wall(stats ? wall_clock() : 0), cpu(stats ? clock() : 0)
+    { }
+
+    void end(Compile_Phase phase)
+    {
+      if (!stats) return;
+      double wall_now = wall_clock();
+      clock_t cpu_now = clock();
+      stats->wall_seconds[phase] += wall_now - wall;
+      stats->cpu_seconds[phase] += double(cpu_now - cpu) / CLOCKS_PER_SEC;
+      wall = wall_now;
+      cpu = cpu_now;
+    }
+  };
+
+  void Context::compile_file(Emitter& output)
+  {
+    if (stats) *stats = Compile_Stats();
+    if (profiler) profiler->start_compile();
+    Phase_Timer timer(stats);
+    Block* root = parse_queue();
+    timer.end(PARSE_PHASE);
     Env tge;
     Backtrace backtrace(0, "", Position(), "");
-    register_built_in_functions(*this, &tge);
+    tge.current_frame() = built_in_functions().current_frame();
     for (size_t i = 0, S = c_functions.size(); i < S; ++i) {
     	register_c_function(*this, &tge, c_functions[i]);
     }
+    timer.end(FUNCTIONS_PHASE);
     Eval eval(*this, &tge, &backtrace);
     Contextualize contextualize(*this, &eval, &tge, &backtrace);
     Expand expand(*this, &eval, &contextualize, &tge, &backtrace);
@@ -230,35 +541,49 @@ namespace Sass {
     // Output_Nested output_nested(*this);
 
     root = root->perform(&expand)->block();
+    timer.end(EXPAND_PHASE);
     if (!extensions.empty()) {
       Extend extend(*this, extensions, subset_map, &backtrace);
       root->perform(&extend);
     }
-    char* result = 0;
+    timer.end(EXTEND_PHASE);
     switch (output_style) {
       case COMPRESSED: {
-        Output_Compressed output_compressed(this);
+        Output_Compressed output_compressed(this, &output);
         root->perform(&output_compressed);
-        string output = output_compressed.get_buffer();
         if (source_map_file != "" && !omit_source_map_url) {
-          output += format_source_mapping_url(source_map_file);
+          output.append(format_source_mapping_url(source_map_file));
         }
-        result = copy_c_str(output.c_str());
       } break;
 
       default: {
-        Output_Nested output_nested(source_comments, this);
+        Output_Nested output_nested(source_comments, this, &output);
         root->perform(&output_nested);
-        string output = output_nested.get_buffer();
         if (source_map_file != "" && !omit_source_map_url) {
-          output += "\n" + format_source_mapping_url(source_map_file);
+          output.append("\n" + format_source_mapping_url(source_map_file));
         }
-        result = copy_c_str(output.c_str());
-
       } break;
     }
+    output.flush();
+    timer.end(OUTPUT_PHASE);
+    if (stats) count_work();
+  }
 
-    return result;
+  // everything but the timings and the calls, which are counted as they go
+  void Context::count_work()
+  {
+    stats->nodes += mem.allocation_count();
+    stats->node_bytes += mem.bytes_allocated();
+    for (size_t i = 0, S = parse_arenas.size(); i < S; ++i) {
+      stats->nodes += parse_arenas[i]->allocation_count();
+      stats->node_bytes += parse_arenas[i]->bytes_allocated();
+    }
+    for (size_t i = 0, S = queue.size(); i < S; ++i) stats->bytes_read += strlen(queue[i].second);
+    stats->files = queue.size();
+    stats->memo_hits = function_memo.hits();
+    stats->memo_misses = function_memo.misses();
+    stats->extensions = extensions.size();
+    stats->extend_keys = subset_map.size();
   }
 
   string Context::format_source_mapping_url(const string& file) const
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include "kwd_arg_macros.hpp"
 
 #ifndef SASS_MEMORY_MANAGER
@@ -21,6 +22,26 @@
 #include "subset_map.hpp"
 #endif
 
+#ifndef SASS_PARSE_CACHE
+#include "parse_cache.hpp"
+#endif
+
+#ifndef SASS_IMPORT_CACHE
+#include "import_cache.hpp"
+#endif
+
+#ifndef SASS_PROFILER
+#include "profiler.hpp"
+#endif
+
+#ifndef SASS_FUNCTION_MEMO
+#include "function_memo.hpp"
+#endif
+
+#ifndef SASS_BYTECODE
+#include "bytecode.hpp"
+#endif
+
 struct Sass_C_Function_Descriptor;
 
 namespace Sass {
@@ -30,6 +51,7 @@ namespace Sass {
   class Expression;
   class Color;
   struct Backtrace;
+  class Emitter;
   // typedef const char* Signature;
   // struct Context;
   // typedef Environment<AST_Node*> Env;
@@ -37,8 +59,49 @@ namespace Sass {
 
   enum Output_Style { NESTED, EXPANDED, COMPACT, COMPRESSED, FORMATTED };
 
+  enum Compile_Phase { PARSE_PHASE, FUNCTIONS_PHASE, EXPAND_PHASE, EXTEND_PHASE, OUTPUT_PHASE, NUM_PHASES };
+
+  // What a compile spent its time on, and how much it did; only collected
+  // when a context is given somewhere to put it. CPU time is the process's,
+  // so it includes every parse worker.
+  struct Compile_Stats {
+    double wall_seconds[NUM_PHASES];
+    double cpu_seconds[NUM_PHASES];
+    size_t nodes;          // allocated by this compile's memory managers
+    size_t node_bytes;
+    size_t bytes_read;     // source text, the entry point's included
+    size_t files;          // style sheets parsed or taken from the parse cache
+    size_t function_calls; // of built-in, C and Sass functions
+    size_t mixin_calls;
+    size_t memo_hits;      // function calls answered from the memo
+    size_t memo_misses;    // and the ones it was asked about in vain
+    size_t bytecode_calls; // Sass function calls run as bytecode
+    size_t extensions;     // @extend pairs recorded
+    size_t extend_keys;    // entries in the subset map they're looked up in
+  };
+
   struct Context {
+    // a file found on disk for an @import, not yet queued for parsing
+    struct Loaded_File {
+      string full_path;
+      string real_path;
+      char*  contents;
+      Loaded_File() : full_path(string()), real_path(string()), contents(0) { }
+    };
+    // imports discovered by a parse worker, queued once its batch is done
+    struct Pending_Imports {
+      vector<Loaded_File> files;
+      vector<string>      included_files;
+      size_t              fs_calls;
+      size_t              nodes; // parsed into the parse cache
+      size_t              node_bytes;
+      Pending_Imports()
+      : files(vector<Loaded_File>()), included_files(vector<string>()), fs_calls(0), nodes(0), node_bytes(0)
+      { }
+    };
+
     Memory_Manager<AST_Node> mem;
+    vector<Memory_Manager<AST_Node>*> parse_arenas; // nodes built by parse workers
 
     const char* source_c_str;
     vector<const char*> sources; // c-strs containing Sass file contents
@@ -47,6 +110,7 @@ namespace Sass {
     map<string, Block*> style_sheets; // map of paths to ASTs
     SourceMap source_map;
     vector<Sass_C_Function_Descriptor> c_functions;
+    set<string> path_table; // interned source paths; nodes point into this
 
     string       image_path; // for the image-url Sass function
     string       output_path; // for relative paths to the output
@@ -56,10 +120,18 @@ namespace Sass {
     string       source_map_file;
     bool         omit_source_map_url;
 
-    map<string, Color*> names_to_colors;
-    map<int, string>    colors_to_names;
-
     size_t precision; // precision for outputting fractional numbers
+    size_t parse_threads; // 0 or 1 parses the import queue serially
+    Parse_Cache* parse_cache; // shared with other contexts; may be null
+    Import_Cache* import_cache; // likewise
+    mutable Import_Cache::Session imports; // this compile's use of it
+    size_t fs_calls; // stats, opens and listings made finding and reading files
+    Compile_Stats* stats; // filled in by compile_file when not null
+    Profiler* profiler; // told about every mixin and function call when not null
+    bool memoize_functions; // replay calls of side-effect-free functions
+    Function_Memo function_memo;
+    bool use_bytecode; // run function bodies as bytecode where they can be
+    Bytecode bytecode;
 
     KWD_ARG_SET(Data) {
       KWD_ARG(Data, const char*,     source_c_str);
@@ -75,17 +147,30 @@ namespace Sass {
       KWD_ARG(Data, string,          source_map_file);
       KWD_ARG(Data, bool,            omit_source_map_url);
       KWD_ARG(Data, size_t,          precision);
+      KWD_ARG(Data, size_t,          parse_threads);
+      KWD_ARG(Data, Parse_Cache*,    parse_cache);
+      KWD_ARG(Data, Import_Cache*,   import_cache);
+      KWD_ARG(Data, Compile_Stats*,  stats);
+      KWD_ARG(Data, Profiler*,       profiler);
+      KWD_ARG(Data, bool,            memoize_functions);
+      KWD_ARG(Data, bool,            use_bytecode);
     };
 
     Context(Data);
     ~Context();
     void collect_include_paths(const char* paths_str);
     void collect_include_paths(const char* paths_array[]);
-    void setup_color_map();
     string add_file(string);
     string add_file(string, string);
+    string locate_file(string, Loaded_File&, vector<string>&, size_t&) const;
+    string locate_file(string, string, Loaded_File&, vector<string>&, size_t&) const;
+    void queue_file(const Loaded_File&);
+    Block* parse_file(size_t, const char*, Memory_Manager<AST_Node>*, Pending_Imports*);
+    const char* intern_path(const string&);
     char* compile_string();
     char* compile_file();
+    // streams the CSS into `output` instead of returning it
+    void compile_file(Emitter& output);
     char* generate_source_map();
 
     std::vector<string> get_included_files();
@@ -93,6 +178,9 @@ namespace Sass {
     Sass_C_Function __resolve_imports;
 
   private:
+    Block* parse_queue();
+    Block* parse_queue_in_parallel();
+    void count_work();
     string format_source_mapping_url(const string& file) const;
     string get_cwd();
 
@@ -106,7 +194,7 @@ namespace Sass {
 
   public:
     multimap<Compound_Selector, Complex_Selector*> extensions;
-    Subset_Map<string, pair<Complex_Selector*, Compound_Selector*> > subset_map;
+    Subset_Map<Simple_Selector*, pair<Complex_Selector*, Compound_Selector*>, Simple_Selector_Less> subset_map;
   };
 
 }
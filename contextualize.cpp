@@ -89,8 +89,7 @@ namespace Sass {
 
   Selector* Contextualize::operator()(Compound_Selector* s)
   {
-    To_String to_string;
-    if (placeholder && extender && s->perform(&to_string) == placeholder->perform(&to_string)) {
+    if (placeholder && extender && *s == *static_cast<Compound_Selector*>(placeholder)) {
       return extender;
     }
     Compound_Selector* ss = new (ctx.mem) Compound_Selector(s->path(), s->position(), s->length());
@@ -136,8 +135,8 @@ namespace Sass {
 
   Selector* Contextualize::operator()(Selector_Placeholder* p)
   {
-    To_String to_string;
-    if (placeholder && extender && p->perform(&to_string) == placeholder->perform(&to_string)) {
+    Compound_Selector* sought = static_cast<Compound_Selector*>(placeholder);
+    if (placeholder && extender && sought->length() == 1 && *p == *(*sought)[0]) {
       return extender;
     }
     else {
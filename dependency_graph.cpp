@@ -0,0 +1,102 @@
+#include "dependency_graph.hpp"
+#include "file.hpp"
+
+namespace Sass {
+
+  Dependency_Graph::Dependency_Graph(const string& cwd)
+  : cwd(cwd), entries(vector<Entry>()), users(map<string, set<size_t> >()), name_users(map<string, set<size_t> >())
+  { }
+
+  string Dependency_Graph::absolute(const string& path) const
+  { return File::make_absolute_path(path, cwd); }
+
+  // "dir/_name.scss" and "dir/name" both stand for the import "name"
+  string Dependency_Graph::import_name(const string& path)
+  {
+    string name(File::base_name(path));
+    if (!name.empty() && name[0] == '_') name.erase(0, 1);
+    size_t dot = name.rfind('.');
+    if (dot != string::npos) {
+      string ext(name.substr(dot));
+      if (ext == ".scss" || ext == ".sass" || ext == ".css") name.erase(dot);
+    }
+    return name;
+  }
+
+  size_t Dependency_Graph::add_entry(const string& input_path)
+  {
+    Entry entry;
+    entry.input_path = input_path;
+    entry.failed = false;
+    entry.stale = true;
+    entries.push_back(entry);
+    size_t i = entries.size() - 1;
+    // until its first compile, an entry point is known to use itself
+    entries[i].files.insert(absolute(input_path));
+    users[absolute(input_path)].insert(i);
+    name_users[import_name(input_path)].insert(i);
+    return i;
+  }
+
+  void Dependency_Graph::forget(size_t i)
+  {
+    for (set<string>::iterator f = entries[i].files.begin(); f != entries[i].files.end(); ++f) {
+      map<string, set<size_t> >::iterator u = users.find(*f);
+      if (u != users.end() && u->second.erase(i) && u->second.empty()) users.erase(u);
+      map<string, set<size_t> >::iterator n = name_users.find(import_name(*f));
+      if (n != name_users.end() && n->second.erase(i) && n->second.empty()) name_users.erase(n);
+    }
+    entries[i].files.clear();
+  }
+
+  void Dependency_Graph::record(size_t i, const vector<string>& files, bool failed)
+  {
+    forget(i);
+    Entry& entry = entries[i];
+    entry.files.insert(absolute(entry.input_path));
+    for (size_t f = 0, F = files.size(); f < F; ++f) entry.files.insert(absolute(files[f]));
+    for (set<string>::iterator f = entry.files.begin(); f != entry.files.end(); ++f) {
+      users[*f].insert(i);
+      name_users[import_name(*f)].insert(i);
+    }
+    entry.failed = failed;
+    entry.stale = false;
+  }
+
+  size_t Dependency_Graph::changed(const string& path)
+  {
+    string file(absolute(path));
+    set<size_t> affected;
+    map<string, set<size_t> >::iterator u = users.find(file);
+    if (u != users.end()) {
+      affected = u->second;
+    }
+    else {
+      map<string, set<size_t> >::iterator n = name_users.find(import_name(file));
+      if (n != name_users.end()) affected = n->second;
+    }
+    // a failed compile doesn't report what it got as far as reading
+    for (size_t i = 0, S = entries.size(); i < S; ++i) {
+      if (entries[i].failed) affected.insert(i);
+    }
+    size_t newly_stale = 0;
+    for (set<size_t>::iterator i = affected.begin(); i != affected.end(); ++i) {
+      if (!entries[*i].stale) ++newly_stale;
+      entries[*i].stale = true;
+    }
+    return newly_stale;
+  }
+
+  void Dependency_Graph::changed_all()
+  {
+    for (size_t i = 0, S = entries.size(); i < S; ++i) entries[i].stale = true;
+  }
+
+  vector<size_t> Dependency_Graph::dependents(const string& path) const
+  {
+    map<string, set<size_t> >::const_iterator u = users.find(absolute(path));
+    if (u == users.end()) return vector<size_t>();
+    return vector<size_t>(u->second.begin(), u->second.end());
+  }
+
+}
@@ -0,0 +1,60 @@
+#define SASS_DEPENDENCY_GRAPH
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+namespace Sass {
+  using std::string;
+  using std::vector;
+  using std::map;
+  using std::set;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Which files each entry point of a project was compiled from, as reported
+  // by its last compile, and which entry points a change has made stale.
+  // A file the graph has never seen can still matter: it may be a partial
+  // that an entry point failed to find, or one that now shadows a file an
+  // entry point imported from further down the include paths. Such a file
+  // makes stale every entry point that used a file of the same import name.
+  // Entry points whose last compile failed go stale on any change.
+  /////////////////////////////////////////////////////////////////////////////
+  class Dependency_Graph {
+  public:
+    Dependency_Graph(const string& cwd);
+
+    // entry points start out stale
+    size_t add_entry(const string& input_path);
+    size_t size() const { return entries.size(); }
+    const string& input_path(size_t entry) const { return entries[entry].input_path; }
+
+    // replaces what the entry point depends on and marks it fresh
+    void record(size_t entry, const vector<string>& files, bool failed);
+    // returns how many entry points went from fresh to stale
+    size_t changed(const string& path);
+    void   changed_all();
+    bool   stale(size_t entry) const { return entries[entry].stale; }
+
+    // entry points that used the file in their last compile, in order
+    vector<size_t> dependents(const string& path) const;
+
+  private:
+    struct Entry {
+      string      input_path;
+      set<string> files;
+      bool        failed;
+      bool        stale;
+    };
+
+    string absolute(const string& path) const;
+    static string import_name(const string& path);
+    void forget(size_t entry);
+
+    string                      cwd;
+    vector<Entry>               entries;
+    map<string, set<size_t> >   users;       // file -> entry points
+    map<string, set<size_t> >   name_users;  // import name -> entry points
+  };
+
+}
@@ -0,0 +1,148 @@
+#include <cstdlib>
+#include <cstring>
+#include <typeinfo>
+
+#ifndef SASS_EMITTER
+#include "emitter.hpp"
+#endif
+
+#ifndef SASS_AST
+#include "ast.hpp"
+#endif
+
+#ifndef SASS_ERROR_HANDLING
+#include "error_handling.hpp"
+#endif
+
+namespace Sass {
+
+  Emitter::Emitter()
+  : chunks(), flushed(0), held(0), sink(0), cookie(0), path("")
+  { }
+
+  Emitter::Emitter(Sink sink, void* cookie, const string& path)
+  : chunks(), flushed(0), held(0), sink(sink), cookie(cookie), path(path)
+  { }
+
+  void Emitter::append(const string& text)
+  { append(text.data(), text.length()); }
+
+  void Emitter::append(const char* text, size_t length)
+  {
+    while (length) {
+      if (chunks.empty() || chunks.back().length() >= chunk_size) {
+        chunks.push_back(string());
+        // the first chunk grows as needed, so short buffers (e.g., the ones
+        // To_String makes) don't pay for a whole chunk up front
+        if (chunks.size() > 1) chunks.back().reserve(chunk_size);
+      }
+      string& chunk = chunks.back();
+      size_t n = chunk_size - chunk.length();
+      if (n > length) n = length;
+      chunk.append(text, n);
+      held   += n;
+      text   += n;
+      length -= n;
+    }
+    // keep the last two chunks around so that erase_last() always has
+    // something to work with, however recently a chunk was started
+    if (sink && chunks.size() > 2) write_out(chunks.size() - 2);
+  }
+
+  void Emitter::erase_last()
+  {
+    while (!chunks.empty() && chunks.back().empty()) chunks.pop_back();
+    if (chunks.empty()) return;
+    string& chunk = chunks.back();
+    chunk.erase(chunk.length() - 1);
+    --held;
+  }
+
+  char Emitter::back(size_t i) const
+  {
+    for (size_t c = chunks.size(); c > 0; --c) {
+      const string& chunk = chunks[c-1];
+      if (i < chunk.length()) return chunk[chunk.length() - 1 - i];
+      i -= chunk.length();
+    }
+    return '\0';
+  }
+
+  void Emitter::write_out(size_t n_chunks)
+  {
+    for (size_t i = 0; i < n_chunks; ++i) {
+      const string& chunk = chunks[i];
+      if (sink(chunk.data(), chunk.length(), cookie) != chunk.length()) {
+        throw Error(Error::write, path, Position(), "unable to write the output");
+      }
+      flushed += chunk.length();
+      held    -= chunk.length();
+    }
+    chunks.erase(chunks.begin(), chunks.begin() + n_chunks);
+  }
+
+  void Emitter::flush()
+  { if (sink) write_out(chunks.size()); }
+
+  string Emitter::str() const
+  {
+    if (chunks.size() == 1) return chunks.front();
+    string s;
+    s.reserve(held);
+    for (size_t i = 0, S = chunks.size(); i < S; ++i) s += chunks[i];
+    return s;
+  }
+
+  char* Emitter::c_str() const
+  {
+    char* s = (char*) malloc(held + 1);
+    char* p = s;
+    for (size_t i = 0, S = chunks.size(); i < S; ++i) {
+      memcpy(p, chunks[i].data(), chunks[i].length());
+      p += chunks[i].length();
+    }
+    *p = '\0';
+    return s;
+  }
+
+  static bool is_printed(Ruleset* r, bool drop_placeholders)
+  {
+    if (!drop_placeholders) return true;
+    Selector_List* sl = static_cast<Selector_List*>(r->selector());
+    for (size_t i = 0, L = sl->length(); i < L; ++i) {
+      if (!(*sl)[i]->has_placeholder()) return true;
+    }
+    return false;
+  }
+
+  static void collect_from(Statement* stm, bool drop_placeholders, vector<Import*>& found)
+  {
+    Block* b = 0;
+    if (typeid(*stm) == typeid(Import)) {
+      found.push_back(static_cast<Import*>(stm));
+    }
+    else if (typeid(*stm) == typeid(Ruleset)) {
+      Ruleset* r = static_cast<Ruleset*>(stm);
+      if (is_printed(r, drop_placeholders)) b = r->block();
+    }
+    else if (typeid(*stm) == typeid(Media_Block) || typeid(*stm) == typeid(At_Rule)) {
+      b = static_cast<Has_Block*>(stm)->block();
+    }
+    if (!b) return;
+    // nested blocks print their own statements before the hoisted ones
+    for (size_t i = 0, L = b->length(); i < L; ++i) {
+      if (!(*b)[i]->is_hoistable()) collect_from((*b)[i], drop_placeholders, found);
+    }
+    for (size_t i = 0, L = b->length(); i < L; ++i) {
+      if ((*b)[i]->is_hoistable()) collect_from((*b)[i], drop_placeholders, found);
+    }
+  }
+
+  void collect_imports(Block* b, bool drop_placeholders, vector<Import*>& found)
+  {
+    for (size_t i = 0, L = b->length(); i < L; ++i) {
+      collect_from((*b)[i], drop_placeholders, found);
+    }
+  }
+
+}
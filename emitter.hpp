@@ -0,0 +1,63 @@
+#define SASS_EMITTER
+
+#include <string>
+#include <vector>
+
+namespace Sass {
+  using std::string;
+  using std::vector;
+
+  class Block;
+  class Import;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Collects generated CSS in fixed-size chunks, so a large style sheet is
+  // never regrown and copied as one string. With a sink attached, chunks
+  // are handed over as soon as erase_last() can no longer reach them, and
+  // only a bounded tail of the output is ever held in memory.
+  /////////////////////////////////////////////////////////////////////////////
+  class Emitter {
+  public:
+    // Returns the number of bytes consumed; anything short of `length` is
+    // treated as a write error.
+    typedef size_t (*Sink)(const char* data, size_t length, void* cookie);
+
+  private:
+    static const size_t chunk_size = 64 * 1024;
+
+    vector<string> chunks; // output not yet handed to the sink
+    size_t         flushed;
+    size_t         held;
+    Sink           sink;
+    void*          cookie;
+    string         path;   // reported in write errors
+
+    void write_out(size_t n_chunks);
+
+  public:
+    Emitter();
+    Emitter(Sink sink, void* cookie, const string& path = "");
+
+    void append(const string& text);
+    void append(const char* text, size_t length);
+    // Drops the last character, provided it hasn't reached the sink yet.
+    void erase_last();
+    // The character `i` places from the end, or '\0' if it isn't held.
+    char back(size_t i = 0) const;
+
+    size_t length() const { return flushed + held; }
+    bool   streaming() const { return sink != 0; }
+
+    // Hands everything held over to the sink.
+    void   flush();
+    // Everything held, as a single string or a malloc'ed C string.
+    string str() const;
+    char*  c_str() const;
+  };
+
+  // CSS wants @import before anything else, so the output visitors render
+  // the imports of the whole tree up front. These are collected in the
+  // order the visitors would reach them, skipping rulesets they won't print.
+  void collect_imports(Block* b, bool drop_placeholders, vector<Import*>& found);
+
+}
@@ -19,6 +19,9 @@ char *sass_compile_emscripten(
   options.image_path = NULL;
   options.include_paths = include_paths;
   options.precision = 0; // 0 => use sass default numeric precision
+  options.parse_threads = 0;
+  options.parse_cache = NULL;
+  options.compile_threads = 0;
 
   ctx->options = options;
   ctx->source_string = source_string;
@@ -1,38 +1,142 @@
 #define SASS_ENVIRONMENT
 
 #include <string>
-#include <map>
+#include <vector>
 #include "ast_def_macros.hpp"
 #include <iostream>
 
 namespace Sass {
   using std::string;
-  using std::map;
+  using std::vector;
   using std::cerr;
   using std::endl;
 
+  inline size_t hash_key(const string& key)
+  {
+    // FNV-1a
+    size_t h = 2166136261u;
+    for (size_t i = 0, L = key.size(); i < L; ++i) {
+      h ^= static_cast<unsigned char>(key[i]);
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // The bindings of a single scope. This is an open-addressing hash table
+  // with linear probing; each slot remembers the hash of its key, so probing
+  // (and walking up a chain of frames with the same hash) only compares
+  // strings when the hashes match. Bindings are never removed.
+  /////////////////////////////////////////////////////////////////////////////
+  template <typename T>
+  class Frame {
+    struct Slot {
+      size_t hash;
+      string key;
+      T      value;
+      bool   used;
+      Slot() : hash(0), key(string()), value(T()), used(false) { }
+    };
+    vector<Slot> slots_;
+    size_t       size_;
+
+    size_t probe(const string& key, size_t hash) const
+    {
+      size_t mask = slots_.size() - 1;
+      size_t i = hash & mask;
+      while (slots_[i].used && (slots_[i].hash != hash || slots_[i].key != key)) {
+        i = (i + 1) & mask;
+      }
+      return i;
+    }
+
+    void grow()
+    {
+      vector<Slot> old;
+      old.swap(slots_);
+      slots_.resize(old.empty() ? 8 : old.size() * 2);
+      for (size_t i = 0, S = old.size(); i < S; ++i) {
+        if (!old[i].used) continue;
+        Slot& s = slots_[probe(old[i].key, old[i].hash)];
+        s.hash = old[i].hash;
+        s.key.swap(old[i].key);
+        s.value = old[i].value;
+        s.used = true;
+      }
+    }
+
+  public:
+    Frame() : slots_(vector<Slot>()), size_(0) { }
+
+    size_t size() const { return size_; }
+
+    T* find(const string& key, size_t hash)
+    {
+      if (!size_) return 0;
+      Slot& s = slots_[probe(key, hash)];
+      return s.used ? &s.value : 0;
+    }
+
+    const T* find(const string& key, size_t hash) const
+    { return const_cast<Frame*>(this)->find(key, hash); }
+
+    T& insert(const string& key, size_t hash)
+    {
+      // keep the load factor at or below 1/2
+      if ((size_ + 1) * 2 > slots_.size()) grow();
+      Slot& s = slots_[probe(key, hash)];
+      if (!s.used) {
+        s.hash = hash;
+        s.key  = key;
+        s.used = true;
+        ++size_;
+      }
+      return s.value;
+    }
+
+    size_t count(const string& key) const
+    { return find(key, hash_key(key)) ? 1 : 0; }
+
+    T& operator[](const string& key)
+    { return insert(key, hash_key(key)); }
+
+    void print() const
+    {
+      for (size_t i = 0, S = slots_.size(); i < S; ++i) {
+        if (slots_[i].used) cerr << slots_[i].key << endl;
+      }
+    }
+  };
+
   template <typename T>
   class Environment {
-    // TODO: test with unordered_map
-    map<string, T> current_frame_;
+    Frame<T> current_frame_;
     ADD_PROPERTY(Environment*, parent);
 
   public:
-    Environment() : current_frame_(map<string, T>()), parent_(0) { }
+    Environment() : current_frame_(Frame<T>()), parent_(0) { }
 
-    map<string, T>& current_frame() { return current_frame_; }
+    Frame<T>& current_frame() { return current_frame_; }
+    const Frame<T>& current_frame() const { return current_frame_; }
 
     void link(Environment& env) { parent_ = &env; }
     void link(Environment* env) { parent_ = env; }
 
-    bool has(const string key) const
+    // Walks the chain of frames once, hashing the key only once. Returns a
+    // pointer to the binding, or null if the key isn't bound anywhere.
+    T* lookup(const string& key)
     {
-      if (current_frame_.count(key))  return true;
-      else if (parent_)               return parent_->has(key);
-      else                            return false;
+      size_t hash = hash_key(key);
+      for (Environment* e = this; e; e = e->parent_) {
+        if (T* found = e->current_frame_.find(key, hash)) return found;
+      }
+      return 0;
     }
 
-    bool current_frame_has(const string key) const
+    bool has(const string& key) const
+    { return const_cast<Environment*>(this)->lookup(key) != 0; }
+
+    bool current_frame_has(const string& key) const
     { return current_frame_.count(key); }
 
     Environment* grandparent() const
@@ -41,7 +145,7 @@ namespace Sass {
       else return 0;
     }
 
-    bool global_frame_has(const string key) const
+    bool global_frame_has(const string& key) const
     {
       if(parent_ && !grandparent()) {
         return has(key);
@@ -54,18 +158,21 @@ namespace Sass {
       }
     }
 
-    T& operator[](const string key)
+    // unbound keys are created in the outermost frame
+    T& operator[](const string& key)
     {
-      if (current_frame_.count(key))  return current_frame_[key];
-      else if (parent_)               return (*parent_)[key];
-      else                            return current_frame_[key];
+      size_t hash = hash_key(key);
+      Environment* e = this;
+      for (; ; e = e->parent_) {
+        if (T* found = e->current_frame_.find(key, hash)) return *found;
+        if (!e->parent_) break;
+      }
+      return e->current_frame_.insert(key, hash);
     }
 
     void print()
     {
-      for (typename map<string, T>::iterator i = current_frame_.begin(); i != current_frame_.end(); ++i) {
-        cerr << i->first << endl;
-      }
+      current_frame_.print();
       if (parent_) {
         cerr << "---" << endl;
         parent_->print();
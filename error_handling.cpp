@@ -19,7 +19,7 @@ namespace Sass {
     if (!path.empty() && Prelexer::string_constant(path.c_str()))
       path = path.substr(1, path.size() - 1);
 
-    Backtrace top(bt, path, position, "");
+    Backtrace top(bt, path.c_str(), position, "");
     msg += top.to_string();
 
     throw Error(Error::syntax, path, position, msg);
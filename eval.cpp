@@ -7,6 +7,7 @@
 #include "context.hpp"
 #include "backtrace.hpp"
 #include "prelexer.hpp"
+#include "color_names.hpp"
 
 #include <cstdlib>
 #include <cmath>
@@ -52,12 +53,11 @@ namespace Sass {
   Expression* Eval::operator()(Assignment* a)
   {
     string var(a->variable());
-    if (env->has(var)) {
-      if(!a->is_guarded()) (*env)[var] = a->value()->perform(this);
-    }
-    else {
-      env->current_frame()[var] = a->value()->perform(this);
-    }
+    if (a->is_guarded() && env->has(var)) return 0;
+    // evaluate first; the value may add bindings and move existing ones
+    Expression* value = a->value()->perform(this);
+    if (AST_Node** binding = env->lookup(var)) *binding = value;
+    else env->current_frame()[var] = value;
     return 0;
   }
 
@@ -184,26 +184,66 @@ namespace Sass {
 
   Expression* Eval::operator()(Binary_Expression* b)
   {
-    Binary_Expression::Type op_type = b->type();
-    // don't eval delayed expressions (the '/' when used as a separator)
-    if (op_type == Binary_Expression::DIV && b->is_delayed()) return b;
-    // the logical connectives need to short-circuit
-    Expression* lhs = b->left()->perform(this);
-    switch (op_type) {
-      case Binary_Expression::AND:
-        return *lhs ? b->right()->perform(this) : lhs;
-        break;
+    return box(unboxed(b), ctx);
+  }
 
-      case Binary_Expression::OR:
-        return *lhs ? lhs : b->right()->perform(this);
-        break;
+  // Evaluates an operand, leaving the numbers and booleans that arithmetic
+  // and comparisons make along the way unboxed.
+  Value Eval::unboxed(Expression* e)
+  {
+    const type_info& type = typeid(*e);
+    if (type == typeid(Binary_Expression)) {
+      Binary_Expression* b = static_cast<Binary_Expression*>(e);
+      Binary_Expression::Type op_type = b->type();
+      // don't eval delayed expressions (the '/' when used as a separator)
+      if (op_type == Binary_Expression::DIV && b->is_delayed()) return boxed(b);
+      // the logical connectives need to short-circuit
+      Value lhs = unboxed(b->left());
+      switch (op_type) {
+        case Binary_Expression::AND:
+          return is_true(lhs) ? unboxed(b->right()) : lhs;
+          break;
 
-      default:
-        break;
+        case Binary_Expression::OR:
+          return is_true(lhs) ? lhs : unboxed(b->right());
+          break;
+
+        default:
+          break;
+      }
+      // not a logical connective, so go ahead and eval the rhs
+      Value rhs = unboxed(b->right());
+      Value result;
+      if (op_unboxed(b, lhs, rhs, result)) return result;
+      return boxed(op_binary(ctx, b, box(lhs, ctx), box(rhs, ctx)));
+    }
+    if (type == typeid(Unary_Expression)) {
+      Unary_Expression* u = static_cast<Unary_Expression*>(e);
+      Value operand = unboxed(u->operand());
+      double n;
+      Unit unit;
+      if (as_number(operand, n, unit)) {
+        return unboxed_number(u->type() == Unary_Expression::MINUS ? -n : n, unit, operand.path, operand.node);
+      }
+      return boxed(op_unary(ctx, u, box(operand, ctx)));
+    }
+    if (type == typeid(Textual)) {
+      Textual* t = static_cast<Textual*>(e);
+      Unit unit;
+      switch (t->type()) {
+        case Textual::NUMBER:     unit = UNITLESS; break;
+        case Textual::PERCENTAGE: unit = PERCENT; break;
+        case Textual::DIMENSION:  unit = intern_unit(Token(Prelexer::number(t->value().c_str())).to_string()); break;
+        default:                  return boxed(t->perform(this));
+      }
+      return unboxed_number(atof(t->value().c_str()), unit, t->path(), t);
     }
-    // not a logical connective, so go ahead and eval the rhs
-    Expression* rhs = b->right()->perform(this);
+    return boxed(e->perform(this));
+  }
 
+  Expression* op_binary(Context& ctx, Binary_Expression* b, Expression* lhs, Expression* rhs)
+  {
+    Binary_Expression::Type op_type = b->type();
     // see if it's a relational expression
     switch(op_type) {
       case Binary_Expression::EQ:  return new (ctx.mem) Boolean(b->path(), b->position(), eq(lhs, rhs, ctx));
@@ -236,7 +276,11 @@ namespace Sass {
 
   Expression* Eval::operator()(Unary_Expression* u)
   {
-    Expression* operand = u->operand()->perform(this);
+    return box(unboxed(u), ctx);
+  }
+
+  Expression* op_unary(Context& ctx, Unary_Expression* u, Expression* operand)
+  {
     if (operand->concrete_type() == Expression::NUMBER) {
       Number* result = new (ctx.mem) Number(*static_cast<Number*>(operand));
       result->value(u->type() == Unary_Expression::MINUS
@@ -248,8 +292,12 @@ namespace Sass {
       To_String to_string;
       // Special cases: +/- variables which evaluate to null ouput just +/-,
       // but +/- null itself outputs the string
+      // (print a copy; the parsed node may be cached and evaluated again)
       if (operand->concrete_type() == Expression::NULL_VAL && typeid(*(u->operand())) == typeid(Variable)) {
-        u->operand(new (ctx.mem) String_Constant(u->path(), u->position(), ""));
+        u = new (ctx.mem) Unary_Expression(u->path(),
+                                           u->position(),
+                                           u->type(),
+                                           new (ctx.mem) String_Constant(u->path(), u->position(), ""));
       }
       String_Constant* result = new (ctx.mem) String_Constant(u->path(),
                                                               u->position(),
@@ -262,14 +310,20 @@ namespace Sass {
 
   Expression* Eval::operator()(Function_Call* c)
   {
-    string full_name(c->name() + "[f]");
     Arguments* args = c->arguments();
-    if (full_name != "if[f]") {
+    if (c->name() != "if") {
       args = static_cast<Arguments*>(args->perform(this));
     }
+    return call(c, args);
+  }
+
+  Expression* Eval::call(Function_Call* c, Arguments* args)
+  {
+    string full_name(c->name() + "[f]");
 
     // if it doesn't exist, just pass it through as a literal
-    if (!env->has(full_name)) {
+    AST_Node** binding = env->lookup(full_name);
+    if (!binding) {
       Function_Call* lit = new (ctx.mem) Function_Call(c->path(),
                                                        c->position(),
                                                        c->name(),
@@ -280,8 +334,9 @@ namespace Sass {
                                            lit->perform(&to_string));
     }
 
+    if (ctx.stats) ++ctx.stats->function_calls;
     Expression*     result = c;
-    Definition*     def    = static_cast<Definition*>((*env)[full_name]);
+    Definition*     def    = static_cast<Definition*>(*binding);
     Block*          body   = def->block();
     Native_Function func   = def->native_function();
     Sass_C_Function c_func = def->c_function();
@@ -292,6 +347,18 @@ namespace Sass {
       }
     }
 
+    // a call answered by the memo is still a call, if a cheap one
+    if (ctx.profiler) ctx.profiler->enter(def, ctx.mem.allocation_count());
+    string memo_key;
+    bool memoize = ctx.memoize_functions && ctx.function_memo.key(def, args, memo_key);
+    if (memoize) {
+      if (Expression* remembered = ctx.function_memo.find(memo_key, ctx.mem)) {
+        remembered->position(c->position());
+        if (ctx.profiler) ctx.profiler->leave(ctx.mem.allocation_count());
+        return remembered;
+      }
+    }
+
     Parameters* params = def->parameters();
     Env new_env;
     new_env.link(def->environment());
@@ -312,7 +379,14 @@ namespace Sass {
       Backtrace here(backtrace, c->path(), c->position(), ", in function `" + c->name() + "`");
       backtrace = &here;
 
-      result = body->perform(this);
+      Bytecode::Function* code = ctx.use_bytecode ? ctx.bytecode.compiled(def, *env, ctx) : 0;
+      if (code) {
+        if (ctx.stats) ++ctx.stats->bytecode_calls;
+        result = ctx.bytecode.run(code, ctx, *this);
+      }
+      else {
+        result = body->perform(this);
+      }
       if (!result) {
         error(string("function ") + c->name() + " did not return a value", c->path(), c->position());
       }
@@ -360,8 +434,9 @@ namespace Sass {
       stringstream ss;
       ss << full_name << arity;
       string resolved_name(ss.str());
-      if (!env->has(resolved_name)) error("overloaded function `" + string(c->name()) + "` given wrong number of arguments", c->path(), c->position());
-      Definition* resolved_def = static_cast<Definition*>((*env)[resolved_name]);
+      AST_Node** resolved = env->lookup(resolved_name);
+      if (!resolved) error("overloaded function `" + string(c->name()) + "` given wrong number of arguments", c->path(), c->position());
+      Definition* resolved_def = static_cast<Definition*>(*resolved);
       params = resolved_def->parameters();
       Env newer_env;
       newer_env.link(resolved_def->environment());
@@ -380,8 +455,9 @@ namespace Sass {
 
     // backtrace = here.parent;
     // env = old_env;
-    result->position(c->position());
-    return result;
+    if (ctx.profiler) ctx.profiler->leave(ctx.mem.allocation_count());
+    if (memoize) ctx.function_memo.remember(memo_key, result, ctx.mem);
+    return moved(result, c->position(), ctx);
   }
 
   Expression* Eval::operator()(Function_Call_Schema* s)
@@ -395,11 +471,9 @@ namespace Sass {
 
   Expression* Eval::operator()(Variable* v)
   {
-    To_String to_string;
-    string name(v->name());
-    Expression* value = 0;
-    if (env->has(name)) value = static_cast<Expression*>((*env)[name]);
-    else error("unbound variable " + v->name(), v->path(), v->position());
+    AST_Node** binding = env->lookup(v->name());
+    if (!binding) error("unbound variable " + v->name(), v->path(), v->position());
+    Expression* value = static_cast<Expression*>(*binding);
     // cerr << "name: " << v->name() << "; type: " << typeid(*value).name() << "; value: " << value->perform(&to_string) << endl;
     if (typeid(*value) == typeid(Argument)) value = static_cast<Argument*>(value)->value();
     // cerr << "\ttype is now: " << typeid(*value).name() << endl << endl;
@@ -427,7 +501,7 @@ namespace Sass {
         result = new (ctx.mem) Number(t->path(),
                                       t->position(),
                                       atof(t->value().c_str()),
-                                      Token(number(t->value().c_str())));
+                                      Token(number(t->value().c_str())).to_string());
         break;
       case Textual::HEX: {
         string hext(t->value().substr(1)); // chop off the '#'
@@ -499,11 +573,9 @@ namespace Sass {
 
   Expression* Eval::operator()(String_Constant* s)
   {
-    if (!s->is_delayed() && ctx.names_to_colors.count(s->value())) {
-      Color* c = new (ctx.mem) Color(*ctx.names_to_colors[s->value()]);
-      c->path(s->path());
-      c->position(s->position());
-      return c;
+    int rgb;
+    if (!s->is_delayed() && (rgb = name_to_color(s->value())) >= 0) {
+      return new (ctx.mem) Color(s->path(), s->position(), rgb >> 16, (rgb >> 8) & 0xff, rgb & 0xff);
     }
     return s;
   }
@@ -544,10 +616,8 @@ namespace Sass {
 
   Expression* Eval::operator()(Argument* a)
   {
-    Expression* val = a->value();
-    val->is_delayed(false);
-    val = val->perform(this);
-    val->is_delayed(false);
+    Expression* val = undelayed(a->value(), ctx)->perform(this);
+    val = undelayed(val, ctx);
     if (a->is_rest_argument() && (val->concrete_type() != Expression::LIST)) {
       List* wrapper = new (ctx.mem) List(val->path(),
                                          val->position(),
@@ -597,7 +667,7 @@ namespace Sass {
         Number* r = static_cast<Number*>(rhs);
         Number tmp_r(*r);
         tmp_r.normalize(l->find_convertible_unit());
-        return l->unit() == tmp_r.unit() && l->value() == tmp_r.value()
+        return l->units() == tmp_r.units() && l->value() == tmp_r.value()
                ? true
                : false;
       } break;
@@ -645,9 +715,7 @@ namespace Sass {
     Number* r = static_cast<Number*>(rhs);
     Number tmp_r(*r);
     tmp_r.normalize(l->find_convertible_unit());
-    string l_unit(l->unit());
-    string r_unit(tmp_r.unit());
-    if (!l_unit.empty() && !r_unit.empty() && l->unit() != tmp_r.unit()) {
+    if (!l->is_unitless() && !tmp_r.is_unitless() && l->units() != tmp_r.units()) {
       error("cannot compare numbers with incompatible units", l->path(), l->position());
     }
     return l->value() < tmp_r.value();
@@ -669,35 +737,27 @@ namespace Sass {
 
     Number tmp(*r);
     tmp.normalize(l->find_convertible_unit());
-    string l_unit(l->unit());
-    string r_unit(tmp.unit());
-    if (l_unit != r_unit && !l_unit.empty() && !r_unit.empty() &&
+    bool l_unitless = l->is_unitless();
+    if (l->units() != tmp.units() && !l_unitless && !tmp.is_unitless() &&
         (op == Binary_Expression::ADD || op == Binary_Expression::SUB)) {
       error("cannot add or subtract numbers with incompatible units", l->path(), l->position());
     }
+    // sums and remainders are in the left-hand side's units
+    if (op == Binary_Expression::ADD || op == Binary_Expression::SUB || op == Binary_Expression::MOD) {
+      rv = tmp.value();
+    }
     Number* v = new (ctx.mem) Number(*l);
     v->position(b->position());
-    if (l_unit.empty() && (op == Binary_Expression::ADD || op == Binary_Expression::SUB)) {
-      v->numerator_units() = r->numerator_units();
-      v->denominator_units() = r->denominator_units();
+    if (l_unitless && (op == Binary_Expression::ADD || op == Binary_Expression::SUB)) {
+      v->units() = r->units();
     }
 
     v->value(ops[op](lv, rv));
     if (op == Binary_Expression::MUL) {
-      for (size_t i = 0, S = r->numerator_units().size(); i < S; ++i) {
-        v->numerator_units().push_back(r->numerator_units()[i]);
-      }
-      for (size_t i = 0, S = r->denominator_units().size(); i < S; ++i) {
-        v->denominator_units().push_back(r->denominator_units()[i]);
-      }
+      v->units().multiply(r->units());
     }
     else if (op == Binary_Expression::DIV) {
-      for (size_t i = 0, S = r->numerator_units().size(); i < S; ++i) {
-        v->denominator_units().push_back(r->numerator_units()[i]);
-      }
-      for (size_t i = 0, S = r->denominator_units().size(); i < S; ++i) {
-        v->numerator_units().push_back(r->denominator_units()[i]);
-      }
+      v->units().divide(r->units());
     }
     v->normalize();
     return v;
@@ -774,6 +834,9 @@ namespace Sass {
                                l->a());
   }
 
+  static Color* named_color(Context& ctx, int rgb)
+  { return new (ctx.mem) Color("[COLOR TABLE]", Position(), rgb >> 16, (rgb >> 8) & 0xff, rgb & 0xff); }
+
   Expression* op_strings(Context& ctx, Binary_Expression::Type op, Expression* lhs, Expression*rhs)
   {
     To_String to_string;
@@ -790,17 +853,16 @@ namespace Sass {
     string rstr(rhs->perform(&to_string));
     bool unquoted = false;
     if (ltype == Expression::STRING && lstr[0] != '"' && lstr[0] != '\'') unquoted = true;
-    if (ltype == Expression::STRING && !lhs->is_delayed() && ctx.names_to_colors.count(lstr) &&
-        rtype == Expression::STRING && !rhs->is_delayed() && ctx.names_to_colors.count(rstr)) {
-      return op_colors(ctx, op, ctx.names_to_colors[lstr], ctx.names_to_colors[rstr]);
+    int lcolor = ltype == Expression::STRING && !lhs->is_delayed() ? name_to_color(lstr) : -1;
+    int rcolor = rtype == Expression::STRING && !rhs->is_delayed() ? name_to_color(rstr) : -1;
+    if (lcolor >= 0 && rcolor >= 0) {
+      return op_colors(ctx, op, named_color(ctx, lcolor), named_color(ctx, rcolor));
     }
-    else if (ltype == Expression::STRING && !lhs->is_delayed() && ctx.names_to_colors.count(lstr) &&
-             rtype == Expression::NUMBER) {
-      return op_color_number(ctx, op, ctx.names_to_colors[lstr], rhs);
+    else if (lcolor >= 0 && rtype == Expression::NUMBER) {
+      return op_color_number(ctx, op, named_color(ctx, lcolor), rhs);
     }
-    else if (ltype == Expression::NUMBER &&
-             rtype == Expression::STRING && !rhs->is_delayed() && ctx.names_to_colors.count(rstr)) {
-      return op_number_color(ctx, op, rhs, ctx.names_to_colors[rstr]);
+    else if (ltype == Expression::NUMBER && rcolor >= 0) {
+      return op_number_color(ctx, op, rhs, named_color(ctx, rcolor));
     }
     if (op == Binary_Expression::MUL) error("invalid operands for multiplication", lhs->path(), lhs->position());
     if (op == Binary_Expression::MOD) error("invalid operands for modulo", lhs->path(), lhs->position());
@@ -819,7 +881,7 @@ namespace Sass {
                                unquoted ? result : quote(result, q));
   }
 
-  Expression* cval_to_astnode(Sass_Value v, Context& ctx, Backtrace* backtrace, string path, Position position)
+  Expression* cval_to_astnode(Sass_Value v, Context& ctx, Backtrace* backtrace, const char* path, Position position)
   {
     using std::strlen;
     using std::strcpy;
@@ -854,4 +916,38 @@ namespace Sass {
     return e;
   }
 
+  // Parsed trees may be cached and evaluated by several compiles at once,
+  // so evaluation copies a value before changing it whenever the value may
+  // be a parsed node. Other expressions are only ever made by evaluation.
+  Expression* copy_value(Expression* e, Context& ctx)
+  {
+    const type_info& type = typeid(*e);
+    if (type == typeid(Number))            return new (ctx.mem) Number(*static_cast<Number*>(e));
+    if (type == typeid(Color))             return new (ctx.mem) Color(*static_cast<Color*>(e));
+    if (type == typeid(String_Constant))   return new (ctx.mem) String_Constant(*static_cast<String_Constant*>(e));
+    if (type == typeid(Boolean))           return new (ctx.mem) Boolean(*static_cast<Boolean*>(e));
+    if (type == typeid(Null))              return new (ctx.mem) Null(*static_cast<Null*>(e));
+    if (type == typeid(List))              return new (ctx.mem) List(*static_cast<List*>(e));
+    if (type == typeid(Textual))           return new (ctx.mem) Textual(*static_cast<Textual*>(e));
+    if (type == typeid(Binary_Expression)) return new (ctx.mem) Binary_Expression(*static_cast<Binary_Expression*>(e));
+    return e;
+  }
+
+  Expression* undelayed(Expression* e, Context& ctx)
+  {
+    if (!e->is_delayed()) return e;
+    e = copy_value(e, ctx);
+    e->is_delayed(false);
+    return e;
+  }
+
+  Expression* moved(Expression* e, Position position, Context& ctx)
+  {
+    Position p(e->position());
+    if (p.file == position.file && p.line == position.line && p.column == position.column) return e;
+    e = copy_value(e, ctx);
+    e->position(position);
+    return e;
+  }
+
 }
@@ -18,6 +18,10 @@
 #include "position.hpp"
 #endif
 
+#ifndef SASS_VALUE
+#include "value.hpp"
+#endif
+
 namespace Sass {
   using namespace std;
 
@@ -30,6 +34,7 @@ namespace Sass {
     Context&   ctx;
 
     Expression* fallback_impl(AST_Node* n);
+    Value unboxed(Expression* e);
 
   public:
     Env*       env;
@@ -37,6 +42,8 @@ namespace Sass {
     Eval(Context&, Env*, Backtrace*);
     virtual ~Eval();
     Eval* with(Env* e, Backtrace* bt); // for setting the env before eval'ing an expression
+    // calls c with arguments already evaluated (or, for if(), not)
+    Expression* call(Function_Call* c, Arguments* args);
     using Operation<Expression*>::operator();
 
     // for evaluating function bodies
@@ -70,8 +77,17 @@ namespace Sass {
     Expression* fallback(U x) { return fallback_impl(x); }
   };
 
-  Expression* cval_to_astnode(Sass_Value v, Context& ctx, Backtrace* backtrace, string path = "", Position position = Position());
+  Expression* cval_to_astnode(Sass_Value v, Context& ctx, Backtrace* backtrace, const char* path = "", Position position = Position());
+
+  // the operators applied to evaluated operands
+  Expression* op_binary(Context&, Binary_Expression*, Expression*, Expression*);
+  Expression* op_unary(Context&, Unary_Expression*, Expression*);
 
   bool eq(Expression*, Expression*, Context&);
   bool lt(Expression*, Expression*, Context&);
+  // copies made in ctx.mem, so that nodes of (possibly shared) parsed trees
+  // are never changed: e itself when it already is as asked
+  Expression* copy_value(Expression* e, Context& ctx);
+  Expression* undelayed(Expression* e, Context& ctx);
+  Expression* moved(Expression* e, Position position, Context& ctx);
 }
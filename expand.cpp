@@ -13,6 +13,7 @@
 #endif
 
 #include "parser.hpp"
+#include "normalize.hpp"
 
 namespace Sass {
 
@@ -45,8 +46,11 @@ namespace Sass {
     To_String to_string;
     // if (selector_stack.back()) cerr << "expanding " << selector_stack.back()->perform(&to_string) << " and " << r->selector()->perform(&to_string) << endl;
     Selector* sel_ctx = r->selector()->perform(contextualize->with(selector_stack.back(), env, backtrace));
-    // re-parse in order to restructure parent nodes correctly
-    sel_ctx = Parser::from_c_str((sel_ctx->perform(&to_string) + ";").c_str(), ctx, r->selector()->path(), r->selector()->position()).parse_selector_group();
+    // restructure parent nodes correctly; re-parse only if that can't be done in place
+    Normalize normalize(ctx);
+    Selector* normalized = normalize(sel_ctx);
+    if (normalized) sel_ctx = normalized;
+    else sel_ctx = Parser::from_c_str((sel_ctx->perform(&to_string) + ";").c_str(), ctx, r->selector()->path(), r->selector()->position()).parse_selector_group();
     selector_stack.push_back(sel_ctx);
     Ruleset* rr = new (ctx.mem) Ruleset(r->path(),
                                         r->position(),
@@ -132,12 +136,11 @@ namespace Sass {
   Statement* Expand::operator()(Assignment* a)
   {
     string var(a->variable());
-    if (env->has(var)) {
-      if(!a->is_guarded()) (*env)[var] = a->value()->perform(eval->with(env, backtrace));
-    }
-    else {
-      env->current_frame()[var] = a->value()->perform(eval->with(env, backtrace));
-    }
+    if (a->is_guarded() && env->has(var)) return 0;
+    // evaluate first; the value may add bindings and move existing ones
+    Expression* value = a->value()->perform(eval->with(env, backtrace));
+    if (AST_Node** binding = env->lookup(var)) *binding = value;
+    else env->current_frame()[var] = value;
     return 0;
   }
 
@@ -227,7 +230,8 @@ namespace Sass {
     env = &new_env;
     Block* body = e->block();
     for (size_t i = 0, L = list->length(); i < L; ++i) {
-      (*env)[variable] = (*list)[i]->perform(eval->with(env, backtrace));
+      Expression* value = (*list)[i]->perform(eval->with(env, backtrace));
+      (*env)[variable] = value;
       append_block(body);
     }
     env = new_env.parent();
@@ -274,7 +278,7 @@ namespace Sass {
       ctx.extensions.insert(make_pair(*s, (*extender)[i]));
       // let's test this out
       // cerr << "REGISTERING EXTENSION REQUEST: " << (*extender)[i]->perform(&to_string) << " <- " << s->perform(&to_string) << endl;
-      ctx.subset_map.put(s->to_str_vec(), make_pair((*extender)[i], s));
+      ctx.subset_map.put(s->elements(), make_pair((*extender)[i], s));
     }
     return 0;
   }
@@ -286,20 +290,25 @@ namespace Sass {
                         (d->type() == Definition::MIXIN ? "[m]" : "[f]")] = dd;
     // set the static link so we can have lexical scoping
     dd->environment(env);
+    // callers may now reach a different function by this name
+    if (ctx.memoize_functions && d->type() == Definition::FUNCTION) ctx.function_memo.forget();
     return 0;
   }
 
   Statement* Expand::operator()(Mixin_Call* c)
   {
     string full_name(c->name() + "[m]");
-    if (!env->has(full_name)) {
+    AST_Node** binding = env->lookup(full_name);
+    if (!binding) {
       error("no mixin named " + c->name(), c->path(), c->position(), backtrace);
     }
-    Definition* def = static_cast<Definition*>((*env)[full_name]);
+    if (ctx.stats) ++ctx.stats->mixin_calls;
+    Definition* def = static_cast<Definition*>(*binding);
     Block* body = def->block();
     Parameters* params = def->parameters();
     Arguments* args = static_cast<Arguments*>(c->arguments()
                                                ->perform(eval->with(env, backtrace)));
+    if (ctx.profiler) ctx.profiler->enter(def, ctx.mem.allocation_count());
     Backtrace here(backtrace, c->path(), c->position(), ", in mixin `" + c->name() + "`");
     backtrace = &here;
     Env new_env;
@@ -321,6 +330,7 @@ namespace Sass {
     append_block(body);
     env = old_env;
     backtrace = here.parent;
+    if (ctx.profiler) ctx.profiler->leave(ctx.mem.allocation_count());
     return 0;
   }
 
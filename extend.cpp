@@ -5,11 +5,12 @@
 #include "backtrace.hpp"
 #include "paths.hpp"
 #include "parser.hpp"
+#include "normalize.hpp"
 #include <iostream>
 
 namespace Sass {
 
-  Extend::Extend(Context& ctx, multimap<Compound_Selector, Complex_Selector*>& extensions, Subset_Map<string, pair<Complex_Selector*, Compound_Selector*> >& ssm, Backtrace* bt)
+  Extend::Extend(Context& ctx, multimap<Compound_Selector, Complex_Selector*>& extensions, Subset_Map<Simple_Selector*, pair<Complex_Selector*, Compound_Selector*>, Simple_Selector_Less>& ssm, Backtrace* bt)
   : ctx(ctx), extensions(extensions), subset_map(ssm), backtrace(bt)
   { }
 
@@ -80,15 +81,18 @@ namespace Sass {
 
 
     if (all_subbed->length()) {
-      // re-parse in order to restructure expanded placeholder nodes correctly
-      r->selector(
-        Parser::from_c_str(
+      // restructure expanded placeholder nodes correctly; re-parse only if that can't be done in place
+      Normalize normalize(ctx);
+      Selector_List* normalized = normalize(all_subbed);
+      if (!normalized) {
+        normalized = Parser::from_c_str(
           (all_subbed->perform(&to_string) + ";").c_str(),
           ctx,
           all_subbed->path(),
           all_subbed->position()
-        ).parse_selector_group()
-      );
+        ).parse_selector_group();
+      }
+      r->selector(normalized);
     }
 
     // let's try the new stuff here; eventually it should replace the preceding
@@ -270,16 +274,18 @@ namespace Sass {
     Selector_List* results = new (ctx.mem) Selector_List(sel->path(), sel->position());
 
     // TODO: Do we need to group the results by extender?
-    vector<pair<Complex_Selector*, Compound_Selector*> > entries = subset_map.get_v(sel->to_str_vec());
+    vector<size_t> indices;
+    subset_map.get_indices(sel->elements(), indices);
 
-    for (size_t i = 0, S = entries.size(); i < S; ++i)
+    for (size_t k = 0, S = indices.size(); k < S; ++k)
     {
-      if (seen.count(*entries[i].second)) continue;
-      // cerr << "COMPOUND: " << sel->perform(&to_string) << " KEYS TO " << entries[i].first->perform(&to_string) << " AND " << entries[i].second->perform(&to_string) << endl;
-      Compound_Selector* diff = sel->minus(entries[i].second, ctx);
-      Compound_Selector* last = entries[i].first->base();
+      const pair<Complex_Selector*, Compound_Selector*>& entry = subset_map.value(indices[k]);
+      if (seen.count(*entry.second)) continue;
+      // cerr << "COMPOUND: " << sel->perform(&to_string) << " KEYS TO " << entry.first->perform(&to_string) << " AND " << entry.second->perform(&to_string) << endl;
+      Compound_Selector* diff = sel->minus(entry.second, ctx);
+      Compound_Selector* last = entry.first->base();
       if (!last) last = new (ctx.mem) Compound_Selector(sel->path(), sel->position());
-      // cerr << sel->perform(&to_string) << " - " << entries[i].second->perform(&to_string) << " = " << diff->perform(&to_string) << endl;
+      // cerr << sel->perform(&to_string) << " - " << entry.second->perform(&to_string) << " = " << diff->perform(&to_string) << endl;
       // cerr << "LAST: " << last->perform(&to_string) << endl;
       Compound_Selector* unif;
       if (last->length() == 0) unif = diff;
@@ -287,7 +293,7 @@ namespace Sass {
       else unif = last->unify_with(diff, ctx);
       // if (unif) cerr << "UNIFIED: " << unif->perform(&to_string) << endl;
       if (!unif || unif->length() == 0) continue;
-      Complex_Selector* cplx = entries[i].first->clone(ctx);
+      Complex_Selector* cplx = entry.first->clone(ctx);
       // cerr << "cplx: " << cplx->perform(&to_string) << endl;
       Complex_Selector* new_innermost = new (ctx.mem) Complex_Selector(sel->path(), sel->position(), Complex_Selector::ANCESTOR_OF, unif, 0);
       // cerr << "new_innermost: " << new_innermost->perform(&to_string) << endl;
@@ -295,7 +301,7 @@ namespace Sass {
       // cerr << "new cplx: " << cplx->perform(&to_string) << endl;
       *results << cplx;
       set<Compound_Selector> seen2 = seen;
-      seen2.insert(*entries[i].second);
+      seen2.insert(*entry.second);
       Selector_List* ex2 = extend_complex(cplx, seen2);
       *results += ex2;
       // cerr << "RECURSIVELY CALLING EXTEND_COMPLEX ON " << cplx->perform(&to_string) << endl;
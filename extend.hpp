@@ -27,14 +27,14 @@ namespace Sass {
 
     Context&          ctx;
     multimap<Compound_Selector, Complex_Selector*>& extensions;
-    Subset_Map<string, pair<Complex_Selector*, Compound_Selector*> >& subset_map;
+    Subset_Map<Simple_Selector*, pair<Complex_Selector*, Compound_Selector*>, Simple_Selector_Less>& subset_map;
 
     Backtrace*        backtrace;
 
     void fallback_impl(AST_Node* n) { };
 
   public:
-    Extend(Context&, multimap<Compound_Selector, Complex_Selector*>&, Subset_Map<string, pair<Complex_Selector*, Compound_Selector*> >&, Backtrace*);
+    Extend(Context&, multimap<Compound_Selector, Complex_Selector*>&, Subset_Map<Simple_Selector*, pair<Complex_Selector*, Compound_Selector*>, Simple_Selector_Less>&, Backtrace*);
     virtual ~Extend() { }
 
     using Operation<void>::operator();
@@ -1,5 +1,18 @@
 #ifdef _WIN32
 #define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
+#include <io.h>
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <dirent.h>
+#endif
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define SASS_MAP_SOURCES
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 #endif
 
 #ifndef FS_CASE_SENSITIVE
@@ -14,6 +27,10 @@
 #include <fstream>
 #include <cctype>
 #include <algorithm>
+#include <map>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
 #include <sys/stat.h>
 #include "file.hpp"
 #include "context.hpp"
@@ -171,47 +188,32 @@ namespace Sass {
       return result;
     }
 
-    char* resolve_and_load(string path, string& real_path)
+    char* resolve_and_load(string path, string& real_path, Import_Cache::Session* imports, size_t* fs_calls)
     {
       // Resolution order for ambiguous imports:
       // (1) filename as given
       // (2) underscore + given
       // (3) underscore + given + extension
       // (4) given + extension
+      string dir(dir_name(path));
+      string base(base_name(path));
+      string names[] = {
+        base, "_" + base, "_" + base + ".scss", "_" + base + ".sass", base + ".scss", base + ".sass"
+      };
+      const size_t n = sizeof(names) / sizeof(names[0]);
+      bool cached = imports && imports->cache;
+      bool listed[n];
+      size_t calls = 0;
+      if (cached) imports->cache->find(*imports, dir, names, n, listed, calls);
       char* contents = 0;
-      real_path = path;
-      // if the file isn't found with the given filename ...
-      if (!(contents = read_file(real_path))) {
-        string dir(dir_name(path));
-        string base(base_name(path));
-        string _base("_" + base);
-        real_path = dir + _base;
-        // if the file isn't found with '_' + filename ...
-        if (!(contents = read_file(real_path))) {
-          string _base_scss(_base + ".scss");
-          real_path = dir + _base_scss;
-          // if the file isn't found with '_' + filename + ".scss" ...
-          if (!(contents = read_file(real_path))) {
-            string _base_sass(_base + ".sass");
-            real_path = dir + _base_sass;
-            // if the file isn't found with '_' + filename + ".sass" ...
-            if (!(contents = read_file(real_path))) {
-              string base_scss(base + ".scss");
-              real_path = dir + base_scss;
-              // if the file isn't found with filename + ".scss" ...
-              if (!(contents = read_file(real_path))) {
-                string base_sass(base + ".sass");
-                real_path = dir + base_sass;
-                // if the file isn't found with filename + ".sass" ...
-                if (!(contents = read_file(real_path))) {
-                  // default back to scss version
-                  real_path = dir + base_scss;
-                }
-              }
-            }
-          }
-        }
+      for (size_t i = 0; i < n && !contents; ++i) {
+        if (cached && !listed[i]) continue;
+        real_path = i ? dir + names[i] : path;
+        contents = read_file(real_path, &calls);
       }
+      // default back to scss version
+      if (!contents) real_path = dir + names[4];
+      if (fs_calls) *fs_calls += calls;
 #ifdef _WIN32
       // convert Windows backslashes to URL forward slashes
       replace(real_path.begin(), real_path.end(), '\\', '/');
@@ -219,15 +221,87 @@ namespace Sass {
       return contents;
     }
 
-    char* read_file(string path)
+    // Below this, a read is cheaper than setting up and tearing down a
+    // mapping.
+    static const size_t min_mapped_size = 64 * 1024;
+
+    static size_t mapped_bytes = 0;
+    static size_t copied_bytes = 0;
+
+#ifdef SASS_MAP_SOURCES
+    static pthread_mutex_t file_mutex = PTHREAD_MUTEX_INITIALIZER;
+    // lengths of the mappings handed out, so release_file knows to unmap
+    static map<const char*, size_t> mappings;
+#endif
+
+    // parse workers load files concurrently
+    static void lock()
+    {
+#ifdef SASS_MAP_SOURCES
+      pthread_mutex_lock(&file_mutex);
+#endif
+    }
+
+    static void unlock()
+    {
+#ifdef SASS_MAP_SOURCES
+      pthread_mutex_unlock(&file_mutex);
+#endif
+    }
+
+#ifdef SASS_MAP_SOURCES
+
+    // Maps the file privately, so that the null written after its last byte
+    // copies only the last page and later writes to the file can't remove
+    // it. Returns 0 when the file is better (or only) read instead: small
+    // ones, and those ending on a page boundary, which leave no room for
+    // the null. Truncating a file while it's mapped makes reads of the
+    // lost pages fault, as it does for every other program that maps it.
+    static char* map_file(const string& path, size_t& fs_calls)
+    {
+      ++fs_calls;
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd == -1) return 0;
+      struct stat st;
+      char* contents = 0;
+      size_t size = 0;
+      if (fstat(fd, &st) != -1 && S_ISREG(st.st_mode)) {
+        size = st.st_size;
+        if (size >= min_mapped_size && size % sysconf(_SC_PAGESIZE)) {
+          void* p = mmap(0, size + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+          if (p != MAP_FAILED) contents = static_cast<char*>(p);
+        }
+      }
+      close(fd);
+      if (!contents) return 0;
+      contents[size] = '\0';
+      lock();
+      mappings[contents] = size + 1;
+      mapped_bytes += size;
+      unlock();
+      return contents;
+    }
+#endif
+
+    static char* load_file(const string& path, size_t& fs_calls)
     {
       struct stat st;
+      ++fs_calls;
       if (stat(path.c_str(), &st) == -1 || S_ISDIR(st.st_mode)) return 0;
-      ifstream file(path.c_str(), ios::in | ios::binary | ios::ate);
       string extension;
       if (path.length() > 5) {
         extension = path.substr(path.length() - 5, 5);
       }
+      for(size_t i=0; i<extension.size();++i)
+        extension[i] = tolower(extension[i]);
+#ifdef SASS_MAP_SOURCES
+      // the indented syntax is converted into a new buffer anyway
+      if (extension != ".sass" && size_t(st.st_size) >= min_mapped_size) {
+        if (char* contents = map_file(path, fs_calls)) return contents;
+      }
+#endif
+      ++fs_calls;
+      ifstream file(path.c_str(), ios::in | ios::binary | ios::ate);
       char* contents = 0;
       if (file.is_open()) {
         size_t size = file.tellg();
@@ -236,9 +310,10 @@ namespace Sass {
         file.read(contents, size);
         contents[size] = '\0';
         file.close();
+        lock();
+        copied_bytes += size;
+        unlock();
       }
-      for(size_t i=0; i<extension.size();++i)
-        extension[i] = tolower(extension[i]);
       if (extension == ".sass" && contents != 0) {
         char * converted = sass2scss(contents, SASS2SCSS_PRETTIFY_1 | SASS2SCSS_STRIP_COMMENT);
         delete[] contents; // free the indented contents
@@ -248,5 +323,102 @@ namespace Sass {
       }
     }
 
+    char* read_file(string path, size_t* fs_calls)
+    {
+      size_t calls = 0;
+      char* contents = load_file(path, calls);
+      if (fs_calls) *fs_calls += calls;
+      return contents;
+    }
+
+    void release_file(char* contents)
+    {
+#ifdef SASS_MAP_SOURCES
+      lock();
+      map<const char*, size_t>::iterator mapping = mappings.find(contents);
+      if (mapping != mappings.end()) {
+        size_t length = mapping->second;
+        mappings.erase(mapping);
+        unlock();
+        munmap(contents, length);
+        return;
+      }
+      unlock();
+#endif
+      delete[] contents;
+    }
+
+    size_t bytes_mapped()
+    {
+      lock();
+      size_t n = mapped_bytes;
+      unlock();
+      return n;
+    }
+
+    size_t bytes_copied()
+    {
+      lock();
+      size_t n = copied_bytes;
+      unlock();
+      return n;
+    }
+
+
+    // Collects the paths (relative to dir) of all non-partial .scss and .sass
+    // files below dir, in sorted order.
+    void find_style_sheets(string dir, vector<string>& found, string rel_dir)
+    {
+      vector<string> names;
+      string full_dir(join_paths(dir, rel_dir));
+#ifdef _WIN32
+      _finddata_t entry;
+      intptr_t handle = _findfirst(join_paths(full_dir, "*").c_str(), &entry);
+      if (handle == -1) return;
+      do names.push_back(entry.name); while (_findnext(handle, &entry) == 0);
+      _findclose(handle);
+#else
+      DIR* handle = opendir(full_dir.empty() ? "." : full_dir.c_str());
+      if (!handle) return;
+      while (dirent* entry = readdir(handle)) names.push_back(entry->d_name);
+      closedir(handle);
+#endif
+      sort(names.begin(), names.end());
+      for (size_t i = 0, S = names.size(); i < S; ++i) {
+        const string& name = names[i];
+        if (name[0] == '.') continue;
+        string rel_path(rel_dir.empty() ? name : join_paths(rel_dir, name));
+        struct stat st;
+        if (stat(join_paths(dir, rel_path).c_str(), &st) == -1) continue;
+        if (S_ISDIR(st.st_mode)) {
+          find_style_sheets(dir, found, rel_path);
+          continue;
+        }
+        if (name[0] == '_' || name.length() <= 5) continue;
+        string extension(name.substr(name.length() - 5));
+        for (size_t j = 0; j < extension.size(); ++j) extension[j] = tolower(extension[j]);
+        if (extension == ".scss" || extension == ".sass") found.push_back(rel_path);
+      }
+    }
+
+    bool make_directories(string path)
+    {
+      path = make_canonical_path(path);
+      for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        string prefix(path.substr(0, pos));
+        if (!prefix.empty() && mkdir(prefix.c_str(), 0777) == -1 && errno != EEXIST) return false;
+        if (pos == string::npos || pos + 1 == path.length()) return true;
+      }
+    }
+
+    bool write_file(string path, const char* contents)
+    {
+      FILE* file = fopen(path.c_str(), "wb");
+      if (!file) return false;
+      size_t length = strlen(contents);
+      bool written = fwrite(contents, 1, length, file) == length;
+      return fclose(file) == 0 && written;
+    }
+
   }
 }
@@ -1,4 +1,9 @@
 #include <string>
+#include <vector>
+
+#ifndef SASS_IMPORT_CACHE
+#include "import_cache.hpp"
+#endif
 
 namespace Sass {
   using namespace std;
@@ -11,7 +16,19 @@ namespace Sass {
     string make_canonical_path (string path);
     string make_absolute_path(const string& path, const string& cwd);
     string resolve_relative_path(const string& uri, const string& base, const string& cwd);
-    char* resolve_and_load(string path, string& real_path);
-    char* read_file(string path);
+    // Both count the stats, opens and directory listings they make in
+    // fs_calls, when given. With an import cache, only the names it lists
+    // are read.
+    char* resolve_and_load(string path, string& real_path, Import_Cache::Session* imports = 0, size_t* fs_calls = 0);
+    // Returns the null-terminated contents of a file, which may be mapped
+    // rather than copied; either way, give them back with release_file.
+    char* read_file(string path, size_t* fs_calls = 0);
+    void release_file(char* contents);
+    // Totals over everything read_file has loaded, process-wide.
+    size_t bytes_mapped();
+    size_t bytes_copied();
+    void find_style_sheets(string dir, vector<string>& found, string rel_dir = "");
+    bool make_directories(string path);
+    bool write_file(string path, const char* contents);
   }
 }
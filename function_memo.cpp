@@ -0,0 +1,348 @@
+#include <typeinfo>
+#include <cstdio>
+
+#ifndef SASS_FUNCTION_MEMO
+#include "function_memo.hpp"
+#endif
+
+#ifndef SASS_AST
+#include "ast.hpp"
+#endif
+
+#ifndef SASS_OPERATION
+#include "operation.hpp"
+#endif
+
+#include "functions.hpp"
+
+namespace Sass {
+
+  // Finds out what a function body does, short of running it. Anything it
+  // doesn't know about makes the definition impure.
+  class Memo_Scan : public Operation_CRTP<void, Memo_Scan> {
+    Env*                   env;
+    Function_Memo::Scan&   scan;
+    vector<string>         bound;    // parameters and loop variables in scope
+    set<string>            assigned;
+
+    bool is_bound(const string& name) const
+    { return find(bound.begin(), bound.end(), name) != bound.end(); }
+
+  public:
+    Memo_Scan(Env* env, Function_Memo::Scan& scan)
+    : env(env), scan(scan), bound(vector<string>()), assigned(set<string>())
+    { }
+    using Operation<void>::operator();
+
+    void definition(Definition* def)
+    {
+      Parameters* params = def->parameters();
+      for (size_t i = 0, L = params ? params->length() : 0; i < L; ++i) {
+        // a default may use the parameters before it
+        if ((*params)[i]->default_value()) (*params)[i]->default_value()->perform(this);
+        bound.push_back((*params)[i]->name());
+      }
+      if (def->block()) def->block()->perform(this);
+      for (set<string>::iterator a = assigned.begin(); a != assigned.end(); ++a) scan.reads.erase(*a);
+    }
+
+    void operator()(Block* b)
+    { for (size_t i = 0, L = b->length(); i < L; ++i) (*b)[i]->perform(this); }
+
+    void operator()(Assignment* a)
+    {
+      if (a->is_global()) scan.pure = false;
+      a->value()->perform(this);
+      assigned.insert(a->variable());
+      if (!is_bound(a->variable())) scan.writes.insert(a->variable());
+    }
+
+    void operator()(If* i)
+    {
+      i->predicate()->perform(this);
+      i->consequent()->perform(this);
+      if (i->alternative()) i->alternative()->perform(this);
+    }
+
+    void operator()(For* f)
+    {
+      f->lower_bound()->perform(this);
+      f->upper_bound()->perform(this);
+      bound.push_back(f->variable());
+      f->block()->perform(this);
+      bound.pop_back();
+    }
+
+    void operator()(Each* e)
+    {
+      e->list()->perform(this);
+      bound.push_back(e->variable());
+      e->block()->perform(this);
+      bound.pop_back();
+    }
+
+    void operator()(While* w)
+    {
+      w->predicate()->perform(this);
+      w->block()->perform(this);
+    }
+
+    void operator()(Return* r)      { r->value()->perform(this); }
+    void operator()(Comment*)       { }
+    void operator()(Warning*)       { scan.pure = false; }
+
+    void operator()(List* l)
+    { for (size_t i = 0, L = l->length(); i < L; ++i) (*l)[i]->perform(this); }
+
+    void operator()(Binary_Expression* b)
+    {
+      b->left()->perform(this);
+      b->right()->perform(this);
+    }
+
+    void operator()(Unary_Expression* u) { u->operand()->perform(this); }
+
+    void operator()(Function_Call* c)
+    {
+      c->arguments()->perform(this);
+      AST_Node** binding = env->lookup(c->name() + "[f]");
+      // an unknown function is output as it was written
+      if (!binding) return;
+      Definition* def = static_cast<Definition*>(*binding);
+      if (def->block()) scan.callees.push_back(def);
+      else if (def->c_function()) scan.pure = false;
+      else if (!def->is_overload_stub() && !Function_Memo::is_pure(def->native_function())) scan.pure = false;
+    }
+
+    void operator()(Function_Call_Schema*) { scan.pure = false; }
+
+    void operator()(Variable* v)
+    { if (!is_bound(v->name())) scan.reads.insert(v->name()); }
+
+    void operator()(String_Schema* s)
+    { for (size_t i = 0, L = s->length(); i < L; ++i) (*s)[i]->perform(this); }
+
+    void operator()(Argument* a)    { a->value()->perform(this); }
+
+    void operator()(Arguments* a)
+    { for (size_t i = 0, L = a->length(); i < L; ++i) (*a)[i]->perform(this); }
+
+    void operator()(Textual*)         { }
+    void operator()(Number*)          { }
+    void operator()(Color*)           { }
+    void operator()(Boolean*)         { }
+    void operator()(String_Constant*) { }
+    void operator()(Null*)            { }
+
+    template <typename U>
+    void fallback(U) { scan.pure = false; }
+  };
+
+  static void append_bytes(string& key, const void* p, size_t n)
+  { key.append(static_cast<const char*>(p), n); }
+
+  static void append_string(string& key, const string& s)
+  {
+    size_t n = s.length();
+    append_bytes(key, &n, sizeof(n));
+    key += s;
+  }
+
+  // The exact value, type and flags, as bytes; false for anything that
+  // isn't a plain value.
+  static bool value_key(AST_Node* node, string& key)
+  {
+    if (!node) return false;
+    if (typeid(*node) == typeid(Argument)) {
+      Argument* a = static_cast<Argument*>(node);
+      key += a->is_rest_argument() ? 'R' : 'A';
+      append_string(key, a->name());
+      return value_key(a->value(), key);
+    }
+    Expression* e = dynamic_cast<Expression*>(node);
+    if (!e) return false;
+    key += e->is_delayed() ? 'd' : '-';
+    key += e->is_interpolant() ? 'i' : '-';
+    const type_info& type = typeid(*e);
+    if (type == typeid(Number)) {
+      Number* n = static_cast<Number*>(e);
+      double value = n->value();
+      key += 'n';
+      append_bytes(key, &value, sizeof(value));
+      size_t nn = n->units().numerators(), dn = n->units().denominators();
+      append_bytes(key, &nn, sizeof(nn));
+      for (size_t i = 0; i < nn; ++i) {
+        Unit u = n->units().numerator(i);
+        append_bytes(key, &u, sizeof(u));
+      }
+      append_bytes(key, &dn, sizeof(dn));
+      for (size_t i = 0; i < dn; ++i) {
+        Unit u = n->units().denominator(i);
+        append_bytes(key, &u, sizeof(u));
+      }
+    }
+    else if (type == typeid(Color)) {
+      Color* c = static_cast<Color*>(e);
+      double channels[] = { c->r(), c->g(), c->b(), c->a() };
+      key += 'c';
+      append_bytes(key, channels, sizeof(channels));
+      append_string(key, c->disp());
+    }
+    else if (type == typeid(String_Constant)) {
+      String_Constant* s = static_cast<String_Constant*>(e);
+      key += s->needs_unquoting() ? 'S' : 's';
+      append_string(key, s->value());
+    }
+    else if (type == typeid(Boolean)) {
+      key += static_cast<Boolean*>(e)->value() ? 'T' : 'F';
+    }
+    else if (type == typeid(Null)) {
+      key += 'z';
+    }
+    else if (type == typeid(List)) {
+      List* l = static_cast<List*>(e);
+      size_t n = l->length();
+      key += l->separator() == List::COMMA ? 'L' : 'l';
+      key += l->is_arglist() ? 'a' : '-';
+      append_bytes(key, &n, sizeof(n));
+      for (size_t i = 0; i < n; ++i) {
+        if (!value_key((*l)[i], key)) return false;
+      }
+    }
+    else if (type == typeid(Arguments)) {
+      Arguments* a = static_cast<Arguments*>(e);
+      size_t n = a->length();
+      key += 'a';
+      append_bytes(key, &n, sizeof(n));
+      for (size_t i = 0; i < n; ++i) {
+        if (!value_key((*a)[i], key)) return false;
+      }
+    }
+    else return false;
+    return true;
+  }
+
+  Function_Memo::Function_Memo()
+  : scans(map<Definition*, Scan>()), closures(map<Definition*, Closure>()),
+    results(Frame<Expression*>()), hits_(0), misses_(0)
+  { }
+
+  // the built-ins that look at the caller's environment, or evaluate their
+  // arguments there
+  bool Function_Memo::is_pure(Native_Function f)
+  {
+    using namespace Functions;
+    return f && f != variable_exists && f != global_variable_exists &&
+           f != function_exists && f != mixin_exists && f != sass_if;
+  }
+
+  const Function_Memo::Scan& Function_Memo::scan(Definition* def)
+  {
+    map<Definition*, Scan>::iterator s = scans.find(def);
+    if (s != scans.end()) return s->second;
+    Scan& result = scans[def];
+    result.pure = true;
+    Memo_Scan(def->environment(), result).definition(def);
+    return result;
+  }
+
+  const Function_Memo::Closure& Function_Memo::closure(Definition* def)
+  {
+    map<Definition*, Closure>::iterator c = closures.find(def);
+    if (c != closures.end()) return c->second;
+    Closure& result = closures[def];
+    result.pure = true;
+    set<Definition*> seen;
+    vector<Definition*> pending(1, def);
+    seen.insert(def);
+    while (!pending.empty() && result.pure) {
+      Definition* d = pending.back();
+      pending.pop_back();
+      const Scan& s = scan(d);
+      result.pure = s.pure;
+      for (set<string>::const_iterator r = s.reads.begin(); r != s.reads.end(); ++r) {
+        result.reads.push_back(make_pair(d->environment(), *r));
+      }
+      for (set<string>::const_iterator w = s.writes.begin(); w != s.writes.end(); ++w) {
+        result.writes.push_back(make_pair(d->environment(), *w));
+      }
+      for (size_t i = 0, S = s.callees.size(); i < S; ++i) {
+        if (seen.insert(s.callees[i]).second) pending.push_back(s.callees[i]);
+      }
+    }
+    return result;
+  }
+
+  bool Function_Memo::key(Definition* def, Arguments* args, string& key)
+  {
+    if (def->c_function()) return false;
+    if (!def->block() && !def->is_overload_stub() && !is_pure(def->native_function())) return false;
+
+    key.clear();
+    append_bytes(key, &def, sizeof(def));
+    if (!value_key(args, key)) return false;
+    if (!def->block()) return true;
+
+    const Closure& c = closure(def);
+    if (!c.pure) return false;
+    // an assignment that would land outside the call is a side effect
+    for (size_t i = 0, S = c.writes.size(); i < S; ++i) {
+      if (c.writes[i].first->lookup(c.writes[i].second)) return false;
+    }
+    for (size_t i = 0, S = c.reads.size(); i < S; ++i) {
+      AST_Node** binding = c.reads[i].first->lookup(c.reads[i].second);
+      // unbound, the call fails and is never remembered
+      if (!binding) key += 'u';
+      else if (!value_key(*binding, key)) return false;
+    }
+    return true;
+  }
+
+  // Results are kept as copies of their own and handed out as copies, since
+  // callers change the values they get in place (their position, a color's
+  // display name). Lists are copied all the way down; null if e holds
+  // anything else.
+  static Expression* copy_value(Expression* e, Memory_Manager<AST_Node>& mem)
+  {
+    const type_info& type = typeid(*e);
+    if (type == typeid(Number))          return new (mem) Number(*static_cast<Number*>(e));
+    if (type == typeid(Color))           return new (mem) Color(*static_cast<Color*>(e));
+    if (type == typeid(String_Constant)) return new (mem) String_Constant(*static_cast<String_Constant*>(e));
+    if (type == typeid(Boolean))         return new (mem) Boolean(*static_cast<Boolean*>(e));
+    if (type == typeid(Null))            return new (mem) Null(*static_cast<Null*>(e));
+    if (type != typeid(List))            return 0;
+    List* l = static_cast<List*>(e);
+    vector<Expression*> elements(l->length());
+    for (size_t i = 0, L = l->length(); i < L; ++i) {
+      if (!(elements[i] = copy_value((*l)[i], mem))) return 0;
+    }
+    List* copy = new (mem) List(*l);
+    copy->elements(elements);
+    return copy;
+  }
+
+  Expression* Function_Memo::find(const string& key, Memory_Manager<AST_Node>& mem)
+  {
+    Expression** found = results.find(key, hash_key(key));
+    if (!found) {
+      ++misses_;
+      return 0;
+    }
+    ++hits_;
+    // the caller moves the result to the call's position
+    return copy_value(*found, mem);
+  }
+
+  void Function_Memo::remember(const string& key, Expression* result, Memory_Manager<AST_Node>& mem)
+  {
+    if (Expression* copy = copy_value(result, mem)) results[key] = copy;
+  }
+
+  void Function_Memo::forget()
+  {
+    scans.clear();
+    closures.clear();
+    results = Frame<Expression*>();
+  }
+
+}
@@ -0,0 +1,91 @@
+#define SASS_FUNCTION_MEMO
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#ifndef SASS_ENVIRONMENT
+#include "environment.hpp"
+#endif
+
+#ifndef SASS_MEMORY_MANAGER
+#include "memory_manager.hpp"
+#endif
+
+namespace Sass {
+  using std::string;
+  using std::vector;
+  using std::map;
+  using std::set;
+  using std::pair;
+
+  class AST_Node;
+  class Expression;
+  class Definition;
+  class Arguments;
+  class Memo_Scan;
+  struct Context;
+  struct Backtrace;
+  struct Position;
+  typedef Environment<AST_Node*> Env;
+  typedef const char* Signature;
+  typedef Expression* (*Native_Function)(Env&, Env&, Context&, Signature, const char*, Position, Backtrace*);
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Results of function calls that can be replayed, for one compile. A call
+  // qualifies when the function and everything it calls is free of side
+  // effects: built-ins other than the ones that inspect the environment, and
+  // Sass functions without @warn, !global or interpolated calls. The key is
+  // the function together with the exact values of its arguments and of the
+  // outer variables it reads, so a call after one of those changes doesn't
+  // match. Assigning a variable that already exists outside the function
+  // would be a side effect; such calls are simply made. Defining a function
+  // can change what the others call, so it empties the memo.
+  /////////////////////////////////////////////////////////////////////////////
+  class Function_Memo {
+  public:
+    Function_Memo();
+
+    // Builds the key for calling def with these (evaluated) arguments, or
+    // returns false if the call has to be made.
+    bool key(Definition* def, Arguments* args, string& key);
+    // a copy of the remembered result, made in mem, or null
+    Expression* find(const string& key, Memory_Manager<AST_Node>& mem);
+    // keeps a copy of result, made in mem, which must outlive the memo
+    void remember(const string& key, Expression* result, Memory_Manager<AST_Node>& mem);
+    void forget();
+
+    size_t hits() const   { return hits_; }
+    size_t misses() const { return misses_; }
+
+    static bool is_pure(Native_Function);
+
+  private:
+    friend class Memo_Scan;
+
+    // what a single definition does, not counting its callees
+    struct Scan {
+      bool                         pure;
+      set<string>                  reads;   // outer variables it may read
+      set<string>                  writes;  // variables it assigns that must be local
+      vector<Definition*>          callees; // Sass functions it calls
+    };
+    // the same, with all its callees folded in
+    struct Closure {
+      bool                          pure;
+      vector<pair<Env*, string> >   reads;
+      vector<pair<Env*, string> >   writes;
+    };
+
+    const Scan&    scan(Definition* def);
+    const Closure& closure(Definition* def);
+
+    map<Definition*, Scan>    scans;
+    map<Definition*, Closure> closures;
+    Frame<Expression*>        results;
+    size_t                    hits_;
+    size_t                    misses_;
+  };
+
+}
@@ -9,6 +9,7 @@
 #include "eval.hpp"
 #include "util.hpp"
 #include "utf8_string.hpp"
+#include "color_names.hpp"
 
 #include <cstdlib>
 #include <cmath>
@@ -58,7 +59,7 @@ namespace Sass {
   namespace Functions {
 
     template <typename T>
-    T* get_arg(const string& argname, Env& env, Signature sig, const string& path, Position position, Backtrace* backtrace)
+    T* get_arg(const string& argname, Env& env, Signature sig, const char* path, Position position, Backtrace* backtrace)
     {
       // Minimal error handling -- the expectation is that built-ins will be written correctly!
       T* val = dynamic_cast<T*>(env[argname]);
@@ -74,7 +75,7 @@ namespace Sass {
       return val;
     }
 
-    Number* get_arg_r(const string& argname, Env& env, Signature sig, const string& path, Position position, double lo, double hi, Backtrace* backtrace)
+    Number* get_arg_r(const string& argname, Env& env, Signature sig, const char* path, Position position, double lo, double hi, Backtrace* backtrace)
     {
       // Minimal error handling -- the expectation is that built-ins will be written correctly!
       Number* val = get_arg<Number>(argname, env, sig, path, position, backtrace);
@@ -208,7 +209,7 @@ namespace Sass {
       return m1;
     }
 
-    Color* hsla_impl(double h, double s, double l, double a, Context& ctx, const string& path, Position position)
+    Color* hsla_impl(double h, double s, double l, double a, Context& ctx, const char* path, Position position)
     {
       h = static_cast<double>(((static_cast<int>(h) % 360) + 360) % 360) / 360.0;
       s /= 100.0;
@@ -1071,7 +1072,7 @@ namespace Sass {
       if (v->concrete_type() == Expression::STRING) {
         To_String to_string;
         string str(v->perform(&to_string));
-        if (ctx.names_to_colors.count(str)) {
+        if (name_to_color(str) >= 0) {
           return new (ctx.mem) String_Constant(path, position, "color");
         }
       }
@@ -1096,7 +1097,7 @@ namespace Sass {
       }
       Number tmp_n2(*n2);
       tmp_n2.normalize(n1->find_convertible_unit());
-      return new (ctx.mem) Boolean(path, position, n1->unit() == tmp_n2.unit());
+      return new (ctx.mem) Boolean(path, position, n1->units() == tmp_n2.units());
     }
 
     Signature variable_exists_sig = "variable-exists($name)";
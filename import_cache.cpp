@@ -0,0 +1,107 @@
+#ifdef _WIN32
+#define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <cctype>
+#include <sys/stat.h>
+
+#ifndef SASS_IMPORT_CACHE
+#include "import_cache.hpp"
+#endif
+
+namespace Sass {
+
+  // names are compared the way the filesystem would compare them
+  static string folded(const string& name)
+  {
+#if defined(_WIN32) || defined(__APPLE__)
+    string f(name);
+    for (size_t i = 0, L = f.length(); i < L; ++i) f[i] = tolower(f[i]);
+    return f;
+#else
+    return name;
+#endif
+  }
+
+  static void list_directory(const string& dir, set<string>& names)
+  {
+#ifdef _WIN32
+    _finddata_t entry;
+    intptr_t handle = _findfirst((dir + "/*").c_str(), &entry);
+    if (handle == -1) return;
+    do names.insert(folded(entry.name)); while (_findnext(handle, &entry) == 0);
+    _findclose(handle);
+#else
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) return;
+    while (dirent* entry = readdir(handle)) names.insert(folded(entry->d_name));
+    closedir(handle);
+#endif
+  }
+
+  Import_Cache::Import_Cache()
+  : dirs(map<string, Listing>()), hits_(0), listings_(0)
+  { }
+
+  Import_Cache::~Import_Cache()
+  { }
+
+  void Import_Cache::find(Session& session, const string& dir, const string names[], size_t n, bool found[], size_t& fs_calls)
+  {
+    string path(dir.empty() ? "." : dir);
+    mutex.lock();
+    bool checked = session.checked.count(path) > 0;
+    mutex.unlock();
+    struct stat st;
+    bool exists = false;
+    if (!checked) {
+      ++fs_calls;
+      exists = stat(path.c_str(), &st) != -1 && S_ISDIR(st.st_mode);
+    }
+
+    mutex.lock();
+    Listing& listing = dirs[path];
+    // a directory changed in the same second as it was listed may have
+    // changed after the listing, with the same mtime
+    bool current = checked ||
+                   (listing.listed && listing.exists == exists &&
+                    (!exists || (listing.mtime == st.st_mtime && listing.mtime < listing.listed)));
+    session.checked.insert(path);
+    if (current) {
+      ++hits_;
+    }
+    else {
+      ++listings_;
+      listing.exists = exists;
+      listing.mtime  = exists ? st.st_mtime : 0;
+      listing.listed = time(0);
+      listing.names.clear();
+      if (exists) {
+        ++fs_calls;
+        list_directory(path, listing.names);
+      }
+    }
+    for (size_t i = 0; i < n; ++i) found[i] = listing.names.count(folded(names[i])) > 0;
+    mutex.unlock();
+  }
+
+  size_t Import_Cache::hits()
+  {
+    mutex.lock();
+    size_t n = hits_;
+    mutex.unlock();
+    return n;
+  }
+
+  size_t Import_Cache::listings()
+  {
+    mutex.lock();
+    size_t n = listings_;
+    mutex.unlock();
+    return n;
+  }
+
+}
@@ -0,0 +1,63 @@
+#define SASS_IMPORT_CACHE
+
+#include <string>
+#include <set>
+#include <map>
+#include <ctime>
+
+#ifndef SASS_MUTEX
+#include "mutex.hpp"
+#endif
+
+namespace Sass {
+  using std::string;
+  using std::set;
+  using std::map;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Directory listings kept across compiles, so that resolving an import
+  // costs a stat of each directory searched rather than one for every name
+  // the import might refer to. A listing is trusted while its directory's
+  // mtime is unchanged and older than the listing itself; directories that
+  // don't exist are remembered the same way. A compile checks each directory
+  // once and trusts it from then on. Safe to share between threads.
+  /////////////////////////////////////////////////////////////////////////////
+  class Import_Cache {
+  public:
+    // One compile's use of the cache. Only touched under the cache's lock,
+    // so the compile's parse workers can share it.
+    struct Session {
+      Import_Cache* cache;
+      set<string>   checked; // directories this compile no longer stats
+
+      Session(Import_Cache* cache) : cache(cache), checked(set<string>()) { }
+    };
+
+    Import_Cache();
+    ~Import_Cache();
+
+    // Sets found[i] if dir has an entry called names[i]. Adds the
+    // filesystem calls it needed to fs_calls.
+    void find(Session& session, const string& dir, const string names[], size_t n, bool found[], size_t& fs_calls);
+
+    size_t hits();     // lookups answered by a listing already made
+    size_t listings(); // directories listed (or found missing), including again
+
+  private:
+    Import_Cache(const Import_Cache&);
+    Import_Cache& operator=(const Import_Cache&);
+
+    struct Listing {
+      bool        exists;
+      time_t      mtime;
+      time_t      listed;
+      set<string> names;
+    };
+
+    map<string, Listing> dirs;
+    size_t               hits_;
+    size_t               listings_;
+    Mutex                mutex;
+  };
+
+}
@@ -1,6 +1,8 @@
 #include "inspect.hpp"
 #include "ast.hpp"
 #include "context.hpp"
+#include "number_format.hpp"
+#include "color_names.hpp"
 #include <cmath>
 #include <iostream>
 #include <iomanip>
@@ -8,7 +10,9 @@
 namespace Sass {
   using namespace std;
 
-  Inspect::Inspect(Context* ctx) : buffer(""), indentation(0), ctx(ctx) { }
+  Inspect::Inspect(Context* ctx, Emitter* out)
+  : own_buffer(), buffer(out ? *out : own_buffer), indentation(0), ctx(ctx)
+  { }
   Inspect::~Inspect() { }
 
   // statements
@@ -32,9 +36,8 @@ namespace Sass {
     }
     // remove extra newline that gets added after the last top-level block
     if (block->is_root()) {
-      size_t l = buffer.length();
-      if (l > 2 && buffer[l-1] == '\n' && buffer[l-2] == '\n') {
-        buffer.erase(l-1);
+      if (buffer.length() > 2 && buffer.back(0) == '\n' && buffer.back(1) == '\n') {
+        buffer.erase_last();
         if (ctx) ctx->source_map.remove_line();
       }
     }
@@ -309,18 +312,17 @@ namespace Sass {
 
   void Inspect::operator()(Number* n)
   {
-    stringstream ss;
-    ss.precision(ctx ? ctx->precision : 5);
-    ss << fixed << n->value();
-    string d(ss.str());
-    for (size_t i = d.length()-1; d[i] == '0'; --i) {
-      d.resize(d.length()-1);
+    size_t precision = ctx ? ctx->precision : 5;
+    if (n->units().numerators() > 1 || n->units().denominators() > 0) {
+      error(format_number_slow(n->value(), precision) + n->unit() + " is not a valid CSS value", n->path(), n->position());
+    }
+    char digits[number_buffer_size];
+    if (size_t len = format_number(n->value(), precision, digits)) {
+      append_to_buffer(digits, len);
     }
-    if (d[d.length()-1] == '.') d.resize(d.length()-1);
-    if (n->numerator_units().size() > 1 || n->denominator_units().size() > 0) {
-      error(d + n->unit() + " is not a valid CSS value", n->path(), n->position());
+    else {
+      append_to_buffer(format_number_slow(n->value(), precision));
     }
-    append_to_buffer(d);
     append_to_buffer(n->unit());
   }
 
@@ -334,7 +336,6 @@ namespace Sass {
 
   void Inspect::operator()(Color* c)
   {
-    stringstream ss;
     double r = cap_channel<0xff>(c->r());
     double g = cap_channel<0xff>(c->g());
     double b = cap_channel<0xff>(c->b());
@@ -347,32 +348,40 @@ namespace Sass {
 
     // retain the originally specified color definition if unchanged
     if (!c->disp().empty()) {
-      ss << c->disp();
+      append_to_buffer(c->disp());
     }
     else if (a >= 1) {
       // see if it's a named color
       int numval = r * 0x10000;
       numval += g * 0x100;
       numval += b;
-      if (ctx && ctx->colors_to_names.count(numval)) {
-        ss << ctx->colors_to_names[numval];
+      const char* name;
+      if (ctx && (name = color_to_name(numval))) {
+        append_to_buffer(name);
       }
       else {
         // otherwise output the hex triplet
-        ss << '#' << setw(2) << setfill('0');
-        ss << hex << setw(2) << static_cast<unsigned long>(floor(r+0.5));
-        ss << hex << setw(2) << static_cast<unsigned long>(floor(g+0.5));
-        ss << hex << setw(2) << static_cast<unsigned long>(floor(b+0.5));
+        static const char hex_digits[] = "0123456789abcdef";
+        unsigned long channels[] = { static_cast<unsigned long>(floor(r+0.5)),
+                                     static_cast<unsigned long>(floor(g+0.5)),
+                                     static_cast<unsigned long>(floor(b+0.5)) };
+        char triplet[7] = { '#' };
+        for (size_t i = 0; i < 3; ++i) {
+          triplet[2*i+1] = hex_digits[(channels[i] >> 4) & 0xf];
+          triplet[2*i+2] = hex_digits[channels[i] & 0xf];
+        }
+        append_to_buffer(triplet, 7);
       }
     }
     else {
+      stringstream ss;
       ss << "rgba(";
       ss << static_cast<unsigned long>(r) << ", ";
       ss << static_cast<unsigned long>(g) << ", ";
       ss << static_cast<unsigned long>(b) << ", ";
       ss << a << ')';
+      append_to_buffer(ss.str());
     }
-    append_to_buffer(ss.str());
   }
 
   void Inspect::operator()(Boolean* b)
@@ -630,8 +639,14 @@ namespace Sass {
 
   void Inspect::append_to_buffer(const string& text)
   {
-    buffer += text;
+    buffer.append(text);
     if (ctx) ctx->source_map.update_column(text);
   }
 
+  void Inspect::append_to_buffer(const char* text, size_t length)
+  {
+    buffer.append(text, length);
+    if (ctx) ctx->source_map.update_column(text, length);
+  }
+
 }
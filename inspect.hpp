@@ -4,6 +4,10 @@
 #include "operation.hpp"
 #endif
 
+#ifndef SASS_EMITTER
+#include "emitter.hpp"
+#endif
+
 // #ifndef SASS_TO_STRING
 // #include "to_string.hpp"
 // #endif
@@ -17,7 +21,8 @@ namespace Sass {
     using Operation_CRTP<void, Inspect>::operator();
 
     // To_String* to_string;
-    string buffer;
+    Emitter  own_buffer;
+    Emitter& buffer;
     size_t indentation;
     Context* ctx;
     void indent();
@@ -25,13 +30,15 @@ namespace Sass {
     void fallback_impl(AST_Node* n);
 
     void append_to_buffer(const string& text);
+    void append_to_buffer(const char* text, size_t length);
 
   public:
 
-    Inspect(Context* ctx = 0);
+    // Appends to `out` if given, rather than a buffer of its own.
+    Inspect(Context* ctx = 0, Emitter* out = 0);
     virtual ~Inspect();
 
-    string get_buffer() { return buffer; }
+    string get_buffer() { return buffer.str(); }
 
     // statements
     virtual void operator()(Block*);
@@ -2,30 +2,71 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
 using namespace std;
 
 namespace Sass {
   /////////////////////////////////////////////////////////////////////////////
-  // A class for tracking allocations of AST_Node objects. The intended usage
-  // is something like: Some_Node* n = new (mem_mgr) Some_Node(...);
-  // Then, at the end of the program, the memory manager will delete all of the
-  // allocated nodes that have been passed to it.
-  // In the future, this class may implement a custom allocator.
+  // A region allocator for AST_Node objects. The intended usage is something
+  // like: Some_Node* n = new (mem_mgr) Some_Node(...);
+  // Nodes are carved out of large slabs by bumping a pointer, and the slabs
+  // are released in bulk when the memory manager goes away. Every node still
+  // has its destructor run first, since most of them own strings and vectors.
   /////////////////////////////////////////////////////////////////////////////
   template <typename T>
   class Memory_Manager {
-    vector<T*> nodes;
+    static const size_t slab_size = 64 * 1024;
+    static const size_t alignment = 16;
+
+    vector<char*> slabs;
+    vector<T*>    nodes;
+    char*         cursor;
+    char*         limit;
+
+    size_t allocation_count_;
+    size_t bytes_allocated_;
+    size_t bytes_reserved_;
+
+    char* new_slab(size_t size)
+    {
+      char* slab = static_cast<char*>(malloc(size));
+      if (!slab) throw bad_alloc();
+      slabs.push_back(slab);
+      bytes_reserved_ += size;
+      return slab;
+    }
 
   public:
-    Memory_Manager(size_t size = 0) : nodes(vector<T*>())
+    Memory_Manager(size_t size = 0)
+    : slabs(vector<char*>()), nodes(vector<T*>()), cursor(0), limit(0),
+      allocation_count_(0), bytes_allocated_(0), bytes_reserved_(0)
     { nodes.reserve(size); }
 
     ~Memory_Manager()
     {
       for (size_t i = 0, S = nodes.size(); i < S; ++i) {
-        // cout << "deleting " << typeid(*nodes[i]).name() << endl;
-        delete nodes[i];
+        // cout << "destroying " << typeid(*nodes[i]).name() << endl;
+        nodes[i]->~T();
       }
+      for (size_t i = 0, S = slabs.size(); i < S; ++i) free(slabs[i]);
+    }
+
+    void* allocate(size_t size)
+    {
+      size = (size + alignment - 1) & ~(alignment - 1);
+      ++allocation_count_;
+      bytes_allocated_ += size;
+      // oversized requests get a slab of their own so the current one stays usable
+      if (size > slab_size / 4) return new_slab(size);
+      if (static_cast<size_t>(limit - cursor) < size) {
+        cursor = new_slab(slab_size);
+        limit  = cursor + slab_size;
+      }
+      void* np = cursor;
+      cursor += size;
+      return np;
     }
 
     T* operator()(T* np)
@@ -35,20 +76,34 @@ namespace Sass {
       return np;
     }
 
+    // only called when a constructor throws, which is almost always right
+    // after the allocation, so check the most recent node first
     void remove(T* np)
     {
-      nodes.erase(find(nodes.begin(), nodes.end(), np));
+      if (!nodes.empty() && nodes.back() == np) nodes.pop_back();
+      else nodes.erase(find(nodes.begin(), nodes.end(), np));
+    }
+
+    size_t allocation_count() const { return allocation_count_; }
+    size_t bytes_allocated() const  { return bytes_allocated_; }
+    size_t bytes_reserved() const   { return bytes_reserved_; }
+    size_t slab_count() const       { return slabs.size(); }
+
+    void report(ostream& os) const
+    {
+      os << "nodes allocated: " << allocation_count_ << endl
+         << "bytes allocated: " << bytes_allocated_ << endl
+         << "bytes reserved:  " << bytes_reserved_
+         << " (" << slabs.size() << " slabs)" << endl;
     }
   };
 }
 
 template <typename T>
 inline void* operator new(size_t size, Sass::Memory_Manager<T>& mem_mgr)
-{ return mem_mgr(static_cast<T*>(operator new(size))); }
+{ return mem_mgr(static_cast<T*>(mem_mgr.allocate(size))); }
 
+// the slab memory itself is reclaimed when the memory manager is destroyed
 template <typename T>
 inline void operator delete(void *np, Sass::Memory_Manager<T>& mem_mgr)
-{
-  mem_mgr.remove(reinterpret_cast<T*>(np));
-  operator delete(np);
-}
+{ mem_mgr.remove(reinterpret_cast<T*>(np)); }
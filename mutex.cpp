@@ -0,0 +1,43 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#ifndef SASS_MUTEX
+#include "mutex.hpp"
+#endif
+
+namespace Sass {
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+
+  Mutex::Mutex()      { pthread_mutex_init(&mutex, 0); }
+  Mutex::~Mutex()     { pthread_mutex_destroy(&mutex); }
+  void Mutex::lock()   { pthread_mutex_lock(&mutex); }
+  void Mutex::unlock() { pthread_mutex_unlock(&mutex); }
+
+#elif defined(_WIN32)
+
+  Mutex::Mutex()
+  : section(new CRITICAL_SECTION)
+  { InitializeCriticalSection(static_cast<CRITICAL_SECTION*>(section)); }
+
+  Mutex::~Mutex()
+  {
+    DeleteCriticalSection(static_cast<CRITICAL_SECTION*>(section));
+    delete static_cast<CRITICAL_SECTION*>(section);
+  }
+
+  void Mutex::lock()   { EnterCriticalSection(static_cast<CRITICAL_SECTION*>(section)); }
+  void Mutex::unlock() { LeaveCriticalSection(static_cast<CRITICAL_SECTION*>(section)); }
+
+#else
+
+  Mutex::Mutex()       { }
+  Mutex::~Mutex()      { }
+  void Mutex::lock()   { }
+  void Mutex::unlock() { }
+
+#endif
+
+}
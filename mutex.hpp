@@ -0,0 +1,34 @@
+#define SASS_MUTEX
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#endif
+
+namespace Sass {
+
+  /////////////////////////////////////////////////////////////////////////////
+  // A lock for state that compiles on different threads share: a pthread
+  // mutex, or a critical section on Windows. Emscripten has no threads, so
+  // there it does nothing. windows.h stays in mutex.cpp, as its macros (IN,
+  // min, max) clash with names used throughout the library.
+  /////////////////////////////////////////////////////////////////////////////
+  class Mutex {
+  public:
+    Mutex();
+    ~Mutex();
+
+    void lock();
+    void unlock();
+
+  private:
+    Mutex(const Mutex&);
+    Mutex& operator=(const Mutex&);
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+    pthread_mutex_t mutex;
+#elif defined(_WIN32)
+    void*           section; // a CRITICAL_SECTION
+#endif
+  };
+
+}
@@ -0,0 +1,131 @@
+#include "normalize.hpp"
+#include "context.hpp"
+
+#include <typeinfo>
+
+namespace Sass {
+
+  Normalize::Normalize(Context& ctx)
+  : ctx(ctx), tokens(vector<Token>()), ok(true)
+  { }
+
+  Selector_List* Normalize::operator()(Selector* s)
+  {
+    if (!s || typeid(*s) != typeid(Selector_List)) return 0;
+    Selector_List* sl = static_cast<Selector_List*>(s);
+    Selector_List* group = new (ctx.mem) Selector_List(sl->path(), sl->position(), sl->length());
+    for (size_t i = 0, L = sl->length(); i < L; ++i) {
+      Complex_Selector* orig = (*sl)[i];
+      tokens.clear();
+      flatten(orig);
+      if (!ok) return 0;
+      size_t pos = skip_spaces(0);
+      // a selector that prints as nothing is dropped, as it would be by the parser
+      if (pos == tokens.size()) continue;
+      Complex_Selector* comb = combination(pos, orig);
+      // same as Parser::parse_selector_group: anchor it with an implicit "&"
+      if (!comb->has_reference()) {
+        Selector_Reference* ref = new (ctx.mem) Selector_Reference(orig->path(), orig->position());
+        Compound_Selector* ref_wrap = new (ctx.mem) Compound_Selector(orig->path(), orig->position());
+        (*ref_wrap) << ref;
+        if (!comb->head()) {
+          comb->head(ref_wrap);
+          comb->has_reference(true);
+        }
+        else {
+          comb = new (ctx.mem) Complex_Selector(orig->path(), orig->position(), Complex_Selector::ANCESTOR_OF, ref_wrap, comb);
+          comb->has_reference(true);
+        }
+      }
+      (*group) << comb;
+    }
+    return group;
+  }
+
+  // Emits tokens in exactly the order Inspect::operator()(Complex_Selector*)
+  // would print them.
+  void Normalize::flatten(Complex_Selector* c)
+  {
+    Selector*                    head = c->head();
+    Complex_Selector*            tail = c->tail();
+    Complex_Selector::Combinator comb = c->combinator();
+    bool printed = head && !(typeid(*head) == typeid(Compound_Selector) &&
+                             static_cast<Compound_Selector*>(head)->is_empty_reference());
+    if (printed) flatten_head(head);
+    if (printed && tail) tokens.push_back(Token(SPACE));
+    if (comb != Complex_Selector::ANCESTOR_OF) tokens.push_back(Token(COMBINATOR, 0, comb));
+    if (tail && comb != Complex_Selector::ANCESTOR_OF) tokens.push_back(Token(SPACE));
+    if (tail) flatten(tail);
+  }
+
+  // Placeholder substitution can leave a complex selector where a compound
+  // one is expected; it is printed (and so flattened) in place.
+  void Normalize::flatten_head(Selector* h)
+  {
+    if (typeid(*h) == typeid(Complex_Selector)) {
+      flatten(static_cast<Complex_Selector*>(h));
+      return;
+    }
+    Compound_Selector* seq = static_cast<Compound_Selector*>(h);
+    for (size_t i = 0, L = seq->length(); i < L && ok; ++i) {
+      flatten_simple((*seq)[i]);
+    }
+  }
+
+  void Normalize::flatten_simple(Selector* s)
+  {
+    if (typeid(*s) == typeid(Complex_Selector)) {
+      flatten(static_cast<Complex_Selector*>(s));
+    }
+    else if (typeid(*s) == typeid(Selector_Reference)) {
+      Selector* parent = static_cast<Selector_Reference*>(s)->selector();
+      if (!parent)                                             append_simple(static_cast<Simple_Selector*>(s), true);
+      else if (typeid(*parent) == typeid(Complex_Selector))   flatten(static_cast<Complex_Selector*>(parent));
+      else                                                     ok = false;
+    }
+    else {
+      append_simple(static_cast<Simple_Selector*>(s), typeid(*s) == typeid(Type_Selector));
+    }
+  }
+
+  // Type selectors and bare "&" are only recognized at the start of a
+  // sequence; anywhere else their text would run into the preceding
+  // selector and lex as something else, so leave those to the parser.
+  void Normalize::append_simple(Simple_Selector* s, bool must_begin_sequence)
+  {
+    if (must_begin_sequence && !tokens.empty() && tokens.back().type == SIMPLE) ok = false;
+    else tokens.push_back(Token(SIMPLE, s));
+  }
+
+  size_t Normalize::skip_spaces(size_t pos)
+  {
+    while (pos < tokens.size() && tokens[pos].type == SPACE) ++pos;
+    return pos;
+  }
+
+  // Mirrors Parser::parse_selector_combination over the token stream.
+  Complex_Selector* Normalize::combination(size_t& pos, Complex_Selector* orig)
+  {
+    pos = skip_spaces(pos);
+    Compound_Selector* lhs = 0;
+    if (tokens[pos].type == SIMPLE) {
+      lhs = new (ctx.mem) Compound_Selector(tokens[pos].simple->path(), tokens[pos].simple->position());
+      while (pos < tokens.size() && tokens[pos].type == SIMPLE) {
+        (*lhs) << tokens[pos++].simple;
+      }
+    }
+
+    pos = skip_spaces(pos);
+    Complex_Selector::Combinator cmb = Complex_Selector::ANCESTOR_OF;
+    if (pos < tokens.size() && tokens[pos].type == COMBINATOR) {
+      cmb = tokens[pos++].combinator;
+    }
+
+    pos = skip_spaces(pos);
+    Complex_Selector* rhs = 0;
+    if (pos < tokens.size()) rhs = combination(pos, orig);
+
+    return new (ctx.mem) Complex_Selector(orig->path(), lhs ? lhs->position() : orig->position(), cmb, lhs, rhs);
+  }
+
+}
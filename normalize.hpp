@@ -0,0 +1,49 @@
+#define SASS_NORMALIZE
+
+#include <vector>
+
+#ifndef SASS_AST
+#include "ast.hpp"
+#endif
+
+namespace Sass {
+  using namespace std;
+
+  struct Context;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Flattens a contextualized selector group (parent references resolved,
+  // placeholders substituted) into the same canonical Selector_List that the
+  // parser would produce from its printed form, without printing it. Returns
+  // 0 for the few selectors whose printed form would lex differently (e.g.,
+  // "&-suffix"); callers should fall back to re-parsing those.
+  /////////////////////////////////////////////////////////////////////////////
+  class Normalize {
+
+    enum Token_Type { SIMPLE, SPACE, COMBINATOR };
+    struct Token {
+      Token_Type                   type;
+      Simple_Selector*             simple;
+      Complex_Selector::Combinator combinator;
+      Token(Token_Type t, Simple_Selector* s = 0, Complex_Selector::Combinator c = Complex_Selector::ANCESTOR_OF)
+      : type(t), simple(s), combinator(c) { }
+    };
+
+    Context&      ctx;
+    vector<Token> tokens;
+    bool          ok;
+
+    void flatten(Complex_Selector*);
+    void flatten_head(Selector*);
+    void flatten_simple(Selector*);
+    void append_simple(Simple_Selector*, bool must_begin_sequence);
+    size_t skip_spaces(size_t);
+    Complex_Selector* combination(size_t&, Complex_Selector*);
+
+  public:
+    Normalize(Context&);
+
+    Selector_List* operator()(Selector*);
+  };
+
+}
@@ -0,0 +1,81 @@
+#include <cmath>
+#include <sstream>
+
+#ifndef SASS_NUMBER_FORMAT
+#include "number_format.hpp"
+#endif
+
+namespace Sass {
+  using namespace std;
+
+  static const size_t max_fast_precision = 15;
+
+  static const double powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+  };
+
+  static const unsigned long long integral_powers_of_ten[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL
+  };
+
+  // 2^50, which keeps the rounding margin below well under a half
+  static const double max_fast_scaled = 1125899906842624.0;
+
+  size_t format_number(double value, size_t precision, char* buffer)
+  {
+    if (precision > max_fast_precision) return 0;
+    double scaled = fabs(value) * powers_of_ten[precision];
+    if (!(scaled < max_fast_scaled)) return 0; // also turns away inf and nan
+    double whole = floor(scaled);
+    double frac  = scaled - whole;
+    // The product is within half an ulp of the exact one, so unless that is
+    // enough to reach the rounding boundary, rounding it gives the same
+    // digits as the exact decimal conversion. Near-ties (and exact ones,
+    // which printf breaks to even) take the slow path.
+    if (fabs(frac - 0.5) <= ldexp(scaled, -52)) return 0;
+    unsigned long long rounded = static_cast<unsigned long long>(whole) + (frac > 0.5 ? 1 : 0);
+    unsigned long long ipart   = rounded / integral_powers_of_ten[precision];
+    unsigned long long fpart   = rounded % integral_powers_of_ten[precision];
+
+    char* p = buffer;
+    if (value < 0 || (value == 0 && 1 / value < 0)) *p++ = '-';
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = '0' + ipart % 10;
+      ipart /= 10;
+    } while (ipart);
+    while (n) *p++ = digits[--n];
+    if (precision) {
+      *p++ = '.';
+      for (size_t i = precision; i > 0; --i) {
+        p[i-1] = '0' + fpart % 10;
+        fpart /= 10;
+      }
+      p += precision;
+    }
+
+    size_t len = p - buffer;
+    while (len > 1 && buffer[len-1] == '0') --len;
+    if (buffer[len-1] == '.') --len;
+    return len;
+  }
+
+  string format_number_slow(double value, size_t precision)
+  {
+    stringstream ss;
+    ss.precision(precision);
+    ss << fixed << value;
+    string d(ss.str());
+    for (size_t i = d.length()-1; i > 0 && d[i] == '0'; --i) {
+      d.resize(d.length()-1);
+    }
+    if (d[d.length()-1] == '.') d.resize(d.length()-1);
+    return d;
+  }
+
+}
@@ -0,0 +1,22 @@
+#define SASS_NUMBER_FORMAT
+
+#include <string>
+#include <cstddef>
+
+namespace Sass {
+  using std::string;
+
+  // Enough room for anything format_number writes.
+  const size_t number_buffer_size = 40;
+
+  // Formats a number the way it appears in CSS output: fixed notation with
+  // `precision` fractional digits, then trailing zeros and a trailing point
+  // trimmed. Writes into `buffer` and returns the length, or returns 0 if
+  // the value can't be formatted without the full decimal conversion, in
+  // which case format_number_slow produces the (identical) result.
+  size_t format_number(double value, size_t precision, char* buffer);
+
+  // The stringstream-based original, kept as the reference.
+  string format_number_slow(double value, size_t precision);
+
+}
@@ -7,26 +7,30 @@
 namespace Sass {
   using namespace std;
 
-  Output_Compressed::Output_Compressed(Context* ctx) : buffer(""), rendered_imports(""), ctx(ctx) { }
+  Output_Compressed::Output_Compressed(Context* ctx, Emitter* out)
+  : own_buffer(), buffer(out ? *out : own_buffer), ctx(ctx)
+  { }
   Output_Compressed::~Output_Compressed() { }
 
   inline void Output_Compressed::fallback_impl(AST_Node* n)
   {
-    Inspect i(ctx);
+    Inspect i(ctx, &buffer);
     n->perform(&i);
-    buffer += i.get_buffer();
   }
 
+  // imports are rendered ahead of everything else; see operator()(Block*)
   void Output_Compressed::operator()(Import* imp)
-  {
-    Inspect insp(ctx);
-    imp->perform(&insp);
-    rendered_imports += insp.get_buffer();
-  }
+  { }
 
   void Output_Compressed::operator()(Block* b)
   {
     if (!b->is_root()) return;
+    vector<Import*> imports;
+    collect_imports(b, ctx->extensions.empty(), imports);
+    for (size_t i = 0, S = imports.size(); i < S; ++i) {
+      Inspect insp(ctx, &buffer);
+      imports[i]->perform(&insp);
+    }
     for (size_t i = 0, L = b->length(); i < L; ++i) {
       (*b)[i]->perform(this);
     }
@@ -190,9 +194,8 @@ namespace Sass {
       return;
     }
     else {
-      Inspect i(ctx);
+      Inspect i(ctx, &buffer);
       c->perform(&i);
-      buffer += i.get_buffer();
     }
   }
 
@@ -296,7 +299,7 @@ namespace Sass {
 
   void Output_Compressed::append_singleline_part_to_buffer(const string& text)
   {
-    buffer += text;
+    buffer.append(text);
     if (ctx) ctx->source_map.update_column(text);
   }
 
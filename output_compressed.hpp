@@ -4,6 +4,10 @@
 #include "operation.hpp"
 #endif
 
+#ifndef SASS_EMITTER
+#include "emitter.hpp"
+#endif
+
 namespace Sass {
   using namespace std;
 
@@ -13,8 +17,8 @@ namespace Sass {
     // import all the class-specific methods and override as desired
     using Operation_CRTP<void, Output_Compressed>::operator();
 
-    string buffer;
-    string rendered_imports;
+    Emitter  own_buffer;
+    Emitter& buffer;
     Context* ctx;
 
     void fallback_impl(AST_Node* n);
@@ -22,10 +26,11 @@ namespace Sass {
     void append_singleline_part_to_buffer(const string& text);
 
   public:
-    Output_Compressed(Context* ctx = 0);
+    // Appends to `out` if given, rather than a buffer of its own.
+    Output_Compressed(Context* ctx = 0, Emitter* out = 0);
     virtual ~Output_Compressed();
 
-    string get_buffer() { return rendered_imports + buffer; }
+    string get_buffer() { return buffer.str(); }
 
     // statements
     virtual void operator()(Block*);
@@ -9,31 +9,34 @@
 namespace Sass {
   using namespace std;
 
-  Output_Nested::Output_Nested(bool source_comments, Context* ctx)
-  : buffer(""), rendered_imports(""), indentation(0), source_comments(source_comments), ctx(ctx)
+  Output_Nested::Output_Nested(bool source_comments, Context* ctx, Emitter* out)
+  : own_buffer(), buffer(out ? *out : own_buffer), imports_pending(false),
+    indentation(0), source_comments(source_comments), ctx(ctx)
   { }
   Output_Nested::~Output_Nested() { }
 
   inline void Output_Nested::fallback_impl(AST_Node* n)
   {
-    Inspect i(ctx);
+    if (imports_pending) append_to_buffer(""); // settles the newline first
+    Inspect i(ctx, &buffer);
     n->perform(&i);
-    buffer += i.get_buffer();
   }
 
+  // imports are rendered ahead of everything else; see operator()(Block*)
   void Output_Nested::operator()(Import* imp)
-  {
-    Inspect insp(ctx);
-    imp->perform(&insp);
-    if (!rendered_imports.empty()) {
-      rendered_imports += "\n";
-    }
-    rendered_imports += insp.get_buffer();
-  }
+  { }
 
   void Output_Nested::operator()(Block* b)
   {
     if (!b->is_root()) return;
+    vector<Import*> imports;
+    collect_imports(b, ctx->extensions.empty(), imports);
+    for (size_t i = 0, S = imports.size(); i < S; ++i) {
+      if (i > 0) append_to_buffer("\n");
+      Inspect insp(ctx, &buffer);
+      imports[i]->perform(&insp);
+    }
+    imports_pending = !imports.empty();
     for (size_t i = 0, L = b->length(); i < L; ++i) {
       size_t old_len = buffer.length();
       (*b)[i]->perform(this);
@@ -109,7 +112,7 @@ namespace Sass {
         }
       }
       --indentation;
-      buffer.erase(buffer.length()-1);
+      buffer.erase_last();
       if (ctx) ctx->source_map.remove_line();
       append_to_buffer(" }\n");
     }
@@ -162,7 +165,7 @@ namespace Sass {
     --indentation;
 
     if (hoisted) {
-      buffer.erase(buffer.length()-1);
+      buffer.erase_last();
       if (ctx) ctx->source_map.remove_line();
       append_to_buffer(" }\n");
       --indentation;
@@ -179,7 +182,7 @@ namespace Sass {
     if (hoisted) --indentation;
     if (decls) --indentation;
 
-    buffer.erase(buffer.length()-1);
+    buffer.erase_last();
     if (ctx) ctx->source_map.remove_line();
     append_to_buffer(" }\n");
   }
@@ -231,10 +234,10 @@ namespace Sass {
     }
     if (decls) --indentation;
 
-    buffer.erase(buffer.length()-1);
+    buffer.erase_last();
     if (ctx) ctx->source_map.remove_line();
     if (b->has_hoistable()) {
-      buffer.erase(buffer.length()-1);
+      buffer.erase_last();
       if (ctx) ctx->source_map.remove_line();
     }
     append_to_buffer(" }\n");
@@ -245,7 +248,11 @@ namespace Sass {
 
   void Output_Nested::append_to_buffer(const string& text)
   {
-    buffer += text;
+    if (imports_pending) {
+      imports_pending = false;
+      append_to_buffer("\n");
+    }
+    buffer.append(text);
     if (ctx) ctx->source_map.update_column(text);
   }
 
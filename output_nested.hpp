@@ -4,6 +4,10 @@
 #include "operation.hpp"
 #endif
 
+#ifndef SASS_EMITTER
+#include "emitter.hpp"
+#endif
+
 // #ifndef SASS_TO_STRING
 // #include "to_string.hpp"
 // #endif
@@ -16,9 +20,10 @@ namespace Sass {
     // import all the class-specific methods and override as desired
     using Operation_CRTP<void, Output_Nested>::operator();
 
-    string buffer;
-    string rendered_imports;
-    size_t indentation;
+    Emitter  own_buffer;
+    Emitter& buffer;
+    bool     imports_pending; // the newline after the imports is still due
+    size_t   indentation;
     bool source_comments;
     Context* ctx;
     void indent();
@@ -29,15 +34,11 @@ namespace Sass {
 
   public:
 
-    Output_Nested(bool source_comments = false, Context* ctx = 0);
+    // Appends to `out` if given, rather than a buffer of its own.
+    Output_Nested(bool source_comments = false, Context* ctx = 0, Emitter* out = 0);
     virtual ~Output_Nested();
 
-    string get_buffer() {
-        if (!rendered_imports.empty() && !buffer.empty()) {
-            rendered_imports += "\n";
-        }
-        return rendered_imports + buffer;
-    }
+    string get_buffer() { return buffer.str(); }
 
     // statements
     virtual void operator()(Block*);
@@ -0,0 +1,80 @@
+#include "parse_cache.hpp"
+
+#ifndef SASS_AST
+#include "ast.hpp"
+#endif
+
+namespace Sass {
+
+  Parse_Cache::Parse_Cache()
+  : entries(map<string, Entry*>()), retired(vector<Entry*>()), hits_(0), misses_(0)
+  { }
+
+  Parse_Cache::~Parse_Cache()
+  {
+    for (map<string, Entry*>::iterator i = entries.begin(); i != entries.end(); ++i) delete i->second;
+    for (size_t i = 0, S = retired.size(); i < S; ++i) delete retired[i];
+  }
+
+  Parse_Cache::Entry* Parse_Cache::find(const string& path, const char* source, size_t file_index)
+  {
+    mutex.lock();
+    map<string, Entry*>::iterator i = entries.find(path);
+    Entry* entry = i == entries.end() ? 0 : i->second;
+    mutex.unlock();
+    if (!entry) return 0;
+    if (file_index && entry->file_index != file_index) return 0;
+    if (entry->source != source) return 0;
+    return entry;
+  }
+
+  void Parse_Cache::insert(Entry* entry)
+  {
+    mutex.lock();
+    ++misses_;
+    Entry*& slot = entries[entry->path];
+    if (slot) retired.push_back(slot);
+    slot = entry;
+    mutex.unlock();
+  }
+
+  void Parse_Cache::count_hit()
+  {
+    mutex.lock();
+    ++hits_;
+    mutex.unlock();
+  }
+
+  void Parse_Cache::collect()
+  {
+    mutex.lock();
+    for (size_t i = 0, S = retired.size(); i < S; ++i) delete retired[i];
+    retired.clear();
+    mutex.unlock();
+  }
+
+  size_t Parse_Cache::hits()
+  {
+    mutex.lock();
+    size_t n = hits_;
+    mutex.unlock();
+    return n;
+  }
+
+  size_t Parse_Cache::misses()
+  {
+    mutex.lock();
+    size_t n = misses_;
+    mutex.unlock();
+    return n;
+  }
+
+  size_t Parse_Cache::size()
+  {
+    mutex.lock();
+    size_t n = entries.size();
+    mutex.unlock();
+    return n;
+  }
+
+}
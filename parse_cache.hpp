@@ -0,0 +1,88 @@
+#define SASS_PARSE_CACHE
+
+#include <string>
+#include <vector>
+#include <map>
+
+#ifndef SASS_MUTEX
+#include "mutex.hpp"
+#endif
+
+#ifndef SASS_MEMORY_MANAGER
+#include "memory_manager.hpp"
+#endif
+
+namespace Sass {
+  using std::string;
+  using std::vector;
+  using std::map;
+
+  class AST_Node;
+  class Block;
+
+  // An @import made while parsing a file, replayed whenever its cached tree
+  // is reused so that the importing context queues the same files.
+  struct Import_Request {
+    bool   relative; // made with add_file(dir, path) rather than add_file(path)
+    string dir;
+    string path;
+    string resolved;
+
+    Import_Request(bool relative, const string& dir, const string& path, const string& resolved)
+    : relative(relative), dir(dir), path(path), resolved(resolved)
+    { }
+  };
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Parsed style sheets kept across compiles. Entries are keyed on the path a
+  // style sheet is queued under and only reused when the file's contents are
+  // unchanged. Each entry owns the arena its tree was parsed into, so trees
+  // outlive the contexts that use them; evaluation copies a parsed node
+  // rather than change it, so any number of compiles may share the cache at
+  // once.
+  /////////////////////////////////////////////////////////////////////////////
+  class Parse_Cache {
+  public:
+    struct Entry {
+      string                   path;   // nodes point into this
+      string                   source;
+      size_t                   file_index;
+      Memory_Manager<AST_Node> mem;
+      Block*                   root;
+      vector<Import_Request>   imports;
+
+      Entry(const string& path, const char* source, size_t file_index)
+      : path(path), source(source), file_index(file_index),
+        mem(Memory_Manager<AST_Node>()), root(0), imports(vector<Import_Request>())
+      { }
+    };
+
+    Parse_Cache();
+    ~Parse_Cache();
+
+    // file_index is the source-map index the tree must have been parsed
+    // with, or 0 when positions don't need to match
+    Entry* find(const string& path, const char* source, size_t file_index);
+    void   insert(Entry*);
+    void   count_hit();
+    // frees the entries replaced so far; only while no compile is using
+    // the cache
+    void   collect();
+
+    size_t hits();
+    size_t misses();
+    size_t size();
+
+  private:
+    Parse_Cache(const Parse_Cache&);
+    Parse_Cache& operator=(const Parse_Cache&);
+
+    map<string, Entry*> entries;
+    // replaced entries may still be in use by a running compile
+    vector<Entry*>      retired;
+    size_t              hits_;
+    size_t              misses_;
+    Mutex               mutex;
+  };
+
+}
@@ -13,92 +13,180 @@
 #endif
 
 #include <typeinfo>
+#include <cstring>
+#include <algorithm>
 
 namespace Sass {
   using namespace std;
   using namespace Constants;
 
-  Parser Parser::from_c_str(const char* str, Context& ctx, string path, Position source_position)
+  Parser Parser::from_c_str(const char* str, Context& ctx, const char* path, Position source_position,
+                            Memory_Manager<Sass::AST_Node>* mem, Context::Pending_Imports* pending)
   {
-    Parser p(ctx, path, source_position);
+    Parser p(ctx, path, source_position, mem, pending);
     p.source   = str;
     p.position = p.source;
     p.end      = str + strlen(str);
+    p.index_lines();
     return p;
   }
 
-  Parser Parser::from_token(Token t, Context& ctx, string path, Position source_position)
+  Parser Parser::from_token(Token t, Context& ctx, const char* path, Position source_position)
   {
     Parser p(ctx, path, source_position);
     p.source   = t.begin;
     p.position = p.source;
     p.end      = t.end;
+    p.index_lines();
+    return p;
+  }
+
+  // parses a slice of the current source into the same arena
+  Parser Parser::sub_parser(Token t)
+  {
+    Parser p(ctx, path, source_position, &mem, pending);
+    p.source   = t.begin;
+    p.position = p.source;
+    p.end      = t.end;
+    p.index_lines();
     return p;
   }
 
+  void Parser::index_lines()
+  {
+    line_starts.clear();
+    line_starts.push_back(source);
+    for (const char* p = source; (p = static_cast<const char*>(memchr(p, '\n', end - p))); ) {
+      line_starts.push_back(++p);
+    }
+    line_cursor = 0;
+  }
+
+  // Lexing mostly moves forward, so the line of the last lookup is the
+  // place to start from.
+  size_t Parser::line_of(const char* p)
+  {
+    if (p < line_starts[line_cursor]) {
+      line_cursor = upper_bound(line_starts.begin(), line_starts.begin() + line_cursor, p) - line_starts.begin() - 1;
+    }
+    while (line_cursor + 1 < line_starts.size() && line_starts[line_cursor + 1] <= p) ++line_cursor;
+    return line_cursor;
+  }
+
+  // The directive names, placed by a hash of their first two characters and
+  // length that happens to be perfect for them. Adding one means finding
+  // new multipliers for directive_hash.
+  struct Directive_Name {
+    const char*       name;
+    size_t            length;
+    Parser::Directive directive;
+  };
+
+  static const Directive_Name directive_names[16] = {
+    { "charset",  7, Parser::at_charset  },
+    { "return",   6, Parser::at_return   },
+    { "warn",     4, Parser::at_warn     },
+    { 0,          0, Parser::at_unknown  },
+    { "for",      3, Parser::at_for      },
+    { "extend",   6, Parser::at_extend   },
+    { "import",   6, Parser::at_import   },
+    { "content",  7, Parser::at_content  },
+    { "include",  7, Parser::at_include  },
+    { "media",    5, Parser::at_media    },
+    { "while",    5, Parser::at_while    },
+    { "if",       2, Parser::at_if       },
+    { "each",     4, Parser::at_each     },
+    { "mixin",    5, Parser::at_mixin    },
+    { 0,          0, Parser::at_unknown  },
+    { "function", 8, Parser::at_function }
+  };
+
+  static size_t directive_hash(const char* name, size_t length)
+  { return (name[0] * 11 + name[1] + length) & 15; }
+
+  // Classifies what starts at `src`: no directive at all, or the directive
+  // named by the identifier after the '@'. Unlike the prelexers for each
+  // directive, this needs the whole name to match, so e.g. `@iffy` is an
+  // unknown directive rather than an `@if`.
+  Parser::Directive Parser::directive_at(const char* src)
+  {
+    if (*src != '@') return no_directive;
+    const char* name = src + 1;
+    const char* name_end = identifier(name);
+    if (!name_end) return no_directive;
+    size_t length = name_end - name;
+    const Directive_Name& d = directive_names[directive_hash(name, length)];
+    if (d.length == length && !memcmp(d.name, name, length)) return d.directive;
+    return at_unknown;
+  }
+
   Block* Parser::parse()
   {
-    Block* root = new (ctx.mem) Block(path, source_position);
+    Block* root = new (mem) Block(path, source_position);
     root->is_root(true);
     read_bom();
     lex< optional_spaces >();
     Selector_Lookahead lookahead_result;
     while (position < end) {
+      // skip the whitespace once, and let what follows it pick the statement
+      const char* start = spaces_and_comments(position);
+      Directive directive = directive_at(start);
       if (lex< block_comment >()) {
         String*  contents = parse_interpolated_chunk(lexed);
-        Comment* comment  = new (ctx.mem) Comment(path, source_position, contents);
+        Comment* comment  = new (mem) Comment(path, source_position, contents);
         (*root) << comment;
       }
-      else if (peek< import >()) {
+      else if (directive == at_import) {
         Import* imp = parse_import();
         if (!imp->urls().empty()) (*root) << imp;
         if (!imp->files().empty()) {
           for (size_t i = 0, S = imp->files().size(); i < S; ++i) {
-            (*root) << new (ctx.mem) Import_Stub(path, source_position, imp->files()[i]);
+            (*root) << new (mem) Import_Stub(path, source_position, imp->files()[i]);
           }
         }
         if (!lex< exactly<';'> >()) error("top-level @import directive must be terminated by ';'");
       }
-      else if (peek< mixin >() || peek< function >()) {
+      else if (directive == at_mixin || directive == at_function) {
         (*root) << parse_definition();
       }
-      else if (peek< variable >()) {
+      else if (*start == '$' && peek< variable >(start)) {
         (*root) << parse_assignment();
         if (!lex< exactly<';'> >()) error("top-level variable binding must be terminated by ';'");
       }
-      else if (peek< sequence< optional< exactly<'*'> >, alternatives< identifier_schema, identifier >, optional_spaces, exactly<':'>, optional_spaces, exactly<'{'> > >(position)) {
+      else if (directive == no_directive && peek< sequence< optional< exactly<'*'> >, alternatives< identifier_schema, identifier >, optional_spaces, exactly<':'>, optional_spaces, exactly<'{'> > >(start)) {
         (*root) << parse_propset();
       }
-      else if (peek< include >() /* || peek< exactly<'+'> >() */) {
+      else if (directive == at_include /* || peek< exactly<'+'> >() */) {
         Mixin_Call* mixin_call = parse_mixin_call();
         (*root) << mixin_call;
         if (!mixin_call->block() && !lex< exactly<';'> >()) error("top-level @include directive must be terminated by ';'");
       }
-      else if (peek< if_directive >()) {
+      else if (directive == at_if) {
         (*root) << parse_if_directive();
       }
-      else if (peek< for_directive >()) {
+      else if (directive == at_for) {
         (*root) << parse_for_directive();
       }
-      else if (peek< each_directive >()) {
+      else if (directive == at_each) {
         (*root) << parse_each_directive();
       }
-      else if (peek< while_directive >()) {
+      else if (directive == at_while) {
         (*root) << parse_while_directive();
       }
-      else if (peek< media >()) {
+      else if (directive == at_media) {
         (*root) << parse_media_block();
       }
-      else if (peek< warn >()) {
+      else if (directive == at_warn) {
         (*root) << parse_warning();
         if (!lex< exactly<';'> >()) error("top-level @warn directive must be terminated by ';'");
       }
       // ignore the @charset directive for now
-      else if (lex< exactly< charset_kwd > >()) {
+      else if (directive == at_charset) {
+        lex< exactly< charset_kwd > >();
         lex< string_constant >();
         lex< exactly<';'> >();
       }
-      else if (peek< at_keyword >()) {
+      else if (directive != no_directive) {
         At_Rule* at_rule = parse_at_rule();
         (*root) << at_rule;
         if (!at_rule->block() && !lex< exactly<';'> >()) error("top-level directive must be terminated by ';'");
@@ -121,7 +209,7 @@ namespace Sass {
   Import* Parser::parse_import()
   {
     lex< import >();
-    Import* imp = new (ctx.mem) Import(path, source_position);
+    Import* imp = new (mem) Import(path, source_position);
     bool first = true;
     do {
       if (lex< string_constant >()) {
@@ -132,11 +220,11 @@ namespace Sass {
           extension = import_path.substr(import_path.length() - 5, 4);
         }
         if (extension == ".css") {
-          String_Constant* loc = new (ctx.mem) String_Constant(path, source_position, import_path, true);
-          Argument* loc_arg = new (ctx.mem) Argument(path, source_position, loc);
-          Arguments* loc_args = new (ctx.mem) Arguments(path, source_position);
+          String_Constant* loc = new (mem) String_Constant(path, source_position, import_path, true);
+          Argument* loc_arg = new (mem) Argument(path, source_position, loc);
+          Arguments* loc_args = new (mem) Arguments(path, source_position);
           (*loc_args) << loc_arg;
-          Function_Call* new_url = new (ctx.mem) Function_Call(path, source_position, "url", loc_args);
+          Function_Call* new_url = new (mem) Function_Call(path, source_position, "url", loc_args);
           imp->urls().push_back(new_url);
         }
         else {
@@ -146,13 +234,15 @@ namespace Sass {
 
           if (paths.size() > 0) {
             for(std::vector<string>::iterator i = paths.begin(); i != paths.end(); ++i) {
-              string resolved(ctx.add_file(*i));
+              string resolved(import_file(*i));
               if (resolved.empty()) error("file to import not found or unreadable: " + import_path);
+              if (import_log) import_log->push_back(Import_Request(false, "", *i, resolved));
               imp->files().push_back(resolved);  
             }
           } else {
-            string resolved(ctx.add_file(current_dir, unquote(import_path)));
+            string resolved(import_file(current_dir, unquote(import_path)));
             if (resolved.empty()) error("file to import not found or unreadable: " + import_path);
+            if (import_log) import_log->push_back(Import_Request(true, current_dir, unquote(import_path), resolved));
             imp->files().push_back(resolved);
           }
         }
@@ -169,6 +259,25 @@ namespace Sass {
     return imp;
   }
 
+  // a parse worker only records what it finds; the context queues it later
+  string Parser::import_file(string path)
+  {
+    if (!pending) return ctx.add_file(path);
+    Context::Loaded_File file;
+    string full_path(ctx.locate_file(path, file, pending->included_files, pending->fs_calls));
+    if (file.contents) pending->files.push_back(file);
+    return full_path;
+  }
+
+  string Parser::import_file(string dir, string rel_filepath)
+  {
+    if (!pending) return ctx.add_file(dir, rel_filepath);
+    Context::Loaded_File file;
+    string full_path(ctx.locate_file(dir, rel_filepath, file, pending->included_files, pending->fs_calls));
+    if (file.contents) pending->files.push_back(file);
+    return full_path;
+  }
+
   Definition* Parser::parse_definition()
   {
     Definition::Type which_type = Definition::MIXIN;
@@ -184,14 +293,14 @@ namespace Sass {
     else stack.push_back(function_def);
     Block* body = parse_block();
     stack.pop_back();
-    Definition* def = new (ctx.mem) Definition(path, source_position_of_def, name, params, body, which_type);
+    Definition* def = new (mem) Definition(path, source_position_of_def, name, params, body, which_type);
     return def;
   }
 
   Parameters* Parser::parse_parameters()
   {
     string name(lexed); // for the error message
-    Parameters* params = new (ctx.mem) Parameters(path, source_position);
+    Parameters* params = new (mem) Parameters(path, source_position);
     if (lex< exactly<'('> >()) {
       // if there's anything there at all
       if (!peek< exactly<')'> >()) {
@@ -217,7 +326,7 @@ namespace Sass {
     else if (lex< exactly< ellipsis > >()) {
       is_rest = true;
     }
-    Parameter* p = new (ctx.mem) Parameter(path, pos, name, val, is_rest);
+    Parameter* p = new (mem) Parameter(path, pos, name, val, is_rest);
     return p;
   }
 
@@ -232,14 +341,14 @@ namespace Sass {
     if (peek< exactly<'{'> >()) {
       content = parse_block();
     }
-    Mixin_Call* the_call = new (ctx.mem) Mixin_Call(path, source_position_of_call, name, args, content);
+    Mixin_Call* the_call = new (mem) Mixin_Call(path, source_position_of_call, name, args, content);
     return the_call;
   }
 
   Arguments* Parser::parse_arguments()
   {
     string name(lexed);
-    Arguments* args = new (ctx.mem) Arguments(path, source_position);
+    Arguments* args = new (mem) Arguments(path, source_position);
 
     if (lex< exactly<'('> >()) {
       // if there's anything there at all
@@ -263,7 +372,7 @@ namespace Sass {
       lex< exactly<':'> >();
       Expression* val = parse_space_list();
       val->is_delayed(false);
-      arg = new (ctx.mem) Argument(path, p, val, name);
+      arg = new (mem) Argument(path, p, val, name);
     }
     else {
       bool is_arglist = false;
@@ -272,7 +381,7 @@ namespace Sass {
       if (lex< exactly< ellipsis > >()) {
         is_arglist = true;
       }
-      arg = new (ctx.mem) Argument(path, source_position, val, "", is_arglist);
+      arg = new (mem) Argument(path, source_position, val, "", is_arglist);
     }
     return arg;
   }
@@ -287,7 +396,7 @@ namespace Sass {
     val->is_delayed(false);
     bool is_guarded = lex< default_flag >();
     bool is_global = lex< global_flag >();
-    Assignment* var = new (ctx.mem) Assignment(path, var_source_position, name, val, is_guarded, is_global);
+    Assignment* var = new (mem) Assignment(path, var_source_position, name, val, is_guarded, is_global);
     return var;
   }
 
@@ -299,9 +408,9 @@ namespace Sass {
     }
     else {
       lex< sequence< optional< exactly<'*'> >, identifier > >();
-      property_segment = new (ctx.mem) String_Constant(path, source_position, lexed);
+      property_segment = new (mem) String_Constant(path, source_position, lexed);
     }
-    Propset* propset = new (ctx.mem) Propset(path, source_position, property_segment);
+    Propset* propset = new (mem) Propset(path, source_position, property_segment);
     lex< exactly<':'> >();
 
     if (!peek< exactly<'{'> >()) error("expected a '{' after namespaced property");
@@ -323,7 +432,7 @@ namespace Sass {
     Position r_source_position = source_position;
     if (!peek< exactly<'{'> >()) error("expected a '{' after the selector");
     Block* block = parse_block();
-    Ruleset* ruleset = new (ctx.mem) Ruleset(path, r_source_position, sel, block);
+    Ruleset* ruleset = new (mem) Ruleset(path, r_source_position, sel, block);
     return ruleset;
   }
 
@@ -332,33 +441,33 @@ namespace Sass {
     lex< optional_spaces >();
     const char* i = position;
     const char* p;
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (mem) String_Schema(path, source_position);
 
     while (i < end_of_selector) {
       p = find_first_in_interval< exactly<hash_lbrace> >(i, end_of_selector);
       if (p) {
         // accumulate the preceding segment if there is one
-        if (i < p) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p));
+        if (i < p) (*schema) << new (mem) String_Constant(path, source_position, Token(i, p));
         // find the end of the interpolant and parse it
         const char* j = find_first_in_interval< exactly<rbrace> >(p, end_of_selector);
-        Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+        Expression* interp_node = sub_parser(Token(p+2, j)).parse_list();
         interp_node->is_interpolant(true);
         (*schema) << interp_node;
         i = j + 1;
       }
       else { // no interpolants left; add the last segment if there is one
-        if (i < end_of_selector) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, end_of_selector));
+        if (i < end_of_selector) (*schema) << new (mem) String_Constant(path, source_position, Token(i, end_of_selector));
         break;
       }
     }
     position = end_of_selector;
-    return new (ctx.mem) Selector_Schema(path, source_position, schema);
+    return new (mem) Selector_Schema(path, source_position, schema);
   }
 
   Selector_List* Parser::parse_selector_group()
   {
     To_String to_string;
-    Selector_List* group = new (ctx.mem) Selector_List(path, source_position);
+    Selector_List* group = new (mem) Selector_List(path, source_position);
     do {
       if (peek< exactly<'{'> >() ||
           peek< exactly<'}'> >() ||
@@ -368,15 +477,15 @@ namespace Sass {
       Complex_Selector* comb = parse_selector_combination();
       if (!comb->has_reference()) {
         Position sel_source_position = source_position;
-        Selector_Reference* ref = new (ctx.mem) Selector_Reference(path, sel_source_position);
-        Compound_Selector* ref_wrap = new (ctx.mem) Compound_Selector(path, sel_source_position);
+        Selector_Reference* ref = new (mem) Selector_Reference(path, sel_source_position);
+        Compound_Selector* ref_wrap = new (mem) Compound_Selector(path, sel_source_position);
         (*ref_wrap) << ref;
         if (!comb->head()) {
           comb->head(ref_wrap);
           comb->has_reference(true);
         }
         else {
-          comb = new (ctx.mem) Complex_Selector(path, sel_source_position, Complex_Selector::ANCESTOR_OF, ref_wrap, comb);
+          comb = new (mem) Complex_Selector(path, sel_source_position, Complex_Selector::ANCESTOR_OF, ref_wrap, comb);
           comb->has_reference(true);
         }
       }
@@ -421,16 +530,16 @@ namespace Sass {
       sel_source_position = source_position;
     }
     if (!sel_source_position.line) sel_source_position = source_position;
-    return new (ctx.mem) Complex_Selector(path, sel_source_position, cmb, lhs, rhs);
+    return new (mem) Complex_Selector(path, sel_source_position, cmb, lhs, rhs);
   }
 
   Compound_Selector* Parser::parse_simple_selector_sequence()
   {
-    Compound_Selector* seq = new (ctx.mem) Compound_Selector(path, source_position);
+    Compound_Selector* seq = new (mem) Compound_Selector(path, source_position);
     bool sawsomething = false;
     if (lex< exactly<'&'> >()) {
       // if you see a &
-      (*seq) << new (ctx.mem) Selector_Reference(path, source_position);
+      (*seq) << new (mem) Selector_Reference(path, source_position);
       sawsomething = true;
       // if you see a space after a &, then you're done
       if(lex< spaces >()) {
@@ -439,10 +548,10 @@ namespace Sass {
     }
     if (sawsomething && lex< sequence< negate< functional >, alternatives< hyphens_and_identifier, universal, string_constant, dimension, percentage, number > > >()) {
       // saw an ampersand, then allow type selectors with arbitrary number of hyphens at the beginning
-      (*seq) << new (ctx.mem) Type_Selector(path, source_position, lexed);
+      (*seq) << new (mem) Type_Selector(path, source_position, lexed);
     } else if (lex< sequence< negate< functional >, alternatives< type_selector, universal, string_constant, dimension, percentage, number > > >()) {
       // if you see a type selector
-      (*seq) << new (ctx.mem) Type_Selector(path, source_position, lexed);
+      (*seq) << new (mem) Type_Selector(path, source_position, lexed);
       sawsomething = true;
     }
     if (!sawsomething) {
@@ -467,10 +576,10 @@ namespace Sass {
   Simple_Selector* Parser::parse_simple_selector()
   {
     if (lex< id_name >() || lex< class_name >()) {
-      return new (ctx.mem) Selector_Qualifier(path, source_position, lexed);
+      return new (mem) Selector_Qualifier(path, source_position, lexed);
     }
     else if (lex< string_constant >() || lex< number >()) {
-      return new (ctx.mem) Type_Selector(path, source_position, lexed);
+      return new (mem) Type_Selector(path, source_position, lexed);
     }
     else if (peek< pseudo_not >()) {
       return parse_negated_selector();
@@ -482,7 +591,7 @@ namespace Sass {
       return parse_attribute_selector();
     }
     else if (lex< placeholder >()) {
-      return new (ctx.mem) Selector_Placeholder(path, source_position, lexed);
+      return new (mem) Selector_Placeholder(path, source_position, lexed);
     }
     else {
       error("invalid selector after " + lexed.to_string());
@@ -500,7 +609,7 @@ namespace Sass {
     if (!lex< exactly<')'> >()) {
       error("negated selector is missing ')'");
     }
-    return new (ctx.mem) Wrapped_Selector(path, nsource_position, name, negated);
+    return new (mem) Wrapped_Selector(path, nsource_position, name, negated);
   }
 
   Simple_Selector* Parser::parse_pseudo_selector() {
@@ -510,18 +619,18 @@ namespace Sass {
       Position p = source_position;
       Selector* wrapped = 0;
       if (lex< alternatives< even, odd > >()) {
-        expr = new (ctx.mem) String_Constant(path, p, lexed);
+        expr = new (mem) String_Constant(path, p, lexed);
       }
       else if (peek< binomial >(position)) {
         lex< sequence< optional< coefficient >, exactly<'n'> > >();
-        String_Constant* var_coef = new (ctx.mem) String_Constant(path, p, lexed);
+        String_Constant* var_coef = new (mem) String_Constant(path, p, lexed);
         lex< sign >();
-        String_Constant* op = new (ctx.mem) String_Constant(path, p, lexed);
+        String_Constant* op = new (mem) String_Constant(path, p, lexed);
         // Binary_Expression::Type op = (lexed == "+" ? Binary_Expression::ADD : Binary_Expression::SUB);
         lex< digits >();
-        String_Constant* constant = new (ctx.mem) String_Constant(path, p, lexed);
-        // expr = new (ctx.mem) Binary_Expression(path, p, op, var_coef, constant);
-        String_Schema* schema = new (ctx.mem) String_Schema(path, p, 3);
+        String_Constant* constant = new (mem) String_Constant(path, p, lexed);
+        // expr = new (mem) Binary_Expression(path, p, op, var_coef, constant);
+        String_Schema* schema = new (mem) String_Schema(path, p, 3);
         *schema << var_coef << op << constant;
         expr = schema;
       }
@@ -533,32 +642,32 @@ namespace Sass {
         lex< sequence< optional<sign>,
                        optional<digits>,
                        exactly<'n'> > >();
-        expr = new (ctx.mem) String_Constant(path, p, lexed);
+        expr = new (mem) String_Constant(path, p, lexed);
       }
       else if (lex< sequence< optional<sign>, digits > >()) {
-        expr = new (ctx.mem) String_Constant(path, p, lexed);
+        expr = new (mem) String_Constant(path, p, lexed);
       }
       else if (peek< sequence< identifier, spaces_and_comments, exactly<')'> > >()) {
         lex< identifier >();
-        expr = new (ctx.mem) String_Constant(path, p, lexed);
+        expr = new (mem) String_Constant(path, p, lexed);
       }
       else if (lex< string_constant >()) {
-        expr = new (ctx.mem) String_Constant(path, p, lexed);
+        expr = new (mem) String_Constant(path, p, lexed);
       }
       else if (peek< exactly<')'> >()) {
-        expr = new (ctx.mem) String_Constant(path, p, "");
+        expr = new (mem) String_Constant(path, p, "");
       }
       else {
         wrapped = parse_selector_group();
       }
       if (!lex< exactly<')'> >()) error("unterminated argument to " + name + "...)");
       if (wrapped) {
-        return new (ctx.mem) Wrapped_Selector(path, p, name, wrapped);
+        return new (mem) Wrapped_Selector(path, p, name, wrapped);
       }
-      return new (ctx.mem) Pseudo_Selector(path, p, name, expr);
+      return new (mem) Pseudo_Selector(path, p, name, expr);
     }
     else if (lex < sequence< pseudo_prefix, identifier > >()) {
-      return new (ctx.mem) Pseudo_Selector(path, source_position, lexed);
+      return new (mem) Pseudo_Selector(path, source_position, lexed);
     }
     else {
       error("unrecognized pseudo-class or pseudo-element");
@@ -573,7 +682,7 @@ namespace Sass {
     Position p = source_position;
     if (!lex< attribute_name >()) error("invalid attribute name in attribute selector");
     string name(lexed);
-    if (lex< exactly<']'> >()) return new (ctx.mem) Attribute_Selector(path, p, name, "", 0);
+    if (lex< exactly<']'> >()) return new (mem) Attribute_Selector(path, p, name, "", 0);
     if (!lex< alternatives< exact_match, class_match, dash_match,
                             prefix_match, suffix_match, substring_match > >()) {
       error("invalid operator in attribute selector for " + name);
@@ -582,7 +691,7 @@ namespace Sass {
 
     String* value = 0;
     if (lex< identifier >()) {
-      value = new (ctx.mem) String_Constant(path, p, lexed, true);
+      value = new (mem) String_Constant(path, p, lexed, true);
     }
     else if (lex< string_constant >()) {
       value = parse_interpolated_chunk(lexed);
@@ -592,7 +701,7 @@ namespace Sass {
     }
 
     if (!lex< exactly<']'> >()) error("unterminated attribute selector for " + name);
-    return new (ctx.mem) Attribute_Selector(path, p, name, matcher, value);
+    return new (mem) Attribute_Selector(path, p, name, matcher, value);
   }
 
   Block* Parser::parse_block()
@@ -600,7 +709,7 @@ namespace Sass {
     lex< exactly<'{'> >();
     bool semicolon = false;
     Selector_Lookahead lookahead_result;
-    Block* block = new (ctx.mem) Block(path, source_position);
+    Block* block = new (mem) Block(path, source_position);
     while (!lex< exactly<'}'> >()) {
       if (semicolon) {
         if (!lex< exactly<';'> >()) {
@@ -609,17 +718,19 @@ namespace Sass {
         semicolon = false;
         while (lex< block_comment >()) {
           String*  contents = parse_interpolated_chunk(lexed);
-          Comment* comment  = new (ctx.mem) Comment(path, source_position, contents);
+          Comment* comment  = new (mem) Comment(path, source_position, contents);
           (*block) << comment;
         }
         if (lex< exactly<'}'> >()) break;
       }
+      const char* start = spaces_and_comments(position);
+      Directive directive = directive_at(start);
       if (lex< block_comment >()) {
         String*  contents = parse_interpolated_chunk(lexed);
-        Comment* comment  = new (ctx.mem) Comment(path, source_position, contents);
+        Comment* comment  = new (mem) Comment(path, source_position, contents);
         (*block) << comment;
       }
-      else if (peek< import >(position)) {
+      else if (directive == at_import) {
         if (stack.back() == mixin_def || stack.back() == function_def) {
           lex< import >(); // to adjust the source_position number
           error("@import directives are not allowed inside mixins and functions");
@@ -628,52 +739,54 @@ namespace Sass {
         if (!imp->urls().empty()) (*block) << imp;
         if (!imp->files().empty()) {
           for (size_t i = 0, S = imp->files().size(); i < S; ++i) {
-            (*block) << new (ctx.mem) Import_Stub(path, source_position, imp->files()[i]);
+            (*block) << new (mem) Import_Stub(path, source_position, imp->files()[i]);
           }
         }
         semicolon = true;
       }
-      else if (lex< variable >()) {
+      else if (*start == '$' && lex< variable >()) {
         (*block) << parse_assignment();
         semicolon = true;
       }
-      else if (peek< if_directive >()) {
+      else if (directive == at_if) {
         (*block) << parse_if_directive();
       }
-      else if (peek< for_directive >()) {
+      else if (directive == at_for) {
         (*block) << parse_for_directive();
       }
-      else if (peek< each_directive >()) {
+      else if (directive == at_each) {
         (*block) << parse_each_directive();
       }
-      else if (peek < while_directive >()) {
+      else if (directive == at_while) {
         (*block) << parse_while_directive();
       }
-      else if (lex < return_directive >()) {
-        (*block) << new (ctx.mem) Return(path, source_position, parse_list());
+      else if (directive == at_return) {
+        lex< return_directive >();
+        (*block) << new (mem) Return(path, source_position, parse_list());
         semicolon = true;
       }
-      else if (peek< warn >()) {
+      else if (directive == at_warn) {
         (*block) << parse_warning();
         semicolon = true;
       }
       else if (stack.back() == function_def) {
         error("only variable declarations and control directives are allowed inside functions");
       }
-      else if (peek< mixin >() || peek< function >()) {
+      else if (directive == at_mixin || directive == at_function) {
         (*block) << parse_definition();
       }
-      else if (peek< include >(position)) {
+      else if (directive == at_include) {
         Mixin_Call* the_call = parse_mixin_call();
         (*block) << the_call;
         // don't need a semicolon after a content block
         semicolon = (the_call->block()) ? false : true;
       }
-      else if (lex< content >()) {
+      else if (directive == at_content) {
+        lex< content >();
         if (stack.back() != mixin_def) {
           error("@content may only be used within a mixin");
         }
-        (*block) << new (ctx.mem) Content(path, source_position);
+        (*block) << new (mem) Content(path, source_position);
         semicolon = true;
       }
       /*
@@ -682,24 +795,26 @@ namespace Sass {
         semicolon = true;
       }
       */
-      else if (lex< extend >()) {
+      else if (directive == at_extend) {
+        lex< extend >();
         Selector_Lookahead lookahead = lookahead_for_extension_target(position);
         if (!lookahead.found) error("invalid selector for @extend");
         Selector* target;
         if (lookahead.has_interpolants) target = parse_selector_schema(lookahead.found);
         else                            target = parse_selector_group();
-        (*block) << new (ctx.mem) Extension(path, source_position, target);
+        (*block) << new (mem) Extension(path, source_position, target);
         semicolon = true;
       }
-      else if (peek< media >()) {
+      else if (directive == at_media) {
         (*block) << parse_media_block();
       }
       // ignore the @charset directive for now
-      else if (lex< exactly< charset_kwd > >()) {
+      else if (directive == at_charset) {
+        lex< exactly< charset_kwd > >();
         lex< string_constant >();
         lex< exactly<';'> >();
       }
-      else if (peek< at_keyword >()) {
+      else if (directive != no_directive) {
         At_Rule* at_rule = parse_at_rule();
         (*block) << at_rule;
         if (!at_rule->block()) semicolon = true;
@@ -722,7 +837,7 @@ namespace Sass {
           (*block) << decl;
           if (peek< exactly<'{'> >()) {
             // parse a propset that rides on the declaration's property
-            Propset* ps = new (ctx.mem) Propset(path, source_position, decl->property(), parse_block());
+            Propset* ps = new (mem) Propset(path, source_position, decl->property(), parse_block());
             (*block) << ps;
           }
           else {
@@ -734,7 +849,7 @@ namespace Sass {
       else lex< exactly<';'> >();
       while (lex< block_comment >()) {
         String*  contents = parse_interpolated_chunk(lexed);
-        Comment* comment  = new (ctx.mem) Comment(path, source_position, contents);
+        Comment* comment  = new (mem) Comment(path, source_position, contents);
         (*block) << comment;
       }
     }
@@ -747,7 +862,7 @@ namespace Sass {
       prop = parse_identifier_schema();
     }
     else if (lex< sequence< optional< exactly<'*'> >, identifier > >()) {
-      prop = new (ctx.mem) String_Constant(path, source_position, lexed);
+      prop = new (mem) String_Constant(path, source_position, lexed);
     }
     else {
       error("invalid property name");
@@ -755,7 +870,7 @@ namespace Sass {
     if (!lex< exactly<':'> >()) error("property \"" + string(lexed) + "\" must be followed by a ':'");
     if (peek< exactly<';'> >()) error("style declaration must contain a value");
     Expression* list = parse_list();
-    return new (ctx.mem) Declaration(path, prop->position(), prop, list/*, lex<important>()*/);
+    return new (mem) Declaration(path, prop->position(), prop, list/*, lex<important>()*/);
   }
 
   Expression* Parser::parse_list()
@@ -772,12 +887,12 @@ namespace Sass {
         peek< exactly<')'> >(position) ||
         //peek< exactly<':'> >(position) ||
         peek< exactly<ellipsis> >(position))
-    { return new (ctx.mem) List(path, source_position, 0); }
+    { return new (mem) List(path, source_position, 0); }
     Expression* list1 = parse_space_list();
     // if it's a singleton, return it directly; don't wrap it
     if (!peek< exactly<','> >(position)) return list1;
 
-    List* comma_list = new (ctx.mem) List(path, source_position, 2, List::COMMA);
+    List* comma_list = new (mem) List(path, source_position, 2, List::COMMA);
     (*comma_list) << list1;
 
     while (lex< exactly<','> >())
@@ -814,7 +929,7 @@ namespace Sass {
         peek< global_flag >(position))
     { return disj1; }
 
-    List* space_list = new (ctx.mem) List(path, source_position, 2, List::SPACE);
+    List* space_list = new (mem) List(path, source_position, 2, List::SPACE);
     (*space_list) << disj1;
 
     while (!(//peek< exactly<'!'> >(position) ||
@@ -883,7 +998,7 @@ namespace Sass {
 
     Expression* expr2 = parse_expression();
 
-    return new (ctx.mem) Binary_Expression(path, expr1->position(), op, expr1, expr2);
+    return new (mem) Binary_Expression(path, expr1->position(), op, expr1, expr2);
   }
 
   Expression* Parser::parse_expression()
@@ -947,18 +1062,18 @@ namespace Sass {
       return parse_ie_stuff();
     }
     else if (peek< ie_keyword_arg >()) {
-      String_Schema* kwd_arg = new (ctx.mem) String_Schema(path, source_position, 3);
-      if (lex< variable >()) *kwd_arg << new (ctx.mem) Variable(path, source_position, Util::normalize_underscores(lexed));
+      String_Schema* kwd_arg = new (mem) String_Schema(path, source_position, 3);
+      if (lex< variable >()) *kwd_arg << new (mem) Variable(path, source_position, Util::normalize_underscores(lexed));
       else {
         lex< alternatives< identifier_schema, identifier > >();
-        *kwd_arg << new (ctx.mem) String_Constant(path, source_position, lexed);
+        *kwd_arg << new (mem) String_Constant(path, source_position, lexed);
       }
       lex< exactly<'='> >();
-      *kwd_arg << new (ctx.mem) String_Constant(path, source_position, lexed);
-      if (lex< variable >()) *kwd_arg << new (ctx.mem) Variable(path, source_position, Util::normalize_underscores(lexed));
+      *kwd_arg << new (mem) String_Constant(path, source_position, lexed);
+      if (lex< variable >()) *kwd_arg << new (mem) Variable(path, source_position, Util::normalize_underscores(lexed));
       else {
         lex< alternatives< identifier_schema, identifier, number, hex > >();
-        *kwd_arg << new (ctx.mem) String_Constant(path, source_position, lexed);
+        *kwd_arg << new (mem) String_Constant(path, source_position, lexed);
       }
       return kwd_arg;
     }
@@ -977,10 +1092,10 @@ namespace Sass {
       return parse_function_call();
     }
     else if (lex< sequence< exactly<'+'>, spaces_and_comments, negate< number > > >()) {
-      return new (ctx.mem) Unary_Expression(path, source_position, Unary_Expression::PLUS, parse_factor());
+      return new (mem) Unary_Expression(path, source_position, Unary_Expression::PLUS, parse_factor());
     }
     else if (lex< sequence< exactly<'-'>, spaces_and_comments, negate< number> > >()) {
-      return new (ctx.mem) Unary_Expression(path, source_position, Unary_Expression::MINUS, parse_factor());
+      return new (mem) Unary_Expression(path, source_position, Unary_Expression::MINUS, parse_factor());
     }
     else {
       return parse_value();
@@ -990,8 +1105,8 @@ namespace Sass {
   Expression* Parser::parse_value()
   {
     if (lex< uri_prefix >()) {
-      Arguments* args = new (ctx.mem) Arguments(path, source_position);
-      Function_Call* result = new (ctx.mem) Function_Call(path, source_position, "url", args);
+      Arguments* args = new (mem) Arguments(path, source_position);
+      Function_Call* result = new (mem) Function_Call(path, source_position, "url", args);
       const char* here = position;
       Position here_p = source_position;
       // Try to parse a SassScript expression. If it succeeds and we can munch
@@ -1004,7 +1119,7 @@ namespace Sass {
         if (peek<line_comment_prefix>() || peek<block_comment_prefix>()) error("comment in URL"); // doesn't really matter what we throw
         Expression* expr = parse_list();
         if (!lex< exactly<')'> >()) error("dangling expression in URL"); // doesn't really matter what we throw
-        Argument* arg = new (ctx.mem) Argument(path, expr->position(), expr);
+        Argument* arg = new (mem) Argument(path, expr->position(), expr);
         *args << arg;
         return result;
       }
@@ -1016,7 +1131,7 @@ namespace Sass {
       lex< spaces >();
       if (lex< url >()) {
         String* the_url = parse_interpolated_chunk(lexed);
-        Argument* arg = new (ctx.mem) Argument(path, the_url->position(), the_url);
+        Argument* arg = new (mem) Argument(path, the_url->position(), the_url);
         *args << arg;
       }
       else {
@@ -1027,43 +1142,43 @@ namespace Sass {
     }
 
     if (lex< important >())
-    { return new (ctx.mem) String_Constant(path, source_position, "!important"); }
+    { return new (mem) String_Constant(path, source_position, "!important"); }
 
     if (lex< value_schema >())
-    { return Parser::from_token(lexed, ctx, path, source_position).parse_value_schema(); }
+    { return sub_parser(lexed).parse_value_schema(); }
 
     if (lex< sequence< true_val, negate< identifier > > >())
-    { return new (ctx.mem) Boolean(path, source_position, true); }
+    { return new (mem) Boolean(path, source_position, true); }
 
     if (lex< sequence< false_val, negate< identifier > > >())
-    { return new (ctx.mem) Boolean(path, source_position, false); }
+    { return new (mem) Boolean(path, source_position, false); }
 
     if (lex< sequence< null, negate< identifier > > >())
-    { return new (ctx.mem) Null(path, source_position); }
+    { return new (mem) Null(path, source_position); }
 
     if (lex< identifier >()) {
-      String_Constant* str = new (ctx.mem) String_Constant(path, source_position, lexed);
+      String_Constant* str = new (mem) String_Constant(path, source_position, lexed);
       str->is_delayed(true);
       return str;
     }
 
     if (lex< percentage >())
-    { return new (ctx.mem) Textual(path, source_position, Textual::PERCENTAGE, lexed); }
+    { return new (mem) Textual(path, source_position, Textual::PERCENTAGE, lexed); }
 
     if (lex< dimension >())
-    { return new (ctx.mem) Textual(path, source_position, Textual::DIMENSION, lexed); }
+    { return new (mem) Textual(path, source_position, Textual::DIMENSION, lexed); }
 
     if (lex< number >())
-    { return new (ctx.mem) Textual(path, source_position, Textual::NUMBER, lexed); }
+    { return new (mem) Textual(path, source_position, Textual::NUMBER, lexed); }
 
     if (lex< hex >())
-    { return new (ctx.mem) Textual(path, source_position, Textual::HEX, lexed); }
+    { return new (mem) Textual(path, source_position, Textual::HEX, lexed); }
 
     if (peek< string_constant >())
     { return parse_string(); }
 
     if (lex< variable >())
-    { return new (ctx.mem) Variable(path, source_position, Util::normalize_underscores(lexed)); }
+    { return new (mem) Variable(path, source_position, Util::normalize_underscores(lexed)); }
 
     error("error reading values after " + lexed.to_string());
 
@@ -1077,23 +1192,23 @@ namespace Sass {
     // see if there any interpolants
     const char* p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(chunk.begin, chunk.end);
     if (!p) {
-      String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position, chunk);
+      String_Constant* str_node = new (mem) String_Constant(path, source_position, chunk);
       str_node->is_delayed(true);
       return str_node;
     }
 
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (mem) String_Schema(path, source_position);
     schema->quote_mark(*chunk.begin);
     while (i < chunk.end) {
       p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(i, chunk.end);
       if (p) {
         if (i < p) {
-          (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
+          (*schema) << new (mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
         }
         const char* j = find_first_in_interval< exactly<rbrace> >(p, chunk.end); // find the closing brace
         if (j) {
           // parse the interpolant and accumulate it
-          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+          Expression* interp_node = sub_parser(Token(p+2, j)).parse_list();
           interp_node->is_interpolant(true);
           (*schema) << interp_node;
           i = j+1;
@@ -1104,7 +1219,7 @@ namespace Sass {
         }
       }
       else { // no interpolants left; add the last segment if nonempty
-        if (i < chunk.end) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, chunk.end));
+        if (i < chunk.end) (*schema) << new (mem) String_Constant(path, source_position, Token(i, chunk.end));
         break;
       }
     }
@@ -1120,23 +1235,23 @@ namespace Sass {
     // // see if there any interpolants
     // const char* p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(str.begin, str.end);
     // if (!p) {
-    //   String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position, str);
+    //   String_Constant* str_node = new (mem) String_Constant(path, source_position, str);
     //   str_node->is_delayed(true);
     //   return str_node;
     // }
 
-    // String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    // String_Schema* schema = new (mem) String_Schema(path, source_position);
     // schema->quote_mark(*str.begin);
     // while (i < str.end) {
     //   p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(i, str.end);
     //   if (p) {
     //     if (i < p) {
-    //       (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
+    //       (*schema) << new (mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
     //     }
     //     const char* j = find_first_in_interval< exactly<rbrace> >(p, str.end); // find the closing brace
     //     if (j) {
     //       // parse the interpolant and accumulate it
-    //       Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+    //       Expression* interp_node = sub_parser(Token(p+2, j)).parse_list();
     //       interp_node->is_interpolant(true);
     //       (*schema) << interp_node;
     //       i = j+1;
@@ -1147,7 +1262,7 @@ namespace Sass {
     //     }
     //   }
     //   else { // no interpolants left; add the last segment if nonempty
-    //     if (i < str.end) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, str.end));
+    //     if (i < str.end) (*schema) << new (mem) String_Constant(path, source_position, Token(i, str.end));
     //     break;
     //   }
     // }
@@ -1164,22 +1279,22 @@ namespace Sass {
     // see if there any interpolants
     const char* p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(str.begin, str.end);
     if (!p) {
-      String_Constant* str_node = new (ctx.mem) String_Constant(path, source_position, str);
+      String_Constant* str_node = new (mem) String_Constant(path, source_position, str);
       str_node->is_delayed(true);
       return str_node;
     }
 
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (mem) String_Schema(path, source_position);
     while (i < str.end) {
       p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(i, str.end);
       if (p) {
         if (i < p) {
-          (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
+          (*schema) << new (mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
         }
         const char* j = find_first_in_interval< exactly<rbrace> >(p, str.end); // find the closing brace
         if (j) {
           // parse the interpolant and accumulate it
-          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+          Expression* interp_node = sub_parser(Token(p+2, j)).parse_list();
           interp_node->is_interpolant(true);
           (*schema) << interp_node;
           i = j+1;
@@ -1190,7 +1305,7 @@ namespace Sass {
         }
       }
       else { // no interpolants left; add the last segment if nonempty
-        if (i < str.end) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, str.end));
+        if (i < str.end) (*schema) << new (mem) String_Constant(path, source_position, Token(i, str.end));
         break;
       }
     }
@@ -1199,36 +1314,36 @@ namespace Sass {
 
   String_Schema* Parser::parse_value_schema()
   {
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (mem) String_Schema(path, source_position);
     size_t num_items = 0;
     while (position < end) {
       if (lex< interpolant >()) {
         Token insides(Token(lexed.begin + 2, lexed.end - 1));
-        Expression* interp_node = Parser::from_token(insides, ctx, path, source_position).parse_list();
+        Expression* interp_node = sub_parser(insides).parse_list();
         interp_node->is_interpolant(true);
         (*schema) << interp_node;
       }
       else if (lex< identifier >()) {
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (mem) String_Constant(path, source_position, lexed);
       }
       else if (lex< percentage >()) {
-        (*schema) << new (ctx.mem) Textual(path, source_position, Textual::PERCENTAGE, lexed);
+        (*schema) << new (mem) Textual(path, source_position, Textual::PERCENTAGE, lexed);
       }
       else if (lex< dimension >()) {
-        (*schema) << new (ctx.mem) Textual(path, source_position, Textual::DIMENSION, lexed);
+        (*schema) << new (mem) Textual(path, source_position, Textual::DIMENSION, lexed);
       }
       else if (lex< number >()) {
-        (*schema) << new (ctx.mem) Textual(path, source_position, Textual::NUMBER, lexed);
+        (*schema) << new (mem) Textual(path, source_position, Textual::NUMBER, lexed);
       }
       else if (lex< hex >()) {
-        (*schema) << new (ctx.mem) Textual(path, source_position, Textual::HEX, lexed);
+        (*schema) << new (mem) Textual(path, source_position, Textual::HEX, lexed);
       }
       else if (lex< string_constant >()) {
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (mem) String_Constant(path, source_position, lexed);
         if (!num_items) schema->quote_mark(*lexed.begin);
       }
       else if (lex< variable >()) {
-        (*schema) << new (ctx.mem) Variable(path, source_position, Util::normalize_underscores(lexed));
+        (*schema) << new (mem) Variable(path, source_position, Util::normalize_underscores(lexed));
       }
       else {
         error("error parsing interpolated value");
@@ -1240,25 +1355,25 @@ namespace Sass {
 
   String_Schema* Parser::parse_url_schema()
   {
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (mem) String_Schema(path, source_position);
 
     while (position < end) {
       if (position[0] == '/') {
         lexed = Token(position, position+1);
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (mem) String_Constant(path, source_position, lexed);
         ++position;
       }
       else if (lex< interpolant >()) {
         Token insides(Token(lexed.begin + 2, lexed.end - 1));
-        Expression* interp_node = Parser::from_token(insides, ctx, path, source_position).parse_list();
+        Expression* interp_node = sub_parser(insides).parse_list();
         interp_node->is_interpolant(true);
         (*schema) << interp_node;
       }
       else if (lex< sequence< identifier, exactly<':'> > >()) {
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (mem) String_Constant(path, source_position, lexed);
       }
       else if (lex< filename >()) {
-        (*schema) << new (ctx.mem) String_Constant(path, source_position, lexed);
+        (*schema) << new (mem) String_Constant(path, source_position, lexed);
       }
       else {
         error("error parsing interpolated url");
@@ -1275,20 +1390,20 @@ namespace Sass {
     // see if there any interpolants
     const char* p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(id.begin, id.end);
     if (!p) {
-      return new (ctx.mem) String_Constant(path, source_position, id);
+      return new (mem) String_Constant(path, source_position, id);
     }
 
-    String_Schema* schema = new (ctx.mem) String_Schema(path, source_position);
+    String_Schema* schema = new (mem) String_Schema(path, source_position);
     while (i < id.end) {
       p = find_first_in_interval< sequence< negate< exactly<'\\'> >, exactly<hash_lbrace> > >(i, id.end);
       if (p) {
         if (i < p) {
-          (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
+          (*schema) << new (mem) String_Constant(path, source_position, Token(i, p)); // accumulate the preceding segment if it's nonempty
         }
         const char* j = find_first_in_interval< exactly<rbrace> >(p, id.end); // find the closing brace
         if (j) {
           // parse the interpolant and accumulate it
-          Expression* interp_node = Parser::from_token(Token(p+2, j), ctx, path, source_position).parse_list();
+          Expression* interp_node = sub_parser(Token(p+2, j)).parse_list();
           interp_node->is_interpolant(true);
           (*schema) << interp_node;
           i = j+1;
@@ -1299,7 +1414,7 @@ namespace Sass {
         }
       }
       else { // no interpolants left; add the last segment if nonempty
-        if (i < id.end) (*schema) << new (ctx.mem) String_Constant(path, source_position, Token(i, id.end));
+        if (i < id.end) (*schema) << new (mem) String_Constant(path, source_position, Token(i, id.end));
         break;
       }
     }
@@ -1318,10 +1433,10 @@ namespace Sass {
     const char* arg_end = position;
     lex< exactly<')'> >();
 
-    Argument* arg = new (ctx.mem) Argument(path, arg_pos, parse_interpolated_chunk(Token(arg_beg, arg_end)));
-    Arguments* args = new (ctx.mem) Arguments(path, arg_pos);
+    Argument* arg = new (mem) Argument(path, arg_pos, parse_interpolated_chunk(Token(arg_beg, arg_end)));
+    Arguments* args = new (mem) Arguments(path, arg_pos);
     *args << arg;
-    return new (ctx.mem) Function_Call(path, call_pos, name, args);
+    return new (mem) Function_Call(path, call_pos, name, args);
   }
 
   Function_Call* Parser::parse_function_call()
@@ -1330,7 +1445,7 @@ namespace Sass {
     string name(Util::normalize_underscores(lexed));
     Position source_position_of_call = source_position;
 
-    Function_Call* the_call = new (ctx.mem) Function_Call(path, source_position_of_call, name, parse_arguments());
+    Function_Call* the_call = new (mem) Function_Call(path, source_position_of_call, name, parse_arguments());
     return the_call;
   }
 
@@ -1339,7 +1454,7 @@ namespace Sass {
     String* name = parse_identifier_schema();
     Position source_position_of_call = source_position;
 
-    Function_Call_Schema* the_call = new (ctx.mem) Function_Call_Schema(path, source_position_of_call, name, parse_arguments());
+    Function_Call_Schema* the_call = new (mem) Function_Call_Schema(path, source_position_of_call, name, parse_arguments());
     return the_call;
   }
 
@@ -1354,7 +1469,7 @@ namespace Sass {
     Block* alternative = 0;
     if (lex< else_directive >()) {
       if (peek< exactly<if_after_else_kwd> >()) {
-        alternative = new (ctx.mem) Block(path, source_position);
+        alternative = new (mem) Block(path, source_position);
         (*alternative) << parse_if_directive(true);
       }
       else if (!peek< exactly<'{'> >()) {
@@ -1364,7 +1479,7 @@ namespace Sass {
         alternative = parse_block();
       }
     }
-    return new (ctx.mem) If(path, if_source_position, predicate, consequent, alternative);
+    return new (mem) If(path, if_source_position, predicate, consequent, alternative);
   }
 
   For* Parser::parse_for_directive()
@@ -1384,7 +1499,7 @@ namespace Sass {
     upper_bound->is_delayed(false);
     if (!peek< exactly<'{'> >()) error("expected '{' after the upper bound in @for directive");
     Block* body = parse_block();
-    return new (ctx.mem) For(path, for_source_position, var, lower_bound, upper_bound, body, inclusive);
+    return new (mem) For(path, for_source_position, var, lower_bound, upper_bound, body, inclusive);
   }
 
   Each* Parser::parse_each_directive()
@@ -1404,7 +1519,7 @@ namespace Sass {
     }
     if (!peek< exactly<'{'> >()) error("expected '{' after the upper bound in @each directive");
     Block* body = parse_block();
-    return new (ctx.mem) Each(path, each_source_position, var, list, body);
+    return new (mem) Each(path, each_source_position, var, list, body);
   }
 
   While* Parser::parse_while_directive()
@@ -1414,7 +1529,7 @@ namespace Sass {
     Expression* predicate = parse_list();
     predicate->is_delayed(false);
     Block* body = parse_block();
-    return new (ctx.mem) While(path, while_source_position, predicate, body);
+    return new (mem) While(path, while_source_position, predicate, body);
   }
 
   Media_Block* Parser::parse_media_block()
@@ -1429,12 +1544,12 @@ namespace Sass {
     }
     Block* block = parse_block();
 
-    return new (ctx.mem) Media_Block(path, media_source_position, media_queries, block);
+    return new (mem) Media_Block(path, media_source_position, media_queries, block);
   }
 
   List* Parser::parse_media_queries()
   {
-    List* media_queries = new (ctx.mem) List(path, source_position, 0, List::COMMA);
+    List* media_queries = new (mem) List(path, source_position, 0, List::COMMA);
     if (!peek< exactly<'{'> >()) (*media_queries) << parse_media_query();
     while (lex< exactly<','> >()) (*media_queries) << parse_media_query();
     return media_queries;
@@ -1443,13 +1558,13 @@ namespace Sass {
   // Expression* Parser::parse_media_query()
   Media_Query* Parser::parse_media_query()
   {
-    Media_Query* media_query = new (ctx.mem) Media_Query(path, source_position);
+    Media_Query* media_query = new (mem) Media_Query(path, source_position);
 
     if (lex< exactly< not_kwd > >()) media_query->is_negated(true);
     else if (lex< exactly< only_kwd > >()) media_query->is_restricted(true);
 
     if (peek< identifier_schema >()) media_query->media_type(parse_identifier_schema());
-    else if (lex< identifier >())    media_query->media_type(new (ctx.mem) String_Constant(path, source_position, lexed));
+    else if (lex< identifier >())    media_query->media_type(new (mem) String_Constant(path, source_position, lexed));
     else                             (*media_query) << parse_media_expression();
 
     while (lex< exactly< and_kwd > >()) (*media_query) << parse_media_expression();
@@ -1461,7 +1576,7 @@ namespace Sass {
   {
     if (peek< identifier_schema >()) {
       String* ss = parse_identifier_schema();
-      return new (ctx.mem) Media_Query_Expression(path, source_position, ss, 0, true);
+      return new (mem) Media_Query_Expression(path, source_position, ss, 0, true);
     }
     if (!lex< exactly<'('> >()) {
       error("media query expression must begin with '('");
@@ -1478,7 +1593,7 @@ namespace Sass {
     if (!lex< exactly<')'> >()) {
       error("unclosed parenthesis in media query expression");
     }
-    return new (ctx.mem) Media_Query_Expression(path, feature->position(), feature, expression);
+    return new (mem) Media_Query_Expression(path, feature->position(), feature, expression);
   }
 
   At_Rule* Parser::parse_at_rule()
@@ -1502,7 +1617,7 @@ namespace Sass {
     }
     Block* body = 0;
     if (peek< exactly<'{'> >()) body = parse_block();
-    At_Rule* rule = new (ctx.mem) At_Rule(path, at_source_position, kwd, sel, body);
+    At_Rule* rule = new (mem) At_Rule(path, at_source_position, kwd, sel, body);
     if (!sel) rule->value(val);
     return rule;
   }
@@ -1510,7 +1625,7 @@ namespace Sass {
   Warning* Parser::parse_warning()
   {
     lex< warn >();
-    return new (ctx.mem) Warning(path, source_position, parse_list());
+    return new (mem) Warning(path, source_position, parse_list());
   }
 
   Selector_Lookahead Parser::lookahead_for_selector(const char* start)
@@ -1697,7 +1812,7 @@ namespace Sass {
   Expression* Parser::fold_operands(Expression* base, vector<Expression*>& operands, Binary_Expression::Type op)
   {
     for (size_t i = 0, S = operands.size(); i < S; ++i) {
-      base = new (ctx.mem) Binary_Expression(path, source_position, op, base, operands[i]);
+      base = new (mem) Binary_Expression(path, source_position, op, base, operands[i]);
       Binary_Expression* b = static_cast<Binary_Expression*>(base);
       if (op == Binary_Expression::DIV && b->left()->is_delayed() && b->right()->is_delayed()) {
         base->is_delayed(true);
@@ -1713,7 +1828,7 @@ namespace Sass {
   Expression* Parser::fold_operands(Expression* base, vector<Expression*>& operands, vector<Binary_Expression::Type>& ops)
   {
     for (size_t i = 0, S = operands.size(); i < S; ++i) {
-      base = new (ctx.mem) Binary_Expression(path, base->position(), ops[i], base, operands[i]);
+      base = new (mem) Binary_Expression(path, base->position(), ops[i], base, operands[i]);
       Binary_Expression* b = static_cast<Binary_Expression*>(base);
       if (ops[i] == Binary_Expression::DIV && b->left()->is_delayed() && b->right()->is_delayed()) {
         base->is_delayed(true);
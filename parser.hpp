@@ -42,26 +42,49 @@ namespace Sass {
 
     enum Syntactic_Context { nothing, mixin_def, function_def };
 
+    // The directives statement parsing dispatches on.
+    enum Directive {
+      no_directive, at_unknown, at_import, at_mixin, at_function, at_return,
+      at_include, at_content, at_extend, at_if, at_for, at_each, at_while,
+      at_warn, at_media, at_charset
+    };
+
     Context& ctx;
+    Memory_Manager<Sass::AST_Node>& mem;
+    Context::Pending_Imports* pending;
+    vector<Import_Request>* import_log;
     vector<Syntactic_Context> stack;
     const char* source;
     const char* position;
     const char* end;
-    string path;
-    size_t column;
+    const char* path;
     Position source_position;
+    // where each line of the source begins, so that positions come from a
+    // lookup rather than from rescanning what was lexed
+    vector<const char*> line_starts;
+    size_t first_line;
+    size_t line_cursor;
 
 
     Token lexed;
 
-    Parser(Context& ctx, string path, Position source_position)
-    : ctx(ctx), stack(vector<Syntactic_Context>()),
-      source(0), position(0), end(0), path(path), column(1), source_position(source_position)
+    Parser(Context& ctx, const char* path, Position source_position,
+           Memory_Manager<Sass::AST_Node>* mem = 0, Context::Pending_Imports* pending = 0)
+    : ctx(ctx), mem(mem ? *mem : ctx.mem), pending(pending), import_log(0), stack(vector<Syntactic_Context>()),
+      source(0), position(0), end(0), path(path), source_position(source_position),
+      line_starts(), first_line(source_position.line), line_cursor(0)
     { stack.push_back(nothing); }
 
-    static Parser from_string(string src, Context& ctx, string path = "", Position source_position = Position());
-    static Parser from_c_str(const char* src, Context& ctx, string path = "", Position source_position = Position());
-    static Parser from_token(Token t, Context& ctx, string path = "", Position source_position = Position());
+    static Parser from_string(string src, Context& ctx, const char* path = "", Position source_position = Position());
+    static Parser from_c_str(const char* src, Context& ctx, const char* path = "", Position source_position = Position(),
+                             Memory_Manager<Sass::AST_Node>* mem = 0, Context::Pending_Imports* pending = 0);
+    static Parser from_token(Token t, Context& ctx, const char* path = "", Position source_position = Position());
+    Parser sub_parser(Token t);
+
+    void   index_lines();
+    size_t line_of(const char* p);
+
+    static Directive directive_at(const char* src);
 
 #ifdef __clang__
 
@@ -131,7 +154,7 @@ namespace Sass {
       else if (mx == spaces) {
         after_whitespace = spaces(position);
         if (after_whitespace) {
-          source_position.line += count_interval<'\n'>(position, after_whitespace);
+          source_position.line = first_line + line_of(after_whitespace);
           lexed = Token(position, after_whitespace);
           return position = after_whitespace;
         }
@@ -147,23 +170,10 @@ namespace Sass {
       }
       const char* after_token = mx(after_whitespace);
       if (after_token) {
-        size_t previous_line = source_position.line;
-        source_position.line += count_interval<'\n'>(position, after_token);
-
-        size_t whitespace = 0;
-        const char* ptr = after_whitespace - 1;
-        while (ptr >= position) {
-          if (*ptr == '\n')
-            break;
-          whitespace++;
-          ptr--;
-        }
-        if (previous_line != source_position.line) {
-          column = 1;
-        }
-
-        source_position.column = column + whitespace;
-        column += after_token - after_whitespace + whitespace;
+        // the column is where the token starts, but the line is where it
+        // ends, which only differs for tokens spanning lines
+        source_position.column = after_whitespace - line_starts[line_of(after_whitespace)] + 1;
+        source_position.line   = first_line + line_of(after_token);
         lexed = Token(after_whitespace, after_token);
 
         return position = after_token;
@@ -184,6 +194,8 @@ namespace Sass {
 
     Block* parse();
     Import* parse_import();
+    string import_file(string path);
+    string import_file(string dir, string rel_filepath);
     Definition* parse_definition();
     Parameters* parse_parameters();
     Parameter* parse_parameter();
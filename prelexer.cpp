@@ -1,6 +1,21 @@
 #include <cctype>
 #include <cstddef>
 #include <iostream>
+
+// The block scan below reads whole aligned blocks around the string, which
+// AddressSanitizer reports as out of bounds.
+#if defined(__SANITIZE_ADDRESS__)
+#define SASS_SCALAR_SCAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SASS_SCALAR_SCAN
+#endif
+#endif
+
+#if defined(__SSE2__) && !defined(SASS_SCALAR_SCAN)
+#include <emmintrin.h>
+#endif
+
 #include "constants.hpp"
 #include "prelexer.hpp"
 
@@ -22,15 +37,84 @@ namespace Sass {
     // Match any single character.
     const char* any_char(const char* src) { return *src ? src+1 : src; }
 
+    enum {
+      SP = SPACE_CHAR, AL = ALPHA_CHAR, DI = DIGIT_CHAR, XD = XDIGIT_CHAR,
+      PU = PUNCT_CHAR, SG = SIGN_CHAR, US = URL_SPACE_CHAR, ES = ESCAPE_CHAR
+    };
+
+    const unsigned char char_classes[256] = {
+      0, 0, 0, 0, 0, 0, 0, 0,
+      0, SP|US, SP|US, SP, SP|US, SP|US, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0,
+      SP|US|ES, PU, PU, PU, PU, PU, PU, PU,
+      PU, PU, PU, PU|SG, PU, PU|SG|ES, PU, PU,
+      DI|XD, DI|XD, DI|XD, DI|XD, DI|XD, DI|XD, DI|XD, DI|XD,
+      DI|XD, DI|XD, PU, PU, PU, PU, PU, PU,
+      PU, AL|XD, AL|XD, AL|XD, AL|XD, AL|XD, AL|XD, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, PU, PU, PU, PU, PU,
+      PU, AL|XD, AL|XD, AL|XD, AL|XD, AL|XD, AL|XD, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, PU, PU, PU, PU|ES, 0,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL,
+      AL, AL, AL, AL, AL, AL, AL, AL
+    };
+
+    // Returns the first `a`, `b` or terminating null at or after `src`.
+    static const char* find_either(const char* src, char a, char b)
+    {
+#if defined(__SSE2__) && !defined(SASS_SCALAR_SCAN)
+      // Aligned loads never reach into the next page, so scanning the whole
+      // block that holds the terminator is safe.
+      size_t skew = reinterpret_cast<size_t>(src) & 15;
+      const __m128i* block = reinterpret_cast<const __m128i*>(src - skew);
+      const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), nul = _mm_setzero_si128();
+      unsigned int wanted = 0xffffu << skew;
+      while (1) {
+        __m128i x = _mm_load_si128(block);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+                                   _mm_cmpeq_epi8(x, nul));
+        unsigned int hits = _mm_movemask_epi8(hit) & wanted;
+        if (hits) return reinterpret_cast<const char*>(block) + __builtin_ctz(hits);
+        ++block;
+        wanted = 0xffffu;
+      }
+#else
+      while (*src && *src != a && *src != b) ++src;
+      return src;
+#endif
+    }
+
     // Match a single character satisfying the ctype predicates.
-    const char* space(const char* src) { return std::isspace(*src) ? src+1 : 0; }
-    const char* alpha(const char* src) { return std::isalpha(*src) || !isascii(*src) ? src+1 : 0; }
-    const char* digit(const char* src) { return std::isdigit(*src) ? src+1 : 0; }
-    const char* xdigit(const char* src) { return std::isxdigit(*src) ? src+1 : 0; }
-    const char* alnum(const char* src) { return std::isalnum(*src) || !isascii(*src) ? src+1 : 0; }
-    const char* punct(const char* src) { return std::ispunct(*src) ? src+1 : 0; }
+    const char* space(const char* src) { return table_char<SPACE_CHAR>(src); }
+    const char* alpha(const char* src) { return table_char<ALPHA_CHAR>(src); }
+    const char* digit(const char* src) { return table_char<DIGIT_CHAR>(src); }
+    const char* xdigit(const char* src) { return table_char<XDIGIT_CHAR>(src); }
+    const char* alnum(const char* src) { return table_char<ALPHA_CHAR | DIGIT_CHAR>(src); }
+    const char* punct(const char* src) { return table_char<PUNCT_CHAR>(src); }
     // Match multiple ctype characters.
-    const char* spaces(const char* src) { return one_plus<space>(src); }
+    const char* spaces(const char* src) {
+      const char* p = src;
+      while (is_char_class(*p, SPACE_CHAR)) ++p;
+      return p == src ? 0 : p;
+    }
     const char* alphas(const char* src) { return one_plus<alpha>(src); }
     const char* digits(const char* src) { return one_plus<digit>(src); }
     const char* xdigits(const char* src) { return one_plus<xdigit>(src); }
@@ -38,14 +122,21 @@ namespace Sass {
     const char* puncts(const char* src) { return one_plus<punct>(src); }
 
     // Match a line comment.
-    const char* line_comment(const char* src) { return to_endl<slash_slash>(src); }
+    const char* line_comment(const char* src) {
+      if (!(src = exactly<slash_slash>(src))) return 0;
+      return find_either(src, '\n', '\n');
+    }
     // Match a line comment prefix.
     const char* line_comment_prefix(const char* src) { return exactly<slash_slash>(src); }
 
 
     // Match a block comment.
     const char* block_comment(const char* src) {
-      return sequence< optional_spaces, delimited_by<slash_star, star_slash, false> >(src);
+      if (!(src = sequence< optional_spaces, exactly<slash_star> >(src))) return 0;
+      while (*(src = find_either(src, '*', '*'))) {
+        if (*++src == '/') return src + 1;
+      }
+      return 0;
     }
     const char* block_comment_prefix(const char* src) {
       return exactly<slash_star>(src);
@@ -86,38 +177,18 @@ namespace Sass {
     const char* double_quoted_string(const char* src) {
       src = exactly<'"'>(src);
       if (!src) return 0;
-      const char* p;
-      while (1) {
-        if (!*src) return 0;
-        if((p = escape(src))) {
-          src = p;
-          continue;
-        } 
-        else if((p = exactly<'"'>(src))) {
-          return p;
-        }
-        else {
-          ++src;
-        }
+      while (*(src = find_either(src, '"', '\\'))) {
+        if (*src == '"') return src + 1;
+        src = escape(src);
       }
       return 0;
     }
     const char* single_quoted_string(const char* src) {
       src = exactly<'\''>(src);
       if (!src) return 0;
-      const char* p;
-      while (1) {
-        if (!*src) return 0;
-        if((p = escape(src))) {
-          src = p;
-          continue;
-        } 
-        else if((p = exactly<'\''>(src))) {
-          return p;
-        }
-        else {
-          ++src;
-        }
+      while (*(src = find_either(src, '\'', '\\'))) {
+        if (*src == '\'') return src + 1;
+        src = escape(src);
       }
       return 0;
     }
@@ -134,8 +205,15 @@ namespace Sass {
     // Whitespace handling.
     const char* optional_spaces(const char* src) { return optional<spaces>(src); }
     const char* optional_comment(const char* src) { return optional<comment>(src); }
+    // This runs ahead of nearly every token, so the usual case of nothing
+    // to skip gets out after a table lookup.
     const char* spaces_and_comments(const char* src) {
-      return zero_plus< alternatives<spaces, comment> >(src);
+      const char* p;
+      while (1) {
+        while (is_char_class(*src, SPACE_CHAR)) ++src;
+        if (*src != '/' || !(p = comment(src))) return src;
+        src = p;
+      }
     }
     const char* no_spaces(const char* src) {
       return negate< spaces >(src);
@@ -332,7 +410,7 @@ namespace Sass {
     // Match CSS numeric constants.
 
     const char* sign(const char* src) {
-      return class_char<sign_chars>(src);
+      return table_char<SIGN_CHAR>(src);
     }
     const char* unsigned_number(const char* src) {
       return alternatives<sequence< zero_plus<digits>,
@@ -562,17 +640,17 @@ namespace Sass {
     }
 
     const char* H(const char* src) {
-      return std::isxdigit(*src) ? src+1 : 0;
+      return table_char<XDIGIT_CHAR>(src);
     }
 
     const char* unicode(const char* src) {
       return sequence< exactly<'\\'>,
                        between<H, 1, 6>,
-                       optional< class_char<url_space_chars> > >(src);
+                       optional< table_char<URL_SPACE_CHAR> > >(src);
     }
 
     const char* ESCAPE(const char* src) {
-      return alternatives< unicode, class_char<escape_chars> >(src);
+      return alternatives< unicode, table_char<ESCAPE_CHAR> >(src);
     }
 
     const char* url(const char* src) {
@@ -6,6 +6,29 @@ namespace Sass {
     typedef int (*ctype_predicate)(int);
     typedef const char* (*prelexer)(const char*);
 
+    // Character classes, looked up in a table instead of through <cctype>,
+    // which costs a call per byte and answers according to the locale.
+    enum Char_Class {
+      SPACE_CHAR     = 1,   // isspace in the C locale
+      ALPHA_CHAR     = 2,   // isalpha in the C locale, or not ASCII at all
+      DIGIT_CHAR     = 4,
+      XDIGIT_CHAR    = 8,
+      PUNCT_CHAR     = 16,
+      SIGN_CHAR      = 32,  // Constants::sign_chars
+      URL_SPACE_CHAR = 64,  // Constants::url_space_chars
+      ESCAPE_CHAR    = 128  // Constants::escape_chars
+    };
+    extern const unsigned char char_classes[256];
+
+    inline bool is_char_class(char c, unsigned char classes)
+    { return char_classes[static_cast<unsigned char>(c)] & classes; }
+
+    // Match a single character from any of the supplied table classes.
+    template <unsigned char classes>
+    const char* table_char(const char* src) {
+      return is_char_class(*src, classes) ? src + 1 : 0;
+    }
+
     // Match a single character literal.
     template <char pre>
     const char* exactly(const char* src) {
@@ -0,0 +1,208 @@
+#ifdef _WIN32
+#include <ctime>
+#else
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+
+#ifndef SASS_PROFILER
+#include "profiler.hpp"
+#endif
+
+#ifndef SASS_AST
+#include "ast.hpp"
+#endif
+
+namespace Sass {
+  using std::stringstream;
+
+  static double now()
+  {
+#if defined(_WIN32)
+    return double(clock()) / CLOCKS_PER_SEC;
+#elif defined(CLOCK_MONOTONIC)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+#endif
+  }
+
+  static string json_string(const string& s)
+  {
+    string quoted("\"");
+    for (size_t i = 0, L = s.length(); i < L; ++i) {
+      unsigned char c = s[i];
+      if (c == '"' || c == '\\') {
+        quoted += '\\';
+        quoted += c;
+      }
+      else if (c < 0x20) {
+        char escape[8];
+        sprintf(escape, "\\u%04x", c);
+        quoted += escape;
+      }
+      else quoted += c;
+    }
+    return quoted + "\"";
+  }
+
+  Profiler::Profiler()
+  : sites(vector<Site>()), site_ids(map<string, size_t>()), known(map<const Definition*, size_t>()),
+    stacks(vector<Stack>(1)), calls(vector<Call>())
+  {
+    stacks[0].site = 0;
+    stacks[0].parent = 0;
+    stacks[0].seconds = 0;
+  }
+
+  void Profiler::start_compile()
+  {
+    // definitions don't outlive their compile, so their addresses get reused
+    known.clear();
+    calls.clear();
+  }
+
+  size_t Profiler::site_of(const Definition* def)
+  {
+    map<const Definition*, size_t>::iterator k = known.find(def);
+    if (k != known.end()) return k->second;
+
+    Site site;
+    site.name = def->name();
+    site.kind = def->type() == Definition::MIXIN ? "mixin" : "function";
+    site.path = def->path();
+    site.line = def->position().line;
+    stringstream key;
+    key << site.kind << ' ' << site.name << ' ' << site.path << ':' << site.line;
+    map<string, size_t>::iterator s = site_ids.find(key.str());
+    size_t id;
+    if (s != site_ids.end()) {
+      id = s->second;
+    }
+    else {
+      site.calls = site.inclusive_nodes = site.exclusive_nodes = 0;
+      site.inclusive_seconds = site.exclusive_seconds = 0;
+      id = sites.size();
+      sites.push_back(site);
+      site_ids[key.str()] = id;
+    }
+    known[def] = id;
+    return id;
+  }
+
+  void Profiler::enter(const Definition* def, size_t nodes_so_far)
+  {
+    size_t site = site_of(def);
+    size_t parent = calls.empty() ? 0 : calls.back().stack;
+    map<size_t, size_t>::iterator child = stacks[parent].children.find(site);
+    size_t stack;
+    if (child != stacks[parent].children.end()) {
+      stack = child->second;
+    }
+    else {
+      stack = stacks.size();
+      stacks.push_back(Stack());
+      stacks[stack].site = site;
+      stacks[stack].parent = parent;
+      stacks[stack].seconds = 0;
+      stacks[parent].children[site] = stack;
+    }
+    Call call;
+    call.stack = stack;
+    call.child_seconds = 0;
+    call.nodes_at_entry = nodes_so_far;
+    call.child_nodes = 0;
+    call.started = now();
+    calls.push_back(call);
+  }
+
+  void Profiler::leave(size_t nodes_so_far)
+  {
+    if (calls.empty()) return;
+    Call call = calls.back();
+    calls.pop_back();
+    double seconds = now() - call.started;
+    size_t nodes = nodes_so_far - call.nodes_at_entry;
+
+    Stack& stack = stacks[call.stack];
+    Site& site = sites[stack.site];
+    ++site.calls;
+    stack.seconds += seconds - call.child_seconds;
+    site.exclusive_seconds += seconds - call.child_seconds;
+    site.exclusive_nodes += nodes - call.child_nodes;
+    // recursive calls are already inside the outermost one's totals
+    bool recursive = false;
+    for (size_t i = 0, S = calls.size(); i < S && !recursive; ++i) {
+      recursive = stacks[calls[i].stack].site == stack.site;
+    }
+    if (!recursive) {
+      site.inclusive_seconds += seconds;
+      site.inclusive_nodes += nodes;
+    }
+    if (!calls.empty()) {
+      calls.back().child_seconds += seconds;
+      calls.back().child_nodes += nodes;
+    }
+  }
+
+  string Profiler::collapsed_stacks() const
+  {
+    stringstream out;
+    for (size_t i = 1, S = stacks.size(); i < S; ++i) {
+      long micros = long(stacks[i].seconds * 1e6 + 0.5);
+      if (micros <= 0) continue;
+      vector<size_t> path;
+      for (size_t s = i; s; s = stacks[s].parent) path.push_back(stacks[s].site);
+      for (size_t j = path.size(); j--; ) {
+        const Site& site = sites[path[j]];
+        // ';' separates the frames; the count is after the last space
+        string frame(site.name + " (" + site.path);
+        replace(frame.begin(), frame.end(), ';', ',');
+        out << frame << ':' << site.line << ')' << (j ? ";" : " ");
+      }
+      out << micros << '\n';
+    }
+    return out.str();
+  }
+
+  struct Exclusive_Time_Greater {
+    bool operator()(const pair<double, size_t>& a, const pair<double, size_t>& b) const
+    { return a.first > b.first || (a.first == b.first && a.second < b.second); }
+  };
+
+  string Profiler::json() const
+  {
+    vector<pair<double, size_t> > order;
+    for (size_t i = 0, S = sites.size(); i < S; ++i) order.push_back(make_pair(sites[i].exclusive_seconds, i));
+    sort(order.begin(), order.end(), Exclusive_Time_Greater());
+
+    stringstream out;
+    out.precision(9);
+    out << "[";
+    for (size_t i = 0, S = order.size(); i < S; ++i) {
+      const Site& site = sites[order[i].second];
+      out << (i ? ",\n " : "\n ")
+          << "{\"kind\": " << json_string(site.kind)
+          << ", \"name\": " << json_string(site.name)
+          << ", \"path\": " << json_string(site.path)
+          << ", \"line\": " << site.line
+          << ", \"calls\": " << site.calls
+          << ", \"inclusive_seconds\": " << site.inclusive_seconds
+          << ", \"exclusive_seconds\": " << site.exclusive_seconds
+          << ", \"inclusive_nodes\": " << site.inclusive_nodes
+          << ", \"exclusive_nodes\": " << site.exclusive_nodes
+          << "}";
+    }
+    out << (order.empty() ? "]\n" : "\n]\n");
+    return out.str();
+  }
+
+}
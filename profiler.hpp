@@ -0,0 +1,72 @@
+#define SASS_PROFILER
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Sass {
+  using std::string;
+  using std::vector;
+  using std::map;
+
+  class Definition;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Time and nodes spent in each mixin and function definition, keyed on
+  // where it was defined. Expand and Eval report each call as they push and
+  // pop its backtrace; a profiler can be handed to one compile after another
+  // and adds them all up, but must not be used by two at once. Nodes are the
+  // ones allocated in the compile's memory manager while the call ran.
+  /////////////////////////////////////////////////////////////////////////////
+  class Profiler {
+  public:
+    Profiler();
+
+    // forgets the calls left open by a compile that failed
+    void start_compile();
+    void enter(const Definition* def, size_t nodes_so_far);
+    void leave(size_t nodes_so_far);
+
+    // one line per distinct call stack, "outer;inner microseconds", the
+    // input format of flamegraph.pl
+    string collapsed_stacks() const;
+    // the definitions, most exclusive time first
+    string json() const;
+
+  private:
+    struct Site {
+      string name;
+      string kind;
+      string path;
+      size_t line;
+      size_t calls;
+      double inclusive_seconds;
+      double exclusive_seconds;
+      size_t inclusive_nodes;
+      size_t exclusive_nodes;
+    };
+    // a distinct call stack, as a node of the tree of them all
+    struct Stack {
+      size_t              site;
+      size_t              parent;
+      map<size_t, size_t> children; // site -> stack
+      double              seconds;  // spent in this site itself
+    };
+    struct Call {
+      size_t stack;
+      double started;
+      double child_seconds;
+      size_t nodes_at_entry;
+      size_t child_nodes;
+    };
+
+    size_t site_of(const Definition* def);
+
+    vector<Site>                  sites;
+    map<string, size_t>           site_ids;   // "kind name path:line" -> site
+    map<const Definition*, size_t> known;     // the current compile's definitions
+    vector<Stack>                 stacks;     // stacks[0] is the root
+    vector<Call>                  calls;
+  };
+
+}
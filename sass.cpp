@@ -59,6 +59,13 @@ extern "C" {
                          .include_paths_array (/*c_ctx->include_paths_array*/0)
                          .include_paths       (vector<string>())
                          .precision           (c_ctx->precision ? c_ctx->precision : 5)
+                         .parse_threads       (c_ctx->parse_threads > 0 ? c_ctx->parse_threads : 0)
+                         .parse_cache         (0)
+                         .import_cache        (0)
+                         .stats               (0)
+                         .profiler            (0)
+                         .memoize_functions   (false)
+                         .use_bytecode        (false)
         );
         if (src_option == FILE_SOURCE) cpp_ctx.compile_file();
         else                           cpp_ctx.compile_string();
@@ -28,6 +28,7 @@ struct Sass_Context {
   const char*  include_paths_string;
   const char** include_paths_array;
   int          precision;
+  int          parse_threads;
 };
 
 struct Sass_Context* make_sass_context   ();
@@ -1,11 +1,24 @@
 #ifdef _WIN32
 #include <io.h>
+#include <direct.h>
+#define getcwd _getcwd
 #else
 #include <unistd.h>
 #endif
 
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define SASS_PARALLEL_FOLDERS
+#include <pthread.h>
+#endif
+
 #include "sass_interface.h"
 #include "context.hpp"
+#include "file.hpp"
+#include "emitter.hpp"
+
+#ifndef SASS_DEPENDENCY_GRAPH
+#include "dependency_graph.hpp"
+#endif
 
 #ifndef SASS_ERROR_HANDLING
 #include "error_handling.hpp"
@@ -14,10 +27,35 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <cerrno>
 #include <iostream>
 
+struct sass_parse_cache {
+  Sass::Parse_Cache cache;
+};
+
+struct sass_import_cache {
+  Sass::Import_Cache cache;
+};
+
+struct sass_profiler {
+  Sass::Profiler profiler;
+};
+
+struct sass_project {
+  Sass::Dependency_Graph   graph;
+  std::vector<std::string> output_paths;
+  sass_parse_cache         parse_cache;
+  sass_import_cache        import_cache;
+
+  sass_project(const std::string& cwd)
+  : graph(Sass::Dependency_Graph(cwd)), output_paths(std::vector<std::string>())
+  { }
+};
+
 extern "C" {
   using namespace std;
 
@@ -65,10 +103,54 @@ extern "C" {
 
   void sass_free_folder_context(sass_folder_context* ctx)
   {
+    if (ctx->error_message) free(ctx->error_message);
+
     free_string_array(ctx->included_files, ctx->num_included_files);
     free(ctx);
   }
 
+  sass_parse_cache* sass_new_parse_cache()
+  { return new sass_parse_cache; }
+
+  void sass_free_parse_cache(sass_parse_cache* cache)
+  { delete cache; }
+
+  size_t sass_parse_cache_hits(sass_parse_cache* cache)
+  { return cache->cache.hits(); }
+
+  size_t sass_parse_cache_misses(sass_parse_cache* cache)
+  { return cache->cache.misses(); }
+
+  sass_import_cache* sass_new_import_cache()
+  { return new sass_import_cache; }
+
+  void sass_free_import_cache(sass_import_cache* cache)
+  { delete cache; }
+
+  size_t sass_import_cache_hits(sass_import_cache* cache)
+  { return cache->cache.hits(); }
+
+  size_t sass_import_cache_listings(sass_import_cache* cache)
+  { return cache->cache.listings(); }
+
+  sass_profiler* sass_new_profiler()
+  { return new sass_profiler; }
+
+  void sass_free_profiler(sass_profiler* profiler)
+  { delete profiler; }
+
+  char* sass_profiler_collapsed_stacks(sass_profiler* profiler)
+  { return strdup(profiler->profiler.collapsed_stacks().c_str()); }
+
+  char* sass_profiler_json(sass_profiler* profiler)
+  { return strdup(profiler->profiler.json().c_str()); }
+
+  size_t sass_source_bytes_mapped()
+  { return Sass::File::bytes_mapped(); }
+
+  size_t sass_source_bytes_copied()
+  { return Sass::File::bytes_copied(); }
+
   void copy_strings(const std::vector<std::string>& strings, char*** array, int* n) {
     int num = strings.size();
     char** arr = (char**) malloc(sizeof(char*)* num);
@@ -83,6 +165,25 @@ extern "C" {
     *n = num;
   }
 
+  static void copy_stats(const Sass::Compile_Stats& stats, sass_compile_stats* c_stats)
+  {
+    for (int i = 0; i < SASS_NUM_PHASES; ++i) {
+      c_stats->wall_seconds[i] = stats.wall_seconds[i];
+      c_stats->cpu_seconds[i]  = stats.cpu_seconds[i];
+    }
+    c_stats->nodes          = stats.nodes;
+    c_stats->node_bytes     = stats.node_bytes;
+    c_stats->bytes_read     = stats.bytes_read;
+    c_stats->files          = stats.files;
+    c_stats->function_calls = stats.function_calls;
+    c_stats->mixin_calls    = stats.mixin_calls;
+    c_stats->memo_hits      = stats.memo_hits;
+    c_stats->memo_misses    = stats.memo_misses;
+    c_stats->bytecode_calls = stats.bytecode_calls;
+    c_stats->extensions     = stats.extensions;
+    c_stats->extend_keys    = stats.extend_keys;
+  }
+
   int sass_compile(sass_context* c_ctx)
   {
     using namespace Sass;
@@ -104,6 +205,7 @@ extern "C" {
       else {
           output_path = c_ctx->output_path;
       }
+      Compile_Stats stats;
       Context cpp_ctx(
         Context::Data().source_c_str(c_ctx->source_string)
                        .entry_point(input_path)
@@ -120,6 +222,13 @@ extern "C" {
                        .include_paths_array(0)
                        .include_paths(vector<string>())
                        .precision(c_ctx->options.precision ? c_ctx->options.precision : 5)
+                       .parse_threads(c_ctx->options.parse_threads > 0 ? c_ctx->options.parse_threads : 0)
+                       .parse_cache(c_ctx->options.parse_cache ? &c_ctx->options.parse_cache->cache : 0)
+                       .import_cache(c_ctx->options.import_cache ? &c_ctx->options.import_cache->cache : 0)
+                       .stats(c_ctx->stats ? &stats : 0)
+                       .profiler(c_ctx->profiler ? &c_ctx->profiler->profiler : 0)
+                       .memoize_functions(c_ctx->options.memoize_functions != 0)
+                       .use_bytecode(c_ctx->options.use_bytecode != 0)
       );
       
       if (c_ctx->c_functions) {
@@ -141,6 +250,8 @@ extern "C" {
       c_ctx->error_status = 0;
 
       copy_strings(cpp_ctx.get_included_files(), &c_ctx->included_files, &c_ctx->num_included_files);
+      c_ctx->num_fs_calls = cpp_ctx.fs_calls;
+      if (c_ctx->stats) copy_stats(stats, c_ctx->stats);
     }
     catch (Error& e) {
       stringstream msg_stream;
@@ -162,7 +273,9 @@ extern "C" {
     return 0;
   }
 
-  int sass_compile_file(sass_file_context* c_ctx)
+  // Compiles into `output` when one is given, and into c_ctx->output_string
+  // otherwise.
+  static int compile_file_context(sass_file_context* c_ctx, Sass::Emitter* output)
   {
     using namespace Sass;
     try {
@@ -181,6 +294,7 @@ extern "C" {
       else {
           output_path = c_ctx->output_path;
       }
+      Compile_Stats stats;
       Context cpp_ctx(
         Context::Data().entry_point(input_path)
                        .output_path(output_path)
@@ -196,6 +310,13 @@ extern "C" {
                        .include_paths_array(0)
                        .include_paths(vector<string>())
                        .precision(c_ctx->options.precision ? c_ctx->options.precision : 5)
+                       .parse_threads(c_ctx->options.parse_threads > 0 ? c_ctx->options.parse_threads : 0)
+                       .parse_cache(c_ctx->options.parse_cache ? &c_ctx->options.parse_cache->cache : 0)
+                       .import_cache(c_ctx->options.import_cache ? &c_ctx->options.import_cache->cache : 0)
+                       .stats(c_ctx->stats ? &stats : 0)
+                       .profiler(c_ctx->profiler ? &c_ctx->profiler->profiler : 0)
+                       .memoize_functions(c_ctx->options.memoize_functions != 0)
+                       .use_bytecode(c_ctx->options.use_bytecode != 0)
       );
       if (c_ctx->c_functions) {
         for(int i = 0; i < c_ctx->num_c_functions; i++) {
@@ -208,12 +329,20 @@ extern "C" {
           cpp_ctx.c_functions.push_back(*descr);
         }
       }
-      c_ctx->output_string = cpp_ctx.compile_file();
+      if (output) {
+        cpp_ctx.compile_file(*output);
+        c_ctx->output_string = 0;
+      }
+      else {
+        c_ctx->output_string = cpp_ctx.compile_file();
+      }
       c_ctx->source_map_string = cpp_ctx.generate_source_map();
       c_ctx->error_message = 0;
       c_ctx->error_status = 0;
 
       copy_strings(cpp_ctx.get_included_files(), &c_ctx->included_files, &c_ctx->num_included_files);
+      c_ctx->num_fs_calls = cpp_ctx.fs_calls;
+      if (c_ctx->stats) copy_stats(stats, c_ctx->stats);
     }
     catch (Error& e) {
       stringstream msg_stream;
@@ -244,9 +373,257 @@ extern "C" {
     return 0;
   }
 
+  int sass_compile_file(sass_file_context* c_ctx)
+  { return compile_file_context(c_ctx, 0); }
+
+  int sass_compile_file_to_writer(sass_file_context* c_ctx, sass_output_writer writer, void* cookie)
+  {
+    Sass::Emitter output(writer, cookie, c_ctx->output_path ? c_ctx->output_path : "");
+    return compile_file_context(c_ctx, &output);
+  }
+
+  static size_t write_to_fd(const char* data, size_t length, void* cookie)
+  {
+    int fd = *static_cast<int*>(cookie);
+    size_t written = 0;
+    while (written < length) {
+      int n = write(fd, data + written, length - written);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break;
+      written += n;
+    }
+    return written;
+  }
+
+  int sass_compile_file_to_fd(sass_file_context* c_ctx, int fd)
+  { return sass_compile_file_to_writer(c_ctx, write_to_fd, &fd); }
+
+  // An entry point found by sass_compile_folder, and what became of it.
+  struct Folder_Entry {
+    string         input_path;
+    string         output_path;
+    string         error;
+    vector<string> included_files;
+    size_t         fs_calls;
+  };
+
+  struct Folder_Batch {
+    sass_folder_context* c_ctx;
+    sass_parse_cache*    parse_cache;
+    sass_import_cache*   import_cache;
+    vector<Folder_Entry> entries;
+    size_t               next;
+#ifdef SASS_PARALLEL_FOLDERS
+    pthread_mutex_t      next_lock;
+#endif
+  };
+
+  struct Folder_Worker {
+    Folder_Batch*     batch;
+#ifdef SASS_PARALLEL_FOLDERS
+    pthread_t         thread;
+    bool              started;
+#endif
+  };
+
+  static void compile_entry_point(const sass_options& options, Sass_C_Function_Descriptor* c_functions, int num_c_functions,
+                                  Folder_Entry& entry, sass_parse_cache* cache, sass_import_cache* import_cache)
+  {
+    using namespace Sass::File;
+    sass_file_context* f_ctx = sass_new_file_context();
+    f_ctx->input_path            = entry.input_path.c_str();
+    f_ctx->output_path           = entry.output_path.c_str();
+    f_ctx->options               = options;
+    f_ctx->options.parse_cache   = cache;
+    f_ctx->options.import_cache  = import_cache;
+    f_ctx->c_functions           = c_functions;
+    f_ctx->num_c_functions       = num_c_functions;
+    sass_compile_file(f_ctx);
+    if (f_ctx->error_status) {
+      entry.error = f_ctx->error_message ? f_ctx->error_message : entry.input_path + ": error: compilation failed\n";
+    }
+    else if (!make_directories(dir_name(entry.output_path)) || !write_file(entry.output_path, f_ctx->output_string)) {
+      entry.error = entry.output_path + ": error: could not write output\n";
+    }
+    for (int i = 0; i < f_ctx->num_included_files; ++i) {
+      entry.included_files.push_back(f_ctx->included_files[i]);
+    }
+    entry.fs_calls = f_ctx->num_fs_calls;
+    sass_free_file_context(f_ctx);
+  }
+
+  static void* run_folder_worker(void* arg)
+  {
+    Folder_Worker* worker = static_cast<Folder_Worker*>(arg);
+    Folder_Batch& batch = *worker->batch;
+    while (true) {
+#ifdef SASS_PARALLEL_FOLDERS
+      pthread_mutex_lock(&batch.next_lock);
+#endif
+      size_t i = batch.next++;
+#ifdef SASS_PARALLEL_FOLDERS
+      pthread_mutex_unlock(&batch.next_lock);
+#endif
+      if (i >= batch.entries.size()) break;
+      compile_entry_point(batch.c_ctx->options, batch.c_ctx->c_functions, batch.c_ctx->num_c_functions,
+                          batch.entries[i], batch.parse_cache, batch.import_cache);
+    }
+    return 0;
+  }
+
+  // Compiles every non-partial style sheet below search_path into the same
+  // relative location under output_path (or next to the source if there is
+  // none). Entry points are handed out to compile_threads workers, which
+  // share a parse cache and an import cache, so a partial is parsed and an
+  // import resolved once for the whole folder. A failing file doesn't stop
+  // the others: all errors are reported together, in file order, through
+  // error_message.
   int sass_compile_folder(sass_folder_context* c_ctx)
   {
-    return 1;
+    using namespace Sass::File;
+    string search_path(c_ctx->search_path ? c_ctx->search_path : "");
+    string output_path(c_ctx->output_path ? c_ctx->output_path : search_path);
+
+    vector<string> found;
+    find_style_sheets(search_path, found);
+
+    Folder_Batch batch;
+    batch.c_ctx = c_ctx;
+    batch.parse_cache = c_ctx->options.parse_cache ? c_ctx->options.parse_cache : sass_new_parse_cache();
+    batch.import_cache = c_ctx->options.import_cache ? c_ctx->options.import_cache : sass_new_import_cache();
+    batch.next = 0;
+    for (size_t i = 0, S = found.size(); i < S; ++i) {
+      Folder_Entry entry;
+      entry.fs_calls    = 0;
+      entry.input_path  = join_paths(search_path, found[i]);
+      entry.output_path = join_paths(output_path, found[i].substr(0, found[i].length() - 5) + ".css");
+      batch.entries.push_back(entry);
+    }
+
+    size_t threads = c_ctx->options.compile_threads > 1 ? c_ctx->options.compile_threads : 1;
+    vector<Folder_Worker> workers(max<size_t>(1, min(threads, batch.entries.size())));
+    for (size_t w = 0, W = workers.size(); w < W; ++w) {
+      workers[w].batch = &batch;
+    }
+#ifdef SASS_PARALLEL_FOLDERS
+    pthread_mutex_init(&batch.next_lock, 0);
+    for (size_t w = 1, W = workers.size(); w < W; ++w) {
+      workers[w].started = !pthread_create(&workers[w].thread, 0, run_folder_worker, &workers[w]);
+    }
+#endif
+    run_folder_worker(&workers[0]);
+#ifdef SASS_PARALLEL_FOLDERS
+    for (size_t w = 1, W = workers.size(); w < W; ++w) {
+      if (workers[w].started) pthread_join(workers[w].thread, 0);
+    }
+    pthread_mutex_destroy(&batch.next_lock);
+#endif
+    if (batch.parse_cache != c_ctx->options.parse_cache) sass_free_parse_cache(batch.parse_cache);
+    if (batch.import_cache != c_ctx->options.import_cache) sass_free_import_cache(batch.import_cache);
+
+    string errors;
+    vector<string> included_files;
+    c_ctx->num_fs_calls = 0;
+    for (size_t i = 0, S = batch.entries.size(); i < S; ++i) {
+      errors += batch.entries[i].error;
+      c_ctx->num_fs_calls += batch.entries[i].fs_calls;
+      included_files.insert(included_files.end(), batch.entries[i].included_files.begin(), batch.entries[i].included_files.end());
+    }
+    if (found.empty()) errors = "no style sheets found in \"" + search_path + "\"\n";
+    sort(included_files.begin(), included_files.end());
+    included_files.erase(unique(included_files.begin(), included_files.end()), included_files.end());
+    copy_strings(included_files, &c_ctx->included_files, &c_ctx->num_included_files);
+
+    c_ctx->error_status = errors.empty() ? 0 : 1;
+    c_ctx->error_message = errors.empty() ? 0 : strdup(errors.c_str());
+    return 0;
+  }
+
+  sass_project_context* sass_new_project_context()
+  { return (sass_project_context*) calloc(1, sizeof(sass_project_context)); }
+
+  void sass_free_project_context(sass_project_context* ctx)
+  {
+    if (ctx->error_message) free(ctx->error_message);
+
+    free_string_array(ctx->compiled_files, ctx->num_compiled_files);
+    free_string_array(ctx->dependents, ctx->num_dependents);
+    delete ctx->project;
+    free(ctx);
+  }
+
+  static sass_project& project_of(sass_project_context* ctx)
+  {
+    if (!ctx->project) {
+      const size_t wd_len = 1024;
+      char wd[wd_len];
+      ctx->project = new sass_project(getcwd(wd, wd_len) ? wd : "");
+    }
+    return *ctx->project;
+  }
+
+  int sass_project_add_entry(sass_project_context* ctx, const char* input_path, const char* output_path)
+  {
+    sass_project& project = project_of(ctx);
+    string input(input_path);
+    size_t dot = input.find_last_of(".");
+    project.output_paths.push_back(output_path ? output_path : (dot != string::npos ? input.substr(0, dot) : input) + ".css");
+    return project.graph.add_entry(input);
+  }
+
+  int sass_project_changed(sass_project_context* ctx, const char* path)
+  {
+    sass_project& project = project_of(ctx);
+    if (path) return project.graph.changed(path);
+    size_t fresh = 0;
+    for (size_t i = 0, S = project.graph.size(); i < S; ++i) fresh += !project.graph.stale(i);
+    project.graph.changed_all();
+    return fresh;
+  }
+
+  int sass_project_dependents(sass_project_context* ctx, const char* path)
+  {
+    sass_project& project = project_of(ctx);
+    vector<size_t> entries(project.graph.dependents(path));
+    vector<string> outputs;
+    for (size_t i = 0, S = entries.size(); i < S; ++i) outputs.push_back(project.output_paths[entries[i]]);
+    free_string_array(ctx->dependents, ctx->num_dependents);
+    copy_strings(outputs, &ctx->dependents, &ctx->num_dependents);
+    return ctx->num_dependents;
+  }
+
+  // Compiles the stale entry points one after the other, all through the
+  // project's caches: unchanged files keep the trees parsed for an earlier
+  // compile. What each compile imported, or that it failed, becomes the
+  // entry point's part of the dependency graph.
+  int sass_compile_project(sass_project_context* c_ctx)
+  {
+    sass_project& project = project_of(c_ctx);
+    sass_import_cache* import_cache = c_ctx->options.import_cache ? c_ctx->options.import_cache : &project.import_cache;
+    string errors;
+    vector<string> compiled;
+    c_ctx->num_fs_calls = 0;
+    for (size_t i = 0, S = project.graph.size(); i < S; ++i) {
+      if (!project.graph.stale(i)) continue;
+      Folder_Entry entry;
+      entry.fs_calls    = 0;
+      entry.input_path  = project.graph.input_path(i);
+      entry.output_path = project.output_paths[i];
+      compile_entry_point(c_ctx->options, c_ctx->c_functions, c_ctx->num_c_functions,
+                          entry, &project.parse_cache, import_cache);
+      project.graph.record(i, entry.included_files, !entry.error.empty());
+      errors += entry.error;
+      c_ctx->num_fs_calls += entry.fs_calls;
+      if (entry.error.empty()) compiled.push_back(entry.output_path);
+    }
+    project.parse_cache.cache.collect();
+
+    free_string_array(c_ctx->compiled_files, c_ctx->num_compiled_files);
+    copy_strings(compiled, &c_ctx->compiled_files, &c_ctx->num_compiled_files);
+    if (c_ctx->error_message) free(c_ctx->error_message);
+    c_ctx->error_status = errors.empty() ? 0 : 1;
+    c_ctx->error_message = errors.empty() ? 0 : strdup(errors.c_str());
+    return 0;
   }
 
 }
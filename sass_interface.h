@@ -17,12 +17,57 @@ extern "C" {
 #define SASS_SOURCE_COMMENTS_DEFAULT 1
 #define SASS_SOURCE_COMMENTS_MAP 2
 
+#define SASS_PHASE_PARSE     0
+#define SASS_PHASE_FUNCTIONS 1
+#define SASS_PHASE_EXPAND    2
+#define SASS_PHASE_EXTEND    3
+#define SASS_PHASE_OUTPUT    4
+#define SASS_NUM_PHASES      5
+
+// parsed style sheets shared between compiles; see sass_new_parse_cache
+struct sass_parse_cache;
+// directory listings shared between compiles; see sass_new_import_cache
+struct sass_import_cache;
+// entry points with their dependencies and parsed files; see sass_compile_project
+struct sass_project;
+// time and nodes per mixin and function; see sass_new_profiler
+struct sass_profiler;
+
+// Receives compiled CSS piece by piece. Returns the number of bytes it took;
+// anything short of `length` aborts the compile with a write error.
+typedef size_t (*sass_output_writer)(const char* data, size_t length, void* cookie);
+
 struct sass_options {
   int output_style;
   int source_comments; // really want a bool, but C doesn't have them
   const char* include_paths;
   const char* image_path;
   int precision;
+  int parse_threads; // parse imported files on this many threads; 0 or 1 for serial
+  struct sass_parse_cache* parse_cache; // reuse files parsed by earlier compiles; may be NULL
+  int compile_threads; // sass_compile_folder: entry points compiled at once; 0 or 1 for serial
+  struct sass_import_cache* import_cache; // resolve imports from remembered listings; may be NULL
+  int memoize_functions; // reuse the results of side-effect-free function calls
+  int use_bytecode; // run @function bodies on a bytecode interpreter where possible
+};
+
+// Where a compile's time went and how much work it did. Point a context's
+// stats at one to have it filled in; leave it NULL to skip the bookkeeping.
+// CPU time is the whole process's, parse workers included.
+struct sass_compile_stats {
+  double wall_seconds[SASS_NUM_PHASES];
+  double cpu_seconds[SASS_NUM_PHASES];
+  size_t nodes; // AST nodes allocated, and their bytes
+  size_t node_bytes;
+  size_t bytes_read; // source text
+  size_t files; // style sheets parsed or taken from the parse cache
+  size_t function_calls;
+  size_t mixin_calls;
+  size_t memo_hits; // function calls answered by memoize_functions, and not
+  size_t memo_misses;
+  size_t bytecode_calls; // Sass function calls run as bytecode
+  size_t extensions; // @extend pairs, and the selectors they're indexed by
+  size_t extend_keys;
 };
 
 struct sass_context {
@@ -40,6 +85,9 @@ struct sass_context {
   int num_c_functions;
   char** included_files;
   int num_included_files;
+  size_t num_fs_calls; // stats, opens and directory listings made finding and reading files
+  struct sass_compile_stats* stats; // filled in on success when not NULL
+  struct sass_profiler* profiler; // records every mixin and function call when not NULL
 };
 
 struct sass_file_context {
@@ -56,6 +104,9 @@ struct sass_file_context {
   int num_c_functions;
   char** included_files;
   int num_included_files;
+  size_t num_fs_calls; // stats, opens and directory listings made finding and reading files
+  struct sass_compile_stats* stats; // filled in on success when not NULL
+  struct sass_profiler* profiler; // records every mixin and function call when not NULL
 };
 
 struct sass_folder_context {
@@ -68,19 +119,89 @@ struct sass_folder_context {
   int num_c_functions;
   char** included_files;
   int num_included_files;
+  size_t num_fs_calls; // stats, opens and directory listings made finding and reading files
+};
+
+// A set of entry points compiled again and again, e.g. by a dev server.
+// The project keeps what each one imported and the files it parsed, so a
+// compile after a change only redoes the entry points the change affects,
+// and only reparses the files that changed.
+struct sass_project_context {
+  struct sass_options options;
+  int error_status;
+  char* error_message;
+  struct Sass_C_Function_Descriptor* c_functions;
+  int num_c_functions;
+  char** compiled_files; // outputs written by the last sass_compile_project
+  int num_compiled_files;
+  char** dependents; // outputs found by the last sass_project_dependents
+  int num_dependents;
+  size_t num_fs_calls;
+  struct sass_project* project; // kept by the sass_project_ functions
 };
 
-struct sass_context*        sass_new_context        (void);
-struct sass_file_context*   sass_new_file_context   (void);
-struct sass_folder_context* sass_new_folder_context (void);
+struct sass_context*         sass_new_context         (void);
+struct sass_file_context*    sass_new_file_context    (void);
+struct sass_folder_context*  sass_new_folder_context  (void);
+struct sass_project_context* sass_new_project_context (void);
+
+void sass_free_context         (struct sass_context* ctx);
+void sass_free_file_context    (struct sass_file_context* ctx);
+void sass_free_folder_context  (struct sass_folder_context* ctx);
+void sass_free_project_context (struct sass_project_context* ctx);
+
+// Adds an entry point, compiled into output_path (or next to the source if
+// that's NULL) by the next sass_compile_project. Returns its index.
+int sass_project_add_entry (struct sass_project_context* ctx, const char* input_path, const char* output_path);
+// Tells the project a file was changed, created or deleted; NULL stands for
+// everything. Returns how many entry points this made stale.
+int sass_project_changed   (struct sass_project_context* ctx, const char* path);
+// Fills in dependents with the outputs that used the file when they were
+// last compiled. Returns how many there are.
+int sass_project_dependents (struct sass_project_context* ctx, const char* path);
 
-void sass_free_context        (struct sass_context* ctx);
-void sass_free_file_context   (struct sass_file_context* ctx);
-void sass_free_folder_context (struct sass_folder_context* ctx);
+// A parse cache may be handed to any number of compiles, concurrent ones
+// included, through sass_options.parse_cache. It must outlive them all.
+struct sass_parse_cache* sass_new_parse_cache    (void);
+void                     sass_free_parse_cache   (struct sass_parse_cache* cache);
+size_t                   sass_parse_cache_hits   (struct sass_parse_cache* cache);
+size_t                   sass_parse_cache_misses (struct sass_parse_cache* cache);
+
+// An import cache may be shared by any number of compiles, concurrent ones
+// included, through sass_options.import_cache. It must outlive them all. A
+// directory's listing is taken again once its modification time changes.
+struct sass_import_cache* sass_new_import_cache      (void);
+void                      sass_free_import_cache     (struct sass_import_cache* cache);
+size_t                    sass_import_cache_hits     (struct sass_import_cache* cache);
+size_t                    sass_import_cache_listings (struct sass_import_cache* cache);
+
+// A profiler adds up the calls of every compile it is handed through a
+// context's profiler, one compile at a time. Definitions are told apart by
+// name and the place they're defined. Both reports are malloc'ed strings
+// for the caller to free: collapsed stacks, with microseconds of exclusive
+// time, for flamegraph.pl, and a JSON array of the definitions with their
+// call counts, inclusive and exclusive time, and nodes allocated.
+struct sass_profiler* sass_new_profiler              (void);
+void                  sass_free_profiler             (struct sass_profiler* profiler);
+char*                 sass_profiler_collapsed_stacks (struct sass_profiler* profiler);
+char*                 sass_profiler_json             (struct sass_profiler* profiler);
+
+// How many bytes of source files have been mapped into memory and how many
+// copied, over all compiles in the process. Large files are mapped where
+// the platform allows it.
+size_t sass_source_bytes_mapped (void);
+size_t sass_source_bytes_copied (void);
 
 int sass_compile            (struct sass_context* ctx);
 int sass_compile_file       (struct sass_file_context* ctx);
 int sass_compile_folder     (struct sass_folder_context* ctx);
+// Compiles the entry points that are stale, i.e. every one the first time.
+int sass_compile_project    (struct sass_project_context* ctx);
+
+// Like sass_compile_file, but the CSS is handed over in chunks while it is
+// generated instead of being collected in output_string, which stays NULL.
+int sass_compile_file_to_writer (struct sass_file_context* ctx, sass_output_writer writer, void* cookie);
+int sass_compile_file_to_fd     (struct sass_file_context* ctx, int fd);
 
 #ifdef __cplusplus
 }
@@ -102,13 +102,18 @@ namespace Sass {
   }
 
   void SourceMap::update_column(const string& str)
+  { update_column(str.data(), str.size()); }
+
+  void SourceMap::update_column(const char* str, size_t length)
   {
-    const ptrdiff_t new_line_count = std::count(str.begin(), str.end(), '\n');
+    const ptrdiff_t new_line_count = std::count(str, str + length, '\n');
     current_position.line += new_line_count;
     if (new_line_count >= 1) {
-      current_position.column = str.size() - str.find_last_of('\n');
+      size_t last_newline = length - 1;
+      while (str[last_newline] != '\n') --last_newline;
+      current_position.column = length - last_newline;
     } else {
-      current_position.column += str.size();
+      current_position.column += length;
     }
   }
 
@@ -30,6 +30,7 @@ namespace Sass {
 
     void remove_line();
     void update_column(const string& str);
+    void update_column(const char* str, size_t length);
     void add_mapping(AST_Node* node);
 
     string generate_source_map();
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <map>
+#include <functional>
 #include <set>
 #include <algorithm>
 #include <iterator>
@@ -70,74 +71,114 @@ namespace Sass {
   triple<F, S, T> make_triple(const F& f, const S& s, const T& t)
   { return triple<F, S, T>(f, s, t); }
 
-  template<typename K, typename V>
+  /////////////////////////////////////////////////////////////////////////////
+  // Maps sets of keys to values, and finds every value whose key set is a
+  // subset of a given set. Keys are interned to dense integer ids, so each
+  // entry is just a sorted array of ids. An entry is filed under its lowest
+  // id only: any superset has to contain that id too, so a lookup visits each
+  // candidate once and never copies the entries it rejects.
+  /////////////////////////////////////////////////////////////////////////////
+  template<typename K, typename V, typename C = less<K> >
   class Subset_Map {
   private:
-    vector<V> values_;
-    map<K, vector<triple<vector<K>, set<K>, size_t> > > hash_;
+    map<K, size_t, C>       ids_;
+    vector<vector<size_t> > buckets_;  // lowest id -> indices of entries
+    vector<vector<size_t> > id_sets_;  // entry index -> sorted, unique ids
+    vector<vector<K> >      keys_;     // entry index -> keys as given
+    vector<V>               values_;
+
+    size_t intern(const K& k);
+    void ids_of(const vector<K>& s, vector<size_t>& ids) const;
   public:
     void put(const vector<K>& s, const V& value);
-    vector<pair<V, vector<K> > > get_kv(const vector<K>& s);
-    vector<V> get_v(const vector<K>& s);
-    bool empty() { return values_.empty(); }
+    void get_indices(const vector<K>& s, vector<size_t>& indices) const;
+    vector<pair<V, vector<K> > > get_kv(const vector<K>& s) const;
+    vector<V> get_v(const vector<K>& s) const;
+    const V& value(size_t i) const          { return values_[i]; }
+    const vector<K>& key(size_t i) const    { return keys_[i]; }
+    size_t size() const                     { return values_.size(); }
+    bool empty() const                      { return values_.empty(); }
   };
 
-  template<typename K, typename V>
-  void Subset_Map<K, V>::put(const vector<K>& s, const V& value)
+  template<typename K, typename V, typename C>
+  size_t Subset_Map<K, V, C>::intern(const K& k)
+  {
+    typename map<K, size_t, C>::iterator it = ids_.find(k);
+    if (it != ids_.end()) return it->second;
+    size_t id = ids_.size();
+    ids_.insert(make_pair(k, id));
+    buckets_.push_back(vector<size_t>());
+    return id;
+  }
+
+  // sorted, unique ids of the keys in s; keys never put are left out
+  template<typename K, typename V, typename C>
+  void Subset_Map<K, V, C>::ids_of(const vector<K>& s, vector<size_t>& ids) const
+  {
+    ids.clear();
+    ids.reserve(s.size());
+    for (size_t i = 0, S = s.size(); i < S; ++i) {
+      typename map<K, size_t, C>::const_iterator it = ids_.find(s[i]);
+      if (it != ids_.end()) ids.push_back(it->second);
+    }
+    sort(ids.begin(), ids.end());
+    ids.erase(unique(ids.begin(), ids.end()), ids.end());
+  }
+
+  template<typename K, typename V, typename C>
+  void Subset_Map<K, V, C>::put(const vector<K>& s, const V& value)
   {
     if (s.empty()) throw "internal error: subset map keys may not be empty";
     size_t index = values_.size();
+    for (size_t i = 0, S = s.size(); i < S; ++i) intern(s[i]);
+    id_sets_.push_back(vector<size_t>());
+    ids_of(s, id_sets_.back());
+    buckets_[id_sets_.back().front()].push_back(index);
+    keys_.push_back(s);
     values_.push_back(value);
-    set<K> ss;
-    for (size_t i = 0, S = s.size(); i < S; ++i)
-    { ss.insert(s[i]); }
-    for (size_t i = 0, S = s.size(); i < S; ++i)
-    {
-      hash_[s[i]];
-      hash_[s[i]].push_back(make_triple(s, ss, index));
-    }
   }
 
-  template<typename K, typename V>
-  vector<pair<V, vector<K> > > Subset_Map<K, V>::get_kv(const vector<K>& s)
+  // Fills indices with the (ascending) indices of every entry whose keys are
+  // all in s; use value() and key() to get at the entries themselves.
+  template<typename K, typename V, typename C>
+  void Subset_Map<K, V, C>::get_indices(const vector<K>& s, vector<size_t>& indices) const
   {
-    vector<K> sorted = s;
-    sort(sorted.begin(), sorted.end());
-    vector<pair<size_t, vector<K> > > indices;
-    for (size_t i = 0, S = s.size(); i < S; ++i) {
-      // cerr << "looking for " << s[i] << endl;
-      if (!hash_.count(s[i])) {
-        // cerr << "didn't find " << s[i] << endl;
-        continue;
-      }
-      vector<triple<vector<K>, set<K>, size_t> > subsets = hash_[s[i]];
-      // cerr << "length of subsets: " << subsets.size() << endl;
-      for (size_t j = 0, T = subsets.size(); j < T; ++j) {
-        if (!includes(sorted.begin(), sorted.end(), subsets[j].second.begin(), subsets[j].second.end())) {
-          // cout << vector_to_string(s) << " doesn't include " << set_to_string(subsets[j].second) << endl;
-          continue;
-        }
-        indices.push_back(make_pair(subsets[j].third, subsets[j].first));
-        // cerr << "pushed " << subsets[j].third << " and " << vector_to_string(subsets[j].first) << " onto indices" << endl;
+    indices.clear();
+    vector<size_t> ids;
+    ids_of(s, ids);
+    for (size_t i = 0, S = ids.size(); i < S; ++i) {
+      const vector<size_t>& bucket = buckets_[ids[i]];
+      for (size_t j = 0, T = bucket.size(); j < T; ++j) {
+        const vector<size_t>& subset = id_sets_[bucket[j]];
+        // both are sorted, and the query already contains the lowest id
+        if (includes(ids.begin() + i, ids.end(), subset.begin(), subset.end()))
+        { indices.push_back(bucket[j]); }
       }
     }
     sort(indices.begin(), indices.end());
-    typename vector<pair<size_t, vector<K> > >::iterator indices_end = unique(indices.begin(), indices.end());
-    indices.resize(distance(indices.begin(), indices_end));
+  }
 
+  template<typename K, typename V, typename C>
+  vector<pair<V, vector<K> > > Subset_Map<K, V, C>::get_kv(const vector<K>& s) const
+  {
+    vector<size_t> indices;
+    get_indices(s, indices);
     vector<pair<V, vector<K> > > results;
+    results.reserve(indices.size());
     for (size_t i = 0, S = indices.size(); i < S; ++i) {
-      results.push_back(make_pair(values_[indices[i].first], indices[i].second));
+      results.push_back(make_pair(values_[indices[i]], keys_[indices[i]]));
     }
     return results;
   }
 
-  template<typename K, typename V>
-  vector<V> Subset_Map<K, V>::get_v(const vector<K>& s)
+  template<typename K, typename V, typename C>
+  vector<V> Subset_Map<K, V, C>::get_v(const vector<K>& s) const
   {
-    vector<pair<V, vector<K> > > kvs = get_kv(s);
+    vector<size_t> indices;
+    get_indices(s, indices);
     vector<V> results;
-    for (size_t i = 0, S = kvs.size(); i < S; ++i) results.push_back(kvs[i].first);
+    results.reserve(indices.size());
+    for (size_t i = 0, S = indices.size(); i < S; ++i) results.push_back(values_[indices[i]]);
     return results;
   }
 
@@ -0,0 +1,83 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <ctime>
+#include "../parser.hpp"
+#include "../file.hpp"
+
+// Measures parse throughput: each file is parsed on its own, with imports
+// resolved but not followed.
+//
+//   g++ -I.. bench_parser.cpp ../libsass.a -o bench_parser
+//   ./bench_parser $(find sass-spec/spec -name '*.scss')
+
+using namespace std;
+using namespace Sass;
+
+int main(int argc, char** argv)
+{
+  Context ctx(Context::Data().source_c_str(0)
+                             .entry_point("")
+                             .output_path("")
+                             .image_path("")
+                             .include_paths_c_str(0)
+                             .include_paths_array(0)
+                             .include_paths(vector<string>())
+                             .source_comments(false)
+                             .source_maps(false)
+                             .output_style(NESTED)
+                             .source_map_file("")
+                             .omit_source_map_url(false)
+                             .precision(5)
+                             .parse_threads(0)
+                             .parse_cache(0)
+                             .import_cache(0)
+                             .stats(0)
+                             .profiler(0)
+                             .memoize_functions(false)
+                             .use_bytecode(false));
+
+  vector<string> paths, sources;
+  size_t bytes = 0;
+  for (int i = 1; i < argc; ++i) {
+    ifstream file(argv[i], ios::in | ios::binary);
+    stringstream contents;
+    contents << file.rdbuf();
+    paths.push_back(argv[i]);
+    sources.push_back(contents.str());
+    bytes += sources.back().length();
+  }
+  if (!bytes) {
+    cout << "usage: " << argv[0] << " file.scss..." << endl;
+    return 1;
+  }
+
+  // the fastest round is the one least disturbed by everything else
+  size_t rounds = 1 + 20000000 / bytes, parsed = 0, failed = 0;
+  double seconds = 0;
+  for (size_t r = 0; r < rounds; ++r) {
+    clock_t start = clock();
+    for (size_t i = 0; i < sources.size(); ++i) {
+      Memory_Manager<AST_Node> mem;
+      Context::Pending_Imports pending;
+      try {
+        Parser::from_c_str(sources[i].c_str(), ctx, paths[i].c_str(), Position(1, 1, 1), &mem, &pending).parse();
+        ++parsed;
+      }
+      catch (Error&) {
+        // the corpus has sheets that are meant not to parse
+        ++failed;
+      }
+      for (size_t j = 0; j < pending.files.size(); ++j) File::release_file(pending.files[j].contents);
+    }
+    double round = double(clock() - start) / CLOCKS_PER_SEC;
+    if (!r || round < seconds) seconds = round;
+  }
+
+  cout << sources.size() << " files, " << bytes << " bytes, best of " << rounds << " rounds: "
+       << seconds << "s, " << (bytes / seconds / 1e6) << " MB/s ("
+       << parsed << " parsed, " << failed << " failed)" << endl;
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <string>
+#include <iostream>
+#include "../sass_interface.h"
+
+// g++ -I.. test_bytecode.cpp ../libsass.a -pthread -o test_bytecode
+
+using namespace std;
+
+// function bodies that exercise the bytecode and what it hands back to Eval
+const char* source =
+  "$g: 5;\n"
+  "$i: global-i;\n"
+  "@function loopvar-after() { @for $i from 1 through 3 { } @return $i; }\n"
+  "@function created-in-loop() { @for $k from 1 through 3 { @if $k == 3 { @return $acc; } $acc: $k * 10; } @return none; }\n"
+  "@function outer-then-loop() { $acc: 0; @each $x in 1 2 3 { $acc: $acc + $x; } @return $acc; }\n"
+  "@function shadow-param($x) { @each $x in a b c { } @return $x; }\n"
+  "@function assign-loopvar() { $r: (); @for $j from 1 to 4 { $j: $j * 100; $r: append($r, $j); } @return $r; }\n"
+  "@function sets-global() { $g: $g + 1; @return $g; }\n"
+  "@function reads-global($x) { @return $x + $g; }\n"
+  "@function fact($n) { @if $n <= 1 { @return 1; } @return $n * fact($n - 1); }\n"
+  "@function sqrt($x) { $r: $x / 2; $n: 0; @while $n < 20 { $r: ($r + $x / $r) / 2; $n: $n + 1; } @return $r; }\n"
+  "@function units($a) { @return $a * 2 + 1px; }\n"
+  "@function cmp($a, $b) { @return ($a < $b) ($a <= $b) ($a > $b) ($a >= $b) ($a == $b) ($a != $b); }\n"
+  "@function logic($a, $b) { @return ($a and $b) ($a or $b); }\n"
+  "@function divs($a) { @return (10/2) ($a / 2) 10px/2px ($a / 0) ($a % 3); }\n"
+  "@function neg($a) { @return -$a; }\n"
+  "@function negnull() { $n: null; @return -$n; }\n"
+  "@function colors($c) { @return $c + red, red, $c * 2, #abc + 1; }\n"
+  "@function strs($s) { @return $s + \"x\", \"a\" + $s, $s + 1; }\n"
+  "@function exists() { $local: 1; @return variable-exists(local) variable-exists(nope) function-exists(fact); }\n"
+  "@function lazy($c) { @return if($c, 1, nope()); }\n"
+  "@function unknown($x) { @return foo($x, 2); }\n"
+  "@function rest($args...) { @return length($args) nth($args, 1); }\n"
+  "@function named($a, $b: 2) { @return $a - $b; }\n"
+  "@function call-rest() { $l: 1 2 3; @return rest($l...) named($b: 10, $a: 1) rest(1, 2); }\n"
+  "@function each-arglist($args...) { $s: 0; @each $a in $args { $s: $s + $a; } @return $s; }\n"
+  "@function each-single() { $s: (); @each $a in 7 { $s: append($s, $a); } @return $s; }\n"
+  "@function guarded() { $d: 1 !default; @return $d; }\n"
+  "@function interp($x) { @return \"a#{$x}b\" #{$x}px; }\n"
+  "@function early($x) { @each $y in 1 2 3 4 { @if $y == $x { @return $y * 11; } } @return none; }\n"
+  "@function nested-loops() { $out: (); @for $a from 1 through 2 { @for $b from 1 through 2 { $t: $a * 10 + $b; $out: append($out, $t); } } @return $out; }\n"
+  "@function after-nested() { @for $a from 1 through 2 { $t: $a; } @return variable-exists(t); }\n"
+  "@function mixed($x) { @return $x + 1em, 1em + $x, $x * 1em, $x > 1; }\n"
+  "@function bools() { @return true == true, true != false, null == null, (1 == 1) == true; }\n"
+  ".a {\n"
+  "  a: loopvar-after() created-in-loop() outer-then-loop() shadow-param(q);\n"
+  "  b: assign-loopvar();\n"
+  "  c: sets-global() sets-global() $g reads-global(1);\n"
+  "  d: fact(10) sqrt(2) sqrt(144) units(3) units(3px);\n"
+  "  e: cmp(1, 2) cmp(2px, 2px) cmp(3, 2);\n"
+  "  f: logic(true, false) logic(1, null) logic(null, 2);\n"
+  "  g: divs(5) neg(3) neg(2px) negnull();\n"
+  "  h: colors(#102030);\n"
+  "  i: strs(abc) strs(\"q\");\n"
+  "  j: exists() lazy(true) lazy(false) unknown(3);\n"
+  "  k: call-rest() each-arglist(1, 2, 3) each-single();\n"
+  "  l: guarded() interp(5) early(3) early(9);\n"
+  "  m: nested-loops() after-nested();\n"
+  "  n: mixed(2);\n"
+  "  o: bools();\n"
+  "}\n";
+
+string compile(bool use_bytecode, sass_compile_stats& stats)
+{
+  sass_context* ctx = sass_new_context();
+  ctx->source_string = source;
+  ctx->options.use_bytecode = use_bytecode;
+  ctx->stats = &stats;
+  sass_compile(ctx);
+  string css(ctx->error_status ? ctx->error_message : ctx->output_string);
+  sass_free_context(ctx);
+  return css;
+}
+
+int main()
+{
+  sass_compile_stats walked, compiled;
+  string expected(compile(false, walked));
+  string actual(compile(true, compiled));
+  size_t failures = 0;
+  if (actual != expected) {
+    cout << "bytecode output differs:" << endl << actual << endl << "expected:" << endl << expected << endl;
+    ++failures;
+  }
+  if (walked.bytecode_calls || compiled.bytecode_calls == 0) {
+    cout << "unexpected bytecode calls: " << walked.bytecode_calls << " and " << compiled.bytecode_calls << endl;
+    ++failures;
+  }
+  cout << compiled.bytecode_calls << " of " << compiled.function_calls << " calls run as bytecode" << endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include "../color_names.hpp"
+
+using namespace std;
+using namespace Sass;
+
+int value_of(size_t i)
+{ return int(color_values[i*3])*0x10000 + int(color_values[i*3+1])*0x100 + int(color_values[i*3+2]); }
+
+// Finds a displacement for each bucket that sends its keys to free slots,
+// fullest buckets first.
+bool displace(const vector<unsigned int>& hashes, const vector<size_t>& indices,
+              vector<unsigned int>& displacements, vector<size_t>& slots)
+{
+  vector< vector<size_t> > buckets(color_hash_buckets);
+  for (size_t k = 0; k < hashes.size(); ++k) buckets[color_hash_bucket(hashes[k])].push_back(k);
+  vector<size_t> order;
+  for (size_t b = 0; b < color_hash_buckets; ++b) order.push_back(b);
+  for (size_t i = 0; i < order.size(); ++i) {
+    for (size_t j = i + 1; j < order.size(); ++j) {
+      if (buckets[order[j]].size() > buckets[order[i]].size()) swap(order[i], order[j]);
+    }
+  }
+  displacements.assign(color_hash_buckets, 0);
+  slots.assign(color_hash_slots, 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    const vector<size_t>& keys = buckets[order[i]];
+    if (keys.empty()) break;
+    bool placed = false;
+    for (unsigned int d = 0; d < 1000000 && !placed; ++d) {
+      vector<size_t> taken;
+      for (size_t k = 0; k < keys.size(); ++k) {
+        size_t s = color_hash_slot(hashes[keys[k]], d);
+        if (slots[s] || find(taken.begin(), taken.end(), s) != taken.end()) break;
+        taken.push_back(s);
+      }
+      if (taken.size() < keys.size()) continue;
+      for (size_t k = 0; k < keys.size(); ++k) slots[taken[k]] = indices[keys[k]] + 1;
+      displacements[order[i]] = d;
+      placed = true;
+    }
+    if (!placed) return false;
+  }
+  return true;
+}
+
+template <typename T>
+void print_table(const char* type, const char* name, const char* size, const vector<T>& table)
+{
+  cout << "  static const " << type << " " << name << "[" << size << "] = {";
+  for (size_t i = 0; i < table.size(); ++i) {
+    cout << (i % 12 ? " " : "\n    ") << table[i] << (i + 1 < table.size() ? "," : "");
+  }
+  cout << "\n  };\n\n";
+}
+
+int generate()
+{
+  vector<unsigned int> name_hashes, value_hashes;
+  vector<size_t> name_indices, value_indices;
+  map<int, size_t> names_by_value;
+  unsigned int initials = 0;
+  size_t shortest = 1000, longest = 0;
+  for (size_t i = 0; color_names[i]; ++i) {
+    size_t len = strlen(color_names[i]);
+    name_hashes.push_back(color_name_hash(color_names[i], len));
+    name_indices.push_back(i);
+    names_by_value[value_of(i)] = i;
+    initials |= 1u << (color_names[i][0] - 'a');
+    shortest = min(shortest, len);
+    longest  = max(longest, len);
+  }
+  for (map<int, size_t>::iterator v = names_by_value.begin(); v != names_by_value.end(); ++v) {
+    value_hashes.push_back(color_value_hash(v->first));
+    value_indices.push_back(v->second);
+  }
+
+  vector<unsigned int> name_displacements, value_displacements;
+  vector<size_t> name_slots, value_slots;
+  if (!displace(name_hashes, name_indices, name_displacements, name_slots) ||
+      !displace(value_hashes, value_indices, value_displacements, value_slots)) {
+    cerr << "no perfect hash with these parameters" << endl;
+    return 1;
+  }
+
+  cout << "  // generated by test/test_color_names.cpp --generate\n";
+  cout << "  static const unsigned int color_name_initials = 0x" << hex << initials << dec << ";\n";
+  cout << "  static const size_t shortest_color_name = " << shortest << ";\n";
+  cout << "  static const size_t longest_color_name  = " << longest << ";\n\n";
+  print_table("unsigned int", "color_name_displacements", "color_hash_buckets", name_displacements);
+  print_table("unsigned char", "color_name_slots", "color_hash_slots", name_slots);
+  print_table("unsigned int", "color_value_displacements", "color_hash_buckets", value_displacements);
+  print_table("unsigned char", "color_value_slots", "color_hash_slots", value_slots);
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1 && string(argv[1]) == "--generate") return generate();
+
+  size_t failures = 0;
+  map<int, string> last_names;
+  for (size_t i = 0; color_names[i]; ++i) {
+    last_names[value_of(i)] = color_names[i];
+    if (name_to_color(color_names[i]) != value_of(i)) {
+      cout << "wrong value for " << color_names[i] << endl;
+      ++failures;
+    }
+  }
+  for (map<int, string>::iterator v = last_names.begin(); v != last_names.end(); ++v) {
+    const char* name = color_to_name(v->first);
+    if (!name || v->second != name) {
+      cout << "wrong name for " << hex << v->first << dec << endl;
+      ++failures;
+    }
+  }
+
+  const char* strangers[] = {
+    "", "r", "re", "reds", "Red", "RED", "arial", "helvetica", "sans-serif",
+    "inherit", "none", "bold", "aliceblu", "aliceblues", "yellowgreenish",
+    "lightgoldenrodyellowx", "transparent", "currentColor", 0
+  };
+  for (size_t i = 0; strangers[i]; ++i) {
+    if (name_to_color(strangers[i]) != -1) {
+      cout << "\"" << strangers[i] << "\" taken for a color" << endl;
+      ++failures;
+    }
+  }
+  for (int rgb = 0; rgb <= 0xffffff; ++rgb) {
+    if (color_to_name(rgb) && !last_names.count(rgb)) {
+      cout << hex << rgb << dec << " taken for a named color" << endl;
+      ++failures;
+    }
+  }
+  if (color_to_name(-1) || color_to_name(0x1000000)) ++failures;
+
+  cout << last_names.size() << " named values, " << failures << " failures" << endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include "../dependency_graph.hpp"
+
+// g++ test_dependency_graph.cpp ../dependency_graph.cpp ../file.cpp ../sass2scss/sass2scss.cpp -pthread
+
+using namespace std;
+using namespace Sass;
+
+size_t failures = 0;
+
+void expect(bool ok, const string& what)
+{
+  if (!ok) {
+    cout << what << endl;
+    ++failures;
+  }
+}
+
+vector<string> files(const char* a, const char* b = 0, const char* c = 0)
+{
+  vector<string> v;
+  v.push_back(a);
+  if (b) v.push_back(b);
+  if (c) v.push_back(c);
+  return v;
+}
+
+int main()
+{
+  Dependency_Graph graph("/project/");
+  size_t site = graph.add_entry("site.scss");
+  size_t admin = graph.add_entry("/project/admin.scss");
+  size_t print = graph.add_entry("print.scss");
+  expect(graph.stale(site) && graph.stale(admin) && graph.stale(print), "new entry points should be stale");
+
+  graph.record(site, files("/project/site.scss", "/project/_variables.scss", "/lib/_grid.scss"), false);
+  graph.record(admin, files("/project/admin.scss", "/project/./_variables.scss"), false);
+  graph.record(print, vector<string>(), false);
+  expect(!graph.stale(site) && !graph.stale(admin) && !graph.stale(print), "recorded entry points should be fresh");
+
+  vector<size_t> users(graph.dependents("_variables.scss"));
+  expect(users.size() == 2 && users[0] == site && users[1] == admin, "wrong dependents of _variables.scss");
+  expect(graph.dependents("/lib/_grid.scss").size() == 1, "wrong dependents of _grid.scss");
+  expect(graph.dependents("print.scss").size() == 1, "an entry point should depend on itself");
+  expect(graph.dependents("_other.scss").empty(), "unused files should have no dependents");
+
+  // a file in the graph only affects the entry points that used it
+  expect(graph.changed("/lib/_grid.scss") == 1, "_grid.scss should make one entry point stale");
+  expect(graph.stale(site) && !graph.stale(admin) && !graph.stale(print), "wrong entry points stale after _grid.scss");
+  expect(graph.changed("/lib/_grid.scss") == 0, "stale entry points shouldn't be counted again");
+  graph.record(site, files("/project/site.scss", "/project/_variables.scss", "/lib/_grid.scss"), false);
+
+  // a new file may shadow one that was imported under the same name
+  expect(graph.changed("/project/grid.scss") == 1 && graph.stale(site), "grid.scss should make site stale");
+  graph.record(site, files("/project/site.scss", "/project/_variables.scss", "/project/grid.scss"), false);
+  expect(graph.dependents("/lib/_grid.scss").empty(), "a new record should replace the old one");
+  // ... and the file it shadows could come back into play
+  expect(graph.changed("/lib/_grid.scss") == 1, "_grid.scss shares an import name with grid.scss");
+  graph.record(site, files("/project/site.scss", "/project/_variables.scss", "/project/grid.scss"), false);
+
+  // a failed compile is redone whatever changes
+  graph.record(admin, vector<string>(), true);
+  expect(graph.changed("/project/_unrelated.scss") == 1 && graph.stale(admin), "a failed entry point should go stale");
+
+  graph.changed_all();
+  expect(graph.stale(site) && graph.stale(print), "everything should be stale");
+
+  cout << failures << " failures" << endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+#include <string>
+#include <iostream>
+#include <cstring>
+#include "../sass_interface.h"
+
+// g++ -I.. test_function_memo.cpp ../libsass.a -pthread -o test_function_memo
+
+using namespace std;
+
+// calls that may and may not be replayed, each made more than once
+const char* source =
+  "$base: 16px;\n"
+  "@function rem($px) { @return $px / $base * 1rem; }\n"
+  "@function fact($n) { @if $n <= 1 { @return 1; } @return $n * fact($n - 1); }\n"
+  "@function local($x) { $y: $x * 2; @each $i in 1 2 { $y: $y + $i; } @return $y; }\n"
+  "$counter: 0;\n"
+  "@function bump($x) { $counter: $counter + 1; @return $x + $counter; }\n"
+  "@function exists($n) { @return variable-exists($n); }\n"
+  "@function calls-late($x) { @return later($x); }\n"
+  ".a { w: rem(32px); w: rem(32px); f: fact(5); f: fact(5); c: mix(white, red, 10%); c: mix(white, red, 10%); }\n"
+  "$base: 10px;\n"
+  ".b { w: rem(32px); l: local(3); l: local(3); }\n"
+  ".c { b: bump(1); b: bump(1); }\n"
+  ".d { x: exists(nope); x: exists(nope); }\n"
+  ".e { x: calls-late(1); }\n"
+  "@function later($x) { @return $x * 100; }\n"
+  ".e { x: calls-late(1); }\n"
+  "@function rem($px) { @return $px * 2; }\n"
+  ".f { w: rem(32px); n: rem(1.000001px); n: rem(1.000002px); }\n"
+  // the first caller changes the color it gets back in place
+  "@function hex() { @return #FFF; }\n"
+  ".g { x: hex() + \"x\"; y: hex(); }\n"
+  "@function hexes() { @return #FFF #000; }\n"
+  ".g { x: nth(hexes(), 1) + \"x\"; y: hexes(); }\n";
+
+string compile(bool memoize, sass_compile_stats& stats)
+{
+  sass_context* ctx = sass_new_context();
+  ctx->source_string = source;
+  ctx->options.memoize_functions = memoize;
+  ctx->stats = &stats;
+  sass_compile(ctx);
+  string css(ctx->error_status ? ctx->error_message : ctx->output_string);
+  sass_free_context(ctx);
+  return css;
+}
+
+int main()
+{
+  sass_compile_stats plain, memoized;
+  string expected(compile(false, plain));
+  string actual(compile(true, memoized));
+  size_t failures = 0;
+  if (actual != expected) {
+    cout << "memoized output differs:" << endl << actual << endl << "expected:" << endl << expected << endl;
+    ++failures;
+  }
+  if (actual.find("y: #FFF;") == string::npos || actual.find("y: #FFF #000;") == string::npos) {
+    cout << "memoized results were changed by their callers:" << endl << actual << endl;
+    ++failures;
+  }
+  if (plain.memo_hits || memoized.memo_hits == 0) {
+    cout << "unexpected memo hits: " << plain.memo_hits << " and " << memoized.memo_hits << endl;
+    ++failures;
+  }
+  cout << memoized.memo_hits << " hits, " << memoized.memo_misses << " misses" << endl;
+  return failures ? 1 : 0;
+}
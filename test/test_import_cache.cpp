@@ -0,0 +1,68 @@
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../import_cache.hpp"
+
+// g++ test_import_cache.cpp ../import_cache.cpp ../mutex.cpp -pthread
+
+using namespace std;
+using namespace Sass;
+
+size_t failures = 0;
+
+void expect(bool ok, const string& what)
+{
+  if (!ok) {
+    cout << what << endl;
+    ++failures;
+  }
+}
+
+int main()
+{
+  string dir("test_import_cache.tmp");
+  mkdir(dir.c_str(), 0755);
+  ofstream((dir + "/_a.scss").c_str()) << ".a { b: c; }";
+
+  Import_Cache cache;
+  string names[] = { "a", "_a.scss", "b.scss" };
+  bool found[3];
+  size_t fs_calls = 0;
+
+  // the first lookup stats and lists the directory
+  Import_Cache::Session first(&cache);
+  cache.find(first, dir, names, 3, found, fs_calls);
+  expect(!found[0] && found[1] && !found[2], "wrong entries on the first lookup");
+  expect(fs_calls == 2, "first lookup should stat and list");
+
+  // the same compile trusts what it has already seen
+  fs_calls = 0;
+  cache.find(first, dir, names, 3, found, fs_calls);
+  expect(found[1] && fs_calls == 0, "second lookup in a compile should be free");
+
+  // a missing directory is remembered as missing
+  fs_calls = 0;
+  cache.find(first, dir + "/none", names, 3, found, fs_calls);
+  expect(!found[1] && fs_calls == 1, "missing directory should cost one stat");
+  cache.find(first, dir + "/none", names, 3, found, fs_calls);
+  expect(fs_calls == 1, "missing directory should be remembered");
+
+  // a later compile sees a file added since; the directory was listed in
+  // the second it changed, so the listing can't be trusted
+  ofstream((dir + "/b.scss").c_str()) << ".b { c: d; }";
+  fs_calls = 0;
+  Import_Cache::Session second(&cache);
+  cache.find(second, dir, names, 3, found, fs_calls);
+  expect(found[1] && found[2], "a new file should be found by the next compile");
+
+  expect(cache.hits() == 2 && cache.listings() == 3, "wrong hit or listing counts");
+
+  remove((dir + "/b.scss").c_str());
+  remove((dir + "/_a.scss").c_str());
+  rmdir(dir.c_str());
+  cout << failures << " failures" << endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <limits>
+#include "../number_format.hpp"
+
+using namespace std;
+using namespace Sass;
+
+string formatted(double value, size_t precision)
+{
+  char buffer[number_buffer_size];
+  size_t len = format_number(value, precision, buffer);
+  return len ? string(buffer, len) : format_number_slow(value, precision);
+}
+
+size_t mismatches = 0;
+
+void check(double value, size_t precision)
+{
+  string fast(formatted(value, precision));
+  string slow(format_number_slow(value, precision));
+  if (fast != slow && mismatches++ < 20) {
+    cout.precision(17);
+    cout << "mismatch for " << value << " at precision " << precision << ": "
+         << fast << " vs " << slow << endl;
+  }
+}
+
+double random_bits()
+{
+  unsigned long long bits = 0;
+  for (size_t i = 0; i < 4; ++i) bits = (bits << 16) ^ (rand() & 0xffff);
+  double d;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+void compare(size_t samples)
+{
+  const double edges[] = {
+    0.0, -0.0, 0.5, -0.5, 1.5, 2.5, 0.125, 0.375, 1e-5, 5e-6, 4.9999999e-6,
+    -4e-6, 0.1, 0.2, 0.3, 1.0/3, 2.0/3, 99.999995, 1e15, 1e16, 1125899906842623.5,
+    9007199254740993.0, 1e300, -1e300, 4.9e-324, HUGE_VAL, -HUGE_VAL
+  };
+  for (size_t p = 0; p <= 20; ++p) {
+    for (size_t i = 0; i < sizeof(edges)/sizeof(edges[0]); ++i) check(edges[i], p);
+    check(numeric_limits<double>::quiet_NaN(), p);
+  }
+  srand(20140601);
+  for (size_t i = 0; i < samples; ++i) {
+    size_t p = i % 17;
+    // short decimals, like the ones style sheets are full of
+    check((rand() % 2000000 - 1000000) / pow(10.0, rand() % 9), p);
+    // results of arithmetic on them
+    check((rand() % 20000) / 7.0 * ((rand() % 200) - 100) / 3.0, p);
+    // ties and near-ties at the precision being printed
+    check((2 * (rand() % 100000) + 1) / (2 * pow(10.0, double(p))), p);
+    // anything at all
+    check(random_bits(), p);
+  }
+  cout << samples << " samples per kind, " << mismatches << " mismatches" << endl;
+}
+
+void bench(size_t count)
+{
+  double* values = new double[count];
+  for (size_t i = 0; i < count; ++i) values[i] = (rand() % 2000000) / pow(10.0, rand() % 6);
+
+  size_t length = 0;
+  clock_t start = clock();
+  for (size_t i = 0; i < count; ++i) length += format_number_slow(values[i], 5).length();
+  double slow = double(clock() - start) / CLOCKS_PER_SEC;
+
+  char buffer[number_buffer_size];
+  start = clock();
+  for (size_t i = 0; i < count; ++i) {
+    size_t len = format_number(values[i], 5, buffer);
+    length += len ? len : format_number_slow(values[i], 5).length();
+  }
+  double fast = double(clock() - start) / CLOCKS_PER_SEC;
+
+  cout << count << " numbers: " << slow << "s with stringstream, "
+       << fast << "s with format_number (" << length << " chars)" << endl;
+  delete[] values;
+}
+
+int main()
+{
+  compare(1000000);
+  bench(2000000);
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../sass_interface.h"
+
+// g++ -I.. test_parse_cache.cpp ../libsass.a -pthread -o test_parse_cache
+
+using namespace std;
+
+// functions that hand back parsed constants and take delayed arguments,
+// which evaluation must not change in the cached tree
+const char* source =
+  "@function str() { @return \"x\"; }\n"
+  "@function yes() { @return true; }\n"
+  "@function nothing() { @return null; }\n"
+  "@function id($x) { @return $x; }\n"
+  "@function half($x) { @return $x / 2; }\n"
+  "@mixin m($c) { color: id($c); width: half(10px); }\n"
+  ".a { s: str() str(); b: yes(); n: nothing(); c: id(red) id(blue); d: id(10px/2px) half(8px); @include m(green); }\n"
+  ".b { c: id(red); d: 10px/2px; s: str(); }\n";
+
+struct Job {
+  sass_parse_cache* cache;
+  bool              use_bytecode;
+  size_t            rounds;
+  vector<string>    outputs;
+};
+
+string compile(sass_parse_cache* cache, bool use_bytecode)
+{
+  sass_context* ctx = sass_new_context();
+  ctx->source_string = source;
+  ctx->options.parse_cache = cache;
+  ctx->options.use_bytecode = use_bytecode;
+  sass_compile(ctx);
+  string css(ctx->error_status ? ctx->error_message : ctx->output_string);
+  sass_free_context(ctx);
+  return css;
+}
+
+void* run(void* arg)
+{
+  Job* job = static_cast<Job*>(arg);
+  for (size_t i = 0; i < job->rounds; ++i) job->outputs.push_back(compile(job->cache, job->use_bytecode));
+  return 0;
+}
+
+void write(const string& path, const char* text)
+{
+  ofstream file(path.c_str());
+  file << text;
+}
+
+// an import that finds another file than the cached tree's did; the tree
+// is parsed again, and the files seen while checking its imports are only
+// reported once
+size_t check_moved_import(int parse_threads)
+{
+  size_t failures = 0;
+  string dir("test_parse_cache.tmp");
+  mkdir(dir.c_str(), 0755);
+  mkdir((dir + "/inc").c_str(), 0755);
+  write(dir + "/main.scss", "@import \"a\";\n@import \"b\";\n.x { y: $v; }\n");
+  write(dir + "/_a.scss", "$v: 1;");
+  write(dir + "/inc/_b.scss", ".b { c: d; }");
+
+  sass_parse_cache* cache = sass_new_parse_cache();
+  string inc(dir + "/inc");
+  for (int round = 0; round < 3; ++round) {
+    // from the second compile on, the import is found next to main.scss
+    if (round == 1) write(dir + "/_b.scss", ".b { c: e; }");
+    sass_file_context* ctx = sass_new_file_context();
+    ctx->input_path = "test_parse_cache.tmp/main.scss";
+    ctx->options.include_paths = inc.c_str();
+    ctx->options.parse_cache = cache;
+    ctx->options.parse_threads = parse_threads;
+    sass_compile_file(ctx);
+    if (ctx->error_status) {
+      cout << "moved import: " << ctx->error_message << endl;
+      ++failures;
+    }
+    else {
+      string css(ctx->output_string);
+      string b(round ? "c: e;" : "c: d;");
+      if (css.find(b) == string::npos || css.find("y: 1;") == string::npos) {
+        cout << "moved import, round " << round << ":" << endl << css << endl;
+        ++failures;
+      }
+      string names;
+      for (int i = 0; i < ctx->num_included_files; ++i) names += string(ctx->included_files[i]) + " ";
+      if (ctx->num_included_files != 3 || names.find(round ? dir + "/_b.scss" : inc + "/_b.scss") == string::npos) {
+        cout << "moved import, round " << round << ", included files: " << names << endl;
+        ++failures;
+      }
+    }
+    sass_free_file_context(ctx);
+  }
+  if (sass_parse_cache_hits(cache) == 0) {
+    cout << "moved import: the cache was never used" << endl;
+    ++failures;
+  }
+  sass_free_parse_cache(cache);
+
+  remove((dir + "/_b.scss").c_str());
+  remove((dir + "/inc/_b.scss").c_str());
+  remove((dir + "/_a.scss").c_str());
+  remove((dir + "/main.scss").c_str());
+  rmdir((dir + "/inc").c_str());
+  rmdir(dir.c_str());
+  return failures;
+}
+
+int main()
+{
+  string expected(compile(0, false));
+  sass_parse_cache* cache = sass_new_parse_cache();
+  // compiles on several threads share one cache, with and without bytecode
+  const size_t threads = 4;
+  Job jobs[threads];
+  pthread_t ids[threads];
+  for (size_t t = 0; t < threads; ++t) {
+    jobs[t].cache = cache;
+    jobs[t].use_bytecode = t % 2 == 1;
+    jobs[t].rounds = 50;
+    pthread_create(&ids[t], 0, run, &jobs[t]);
+  }
+  for (size_t t = 0; t < threads; ++t) pthread_join(ids[t], 0);
+
+  size_t failures = 0;
+  for (size_t t = 0; t < threads; ++t) {
+    for (size_t i = 0; i < jobs[t].outputs.size(); ++i) {
+      if (jobs[t].outputs[i] != expected && failures++ < 5) {
+        cout << "output with a shared cache differs:" << endl << jobs[t].outputs[i] << endl
+             << "expected:" << endl << expected << endl;
+      }
+    }
+  }
+  if (sass_parse_cache_hits(cache) == 0) {
+    cout << "the cache was never used" << endl;
+    ++failures;
+  }
+  cout << sass_parse_cache_hits(cache) << " hits, " << sass_parse_cache_misses(cache) << " misses" << endl;
+  sass_free_parse_cache(cache);
+
+  failures += check_moved_import(0);
+  failures += check_moved_import(2);
+  return failures ? 1 : 0;
+}
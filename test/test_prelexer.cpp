@@ -0,0 +1,168 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+#include "../constants.hpp"
+#include "../prelexer.hpp"
+
+using namespace std;
+using namespace Sass;
+using namespace Sass::Prelexer;
+using namespace Sass::Constants;
+
+// The combinator versions the table-driven matchers replaced.
+namespace Reference {
+  const char* space(const char* src) { return std::isspace(*src) ? src+1 : 0; }
+  const char* spaces(const char* src) { return one_plus<space>(src); }
+  const char* optional_spaces(const char* src) { return optional<spaces>(src); }
+  const char* line_comment(const char* src) { return to_endl<slash_slash>(src); }
+  const char* block_comment(const char* src) {
+    return sequence< optional_spaces, delimited_by<slash_star, star_slash, false> >(src);
+  }
+  const char* comment(const char* src) { return alternatives<line_comment, block_comment>(src); }
+  const char* spaces_and_comments(const char* src) {
+    return zero_plus< alternatives<spaces, comment> >(src);
+  }
+  template <char q>
+  const char* quoted_string(const char* src) {
+    src = exactly<q>(src);
+    if (!src) return 0;
+    const char* p;
+    while (1) {
+      if (!*src) return 0;
+      if ((p = sequence< exactly<'\\'>, any_char >(src))) src = p;
+      else if ((p = exactly<q>(src))) return p;
+      else ++src;
+    }
+  }
+}
+
+size_t failures = 0;
+
+void fail(const string& what, const string& input)
+{
+  if (failures++ < 20) cout << what << " differs on \"" << input << "\"" << endl;
+}
+
+bool in(const char* set, int c) { return c && strchr(set, c); }
+
+void check_classes()
+{
+  for (int i = 0; i < 256; ++i) {
+    char c = char(i);
+    bool ascii = i < 0x80;
+    bool expected[] = {
+      ascii && isspace(i), !ascii || isalpha(i), ascii && isdigit(i),
+      ascii && isxdigit(i), ascii && ispunct(i), in(sign_chars, i),
+      in(url_space_chars, i), in(escape_chars, i)
+    };
+    for (int k = 0; k < 8; ++k) {
+      if (is_char_class(c, 1 << k) != expected[k]) {
+        cout << "class " << (1 << k) << " differs on byte " << i << endl;
+        ++failures;
+      }
+    }
+  }
+}
+
+string random_source(size_t length)
+{
+  static const char* pieces[] = {
+    " ", "  ", "\n", "\t", "\r\n", "/", "*", "//", "/*", "*/", "\\", "\\\"",
+    "\\'", "\"", "'", "a", "bc", "-", "1", "\xc3\xa9", ";", "{", "}"
+  };
+  string s;
+  while (s.length() < length) s += pieces[rand() % (sizeof(pieces)/sizeof(pieces[0]))];
+  return s;
+}
+
+void compare(prelexer fast, prelexer slow, const string& what, const char* src, const string& input)
+{
+  if (fast(src) != slow(src)) fail(what, input);
+}
+
+void check_skippers(size_t samples)
+{
+  srand(20140615);
+  for (size_t i = 0; i < samples; ++i) {
+    string input(random_source(rand() % 100));
+    // an exact-size copy, so that AddressSanitizer catches reads past it
+    char* src = new char[input.length() + 1];
+    memcpy(src, input.c_str(), input.length() + 1);
+    for (size_t start = 0; start <= input.length(); ++start) {
+      const char* p = src + start;
+      compare(spaces_and_comments, Reference::spaces_and_comments, "spaces_and_comments", p, input);
+      compare(block_comment, Reference::block_comment, "block_comment", p, input);
+      compare(line_comment, Reference::line_comment, "line_comment", p, input);
+      compare(double_quoted_string, Reference::quoted_string<'"'>, "double_quoted_string", p, input);
+      compare(single_quoted_string, Reference::quoted_string<'\''>, "single_quoted_string", p, input);
+    }
+    delete[] src;
+  }
+  cout << samples << " random sources, " << failures << " failures" << endl;
+}
+
+// Breaks each file into the tokens the parser looks for most, the way it
+// does: skip whitespace and comments, then try each lexer in turn.
+template <prelexer skip>
+size_t lex(const vector<string>& sources)
+{
+  size_t tokens = 0;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const char* src = sources[i].c_str();
+    while (*(src = skip(src))) {
+      const char* p;
+      if ((p = string_constant(src)) || (p = identifier(src)) || (p = number(src))) {
+        src = p;
+        ++tokens;
+      }
+      else ++src;
+    }
+  }
+  return tokens;
+}
+
+template <prelexer skip>
+double time_lex(const vector<string>& sources, size_t rounds, size_t& tokens)
+{
+  clock_t start = clock();
+  for (size_t r = 0; r < rounds; ++r) tokens = lex<skip>(sources);
+  return double(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// e.g., test_prelexer $(find sass-spec/spec -name '*.scss')
+void bench(int argc, char** argv)
+{
+  vector<string> sources;
+  size_t bytes = 0;
+  for (int i = 1; i < argc; ++i) {
+    ifstream file(argv[i], ios::in | ios::binary);
+    stringstream contents;
+    contents << file.rdbuf();
+    sources.push_back(contents.str());
+    bytes += sources.back().length();
+  }
+  size_t rounds = bytes ? 1 + 50000000 / bytes : 0;
+  size_t slow_tokens, fast_tokens;
+  double slow = time_lex<Reference::spaces_and_comments>(sources, rounds, slow_tokens);
+  double fast = time_lex<spaces_and_comments>(sources, rounds, fast_tokens);
+  cout << sources.size() << " files, " << bytes << " bytes, " << fast_tokens << " tokens; "
+       << rounds << " rounds: " << slow << "s with combinators, " << fast << "s with tables" << endl;
+  if (slow_tokens != fast_tokens) {
+    cout << "token counts differ: " << slow_tokens << " vs " << fast_tokens << endl;
+    ++failures;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  check_classes();
+  check_skippers(200000);
+  if (argc > 1) bench(argc, argv);
+  return failures ? 1 : 0;
+}
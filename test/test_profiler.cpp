@@ -0,0 +1,176 @@
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include "../sass_interface.h"
+#include "../ast.hpp"
+#include "../profiler.hpp"
+
+// g++ -I.. test_profiler.cpp ../libsass.a -pthread -o test_profiler
+
+using namespace std;
+using namespace Sass;
+
+size_t failures = 0;
+
+void check(bool ok, string what)
+{
+  if (!ok) {
+    ++failures;
+    cout << "failed: " << what << endl;
+  }
+}
+
+// keeps the clock moving, so that every call takes measurable time
+void spin()
+{
+  clock_t start = clock();
+  while (clock() - start < CLOCKS_PER_SEC / 200) { }
+}
+
+// the line of the profile for the definition called name
+string entry(const string& json, const string& name)
+{
+  size_t at = json.find("\"name\": \"" + name + "\"");
+  if (at == string::npos) return "";
+  size_t begin = json.rfind('{', at), end = json.find('}', at);
+  return json.substr(begin, end - begin + 1);
+}
+
+double field(const string& entry, const string& key)
+{
+  size_t at = entry.find("\"" + key + "\": ");
+  return at == string::npos ? -1 : atof(entry.c_str() + at + key.length() + 4);
+}
+
+// the total of the collapsed stacks whose frames are exactly these
+long stack_micros(const string& stacks, const string& frames)
+{
+  istringstream lines(stacks);
+  string line;
+  while (getline(lines, line)) {
+    size_t space = line.rfind(' ');
+    if (line.substr(0, space) == frames) return atol(line.c_str() + space + 1);
+  }
+  return -1;
+}
+
+void check_calls()
+{
+  Definition outer("a.scss", Position(1, 1, 1), "outer", 0, 0, Definition::MIXIN);
+  Definition inner("a.scss", Position(1, 5, 1), "inner", 0, 0, Definition::FUNCTION);
+  Definition fact("we\"ird;.scss", Position(2, 9, 1), "fact", 0, 0, Definition::FUNCTION);
+
+  // node counts as the compile's memory manager would report them
+  Profiler p;
+  p.start_compile();
+  p.enter(&outer, 0);
+  spin();
+  p.enter(&inner, 10);
+  spin();
+  p.leave(15);
+  p.enter(&inner, 20);
+  spin();
+  p.leave(23);
+  spin();
+  p.leave(30);
+
+  p.enter(&fact, 100);
+  spin();
+  p.enter(&fact, 101);
+  spin();
+  p.enter(&fact, 103);
+  spin();
+  p.leave(106);
+  p.leave(110);
+  p.leave(120);
+
+  string json(p.json());
+  string o(entry(json, "outer")), i(entry(json, "inner")), f(entry(json, "fact"));
+  check(o.find("\"kind\": \"mixin\"") != string::npos && i.find("\"kind\": \"function\"") != string::npos, "kinds");
+  check(f.find("\"path\": \"we\\\"ird;.scss\"") != string::npos && field(f, "line") == 9, "path and line");
+  check(field(o, "calls") == 1 && field(i, "calls") == 2 && field(f, "calls") == 3, "calls");
+
+  // a call's own nodes leave out its callees'; a recursive definition's
+  // inclusive totals are its outermost call's
+  check(field(o, "inclusive_nodes") == 30 && field(o, "exclusive_nodes") == 22, "outer nodes");
+  check(field(i, "inclusive_nodes") == 8 && field(i, "exclusive_nodes") == 8, "inner nodes");
+  check(field(f, "inclusive_nodes") == 20 && field(f, "exclusive_nodes") == 20, "recursive nodes");
+
+  double oi = field(o, "inclusive_seconds"), oe = field(o, "exclusive_seconds");
+  double ii = field(i, "inclusive_seconds"), ie = field(i, "exclusive_seconds");
+  double fi = field(f, "inclusive_seconds"), fe = field(f, "exclusive_seconds");
+  check(oe > 0 && ie > 0 && fe > 0, "every definition took time");
+  check(ii == ie, "a leaf's time is all its own");
+  check(oi > oe && oi >= oe + ii - 1e-9 && oi <= oe + ii + 1e-9, "outer = its own time + inner's");
+  check(fi >= fe - 1e-9 && fi <= fe + 1e-9, "recursive time is counted once");
+
+  // most exclusive time first
+  size_t last = 0;
+  double previous = 1e9;
+  while ((last = json.find("\"exclusive_seconds\": ", last)) != string::npos) {
+    double e = atof(json.c_str() + last + 21);
+    check(e <= previous, "json order");
+    previous = e;
+    ++last;
+  }
+
+  // each distinct stack once, in microseconds of its own time; ';' only
+  // separates frames
+  string stacks(p.collapsed_stacks());
+  long outer_only = stack_micros(stacks, "outer (a.scss:1)");
+  long outer_inner = stack_micros(stacks, "outer (a.scss:1);inner (a.scss:5)");
+  long fact3 = stack_micros(stacks, "fact (we\"ird,.scss:9);fact (we\"ird,.scss:9);fact (we\"ird,.scss:9)");
+  check(outer_only > 0 && outer_inner > 0 && fact3 > 0, "collapsed stacks:\n" + stacks);
+  check(labs(outer_inner - long(ie * 1e6 + 0.5)) <= 1, "inner's stack is its time");
+  long total = 0;
+  istringstream lines(stacks);
+  string line;
+  size_t count = 0;
+  while (getline(lines, line)) {
+    total += atol(line.c_str() + line.rfind(' ') + 1);
+    ++count;
+  }
+  check(count == 5, "five distinct stacks");
+  check(labs(total - long((oe + ie + fe) * 1e6)) <= long(count), "stacks add up to the exclusive times");
+
+  // a failed compile's open calls don't carry over
+  p.enter(&outer, 0);
+  p.start_compile();
+  p.leave(5);
+  check(field(entry(p.json(), "outer"), "calls") == 1, "open calls forgotten");
+}
+
+// calls answered by the memo are counted like the others
+void check_memoized()
+{
+  const char* source =
+    "@function twice($x) { @return $x * 2; }\n"
+    "@mixin m { a: twice(1); }\n"
+    ".a { b: twice(1); b: twice(1); b: twice(2); @include m; @include m; }\n";
+  for (int memoize = 0; memoize < 2; ++memoize) {
+    sass_profiler* profiler = sass_new_profiler();
+    sass_context* ctx = sass_new_context();
+    ctx->source_string = source;
+    ctx->options.memoize_functions = memoize;
+    ctx->profiler = profiler;
+    sass_compile(ctx);
+    check(!ctx->error_status, "compiled");
+    sass_free_context(ctx);
+    char* json = sass_profiler_json(profiler);
+    check(field(entry(json, "twice"), "calls") == 5, memoize ? "memoized calls" : "calls");
+    check(field(entry(json, "m"), "calls") == 2, "mixin calls");
+    free(json);
+    sass_free_profiler(profiler);
+  }
+}
+
+int main()
+{
+  check_calls();
+  check_memoized();
+  cout << failures << " failures" << endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include "../file.hpp"
+
+// g++ test_read_file.cpp ../file.cpp ../sass2scss/sass2scss.cpp -pthread
+
+using namespace std;
+using namespace Sass;
+
+size_t failures = 0;
+
+void check(size_t size)
+{
+  string path("test_read_file.tmp.scss");
+  string expected;
+  for (size_t i = 0; i < size; ++i) expected += char('a' + i % 26);
+  {
+    ofstream out(path.c_str(), ios::out | ios::binary);
+    out << expected;
+  }
+  size_t mapped = File::bytes_mapped(), copied = File::bytes_copied();
+  char* contents = File::read_file(path);
+  if (!contents || memcmp(contents, expected.data(), size) || contents[size]) {
+    cout << "wrong contents for a file of " << size << " bytes" << endl;
+    ++failures;
+  }
+  size_t loaded = (File::bytes_mapped() - mapped) + (File::bytes_copied() - copied);
+  if (loaded != size) {
+    cout << "counted " << loaded << " bytes for a file of " << size << endl;
+    ++failures;
+  }
+  cout << size << " bytes " << (File::bytes_mapped() > mapped ? "mapped" : "copied") << endl;
+  File::release_file(contents);
+  remove(path.c_str());
+}
+
+int main()
+{
+  // small, large, and large but ending on a page boundary
+  check(0);
+  check(100);
+  check(70000);
+  check(65536);
+  check(1 << 20);
+  check(1000001);
+  if (File::read_file("no such file")) ++failures;
+  return failures ? 1 : 0;
+}
@@ -1,5 +1,7 @@
 #include <string>
 #include <iostream>
+#include <cstdlib>
+#include <ctime>
 #include "../subset_map.hpp"
 
 using namespace std;
@@ -29,6 +31,57 @@ string vector_to_string(vector<T> v)
   return buffer.str();
 }
 
+// Builds a map shaped like a stylesheet with lots of @extend directives:
+// thousands of extendees, each a couple of simple selectors drawn from a
+// few hundred distinct ones, then looks up thousands of compound selectors
+// and checks a sample of the answers against a brute-force scan.
+int benchmark(size_t extenders, size_t lookups)
+{
+  const size_t simples = 400;
+  vector<string> names;
+  for (size_t i = 0; i < simples; ++i) {
+    stringstream ss;
+    ss << (i % 4 == 0 ? "" : i % 4 == 1 ? "." : i % 4 == 2 ? "#" : "%") << "sel" << i;
+    names.push_back(ss.str());
+  }
+
+  srand(42);
+  Subset_Map<string, size_t> bench_ssm;
+  vector<set<string> > keys;
+  for (size_t i = 0; i < extenders; ++i) {
+    vector<string> key;
+    for (size_t j = 0, L = 1 + rand() % 3; j < L; ++j) key.push_back(names[rand() % simples]);
+    bench_ssm.put(key, i);
+    keys.push_back(set<string>(key.begin(), key.end()));
+  }
+
+  vector<vector<string> > queries;
+  for (size_t i = 0; i < lookups; ++i) {
+    vector<string> query;
+    for (size_t j = 0, L = 1 + rand() % 5; j < L; ++j) query.push_back(names[rand() % simples]);
+    queries.push_back(query);
+  }
+
+  size_t found = 0;
+  clock_t start = clock();
+  for (size_t i = 0; i < lookups; ++i) found += bench_ssm.get_v(queries[i]).size();
+  double elapsed = double(clock() - start) / CLOCKS_PER_SEC;
+
+  size_t mismatches = 0;
+  for (size_t i = 0; i < lookups; i += 10) {
+    set<string> query(queries[i].begin(), queries[i].end());
+    vector<size_t> expected;
+    for (size_t j = 0; j < extenders; ++j) {
+      if (includes(query.begin(), query.end(), keys[j].begin(), keys[j].end())) expected.push_back(j);
+    }
+    if (bench_ssm.get_v(queries[i]) != expected) ++mismatches;
+  }
+
+  cout << extenders << " extenders, " << lookups << " lookups: "
+       << found << " matches in " << elapsed << "s, "
+       << mismatches << " mismatches" << endl;
+  return mismatches ? 1 : 0;
+}
 
 int main()
 {
@@ -91,5 +144,11 @@ int main()
     cout << fetched3[i].first << endl;
   }
 
-  return 0;
+  cout << endl << "BENCHMARK:" << endl;
+  int failures = 0;
+  failures += benchmark(1000, 10000);
+  failures += benchmark(5000, 10000);
+  failures += benchmark(20000, 10000);
+
+  return failures;
 }
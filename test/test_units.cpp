@@ -0,0 +1,121 @@
+#include <string>
+#include <iostream>
+#include <cmath>
+#include <ctime>
+#include "../units.hpp"
+
+using namespace std;
+using namespace Sass;
+
+size_t failures = 0;
+
+void check(bool ok, string what)
+{
+  if (!ok) {
+    ++failures;
+    cout << "failed: " << what << endl;
+  }
+}
+
+Units units(string numerators, string denominators)
+{
+  Units u;
+  size_t i = 0, j;
+  while (i < numerators.size()) {
+    j = numerators.find(' ', i);
+    if (j == string::npos) j = numerators.size();
+    u.multiply(intern_unit(numerators.substr(i, j - i)));
+    i = j + 1;
+  }
+  i = 0;
+  while (i < denominators.size()) {
+    j = denominators.find(' ', i);
+    if (j == string::npos) j = denominators.size();
+    u.divide(intern_unit(denominators.substr(i, j - i)));
+    i = j + 1;
+  }
+  return u;
+}
+
+void normalized(string numerators, string denominators, double value, string to,
+                string expected, double expected_value)
+{
+  Units u(units(numerators, denominators));
+  double v = u.normalize(value, intern_unit(to));
+  string what = numerators + " / " + denominators + " -> " + u.to_string();
+  check(u.to_string() == expected, what + ", expected " + expected);
+  check(fabs(v - expected_value) <= 1e-9 * fabs(expected_value), what + ": wrong value");
+}
+
+int main()
+{
+  // every conversion undoes the one the other way
+  for (Unit a = UNITLESS; a < KNOWN_UNITS; ++a) {
+    for (Unit b = UNITLESS; b < KNOWN_UNITS; ++b) {
+      double there = conversion_factor(a, b), back = conversion_factor(b, a);
+      bool same_kind = unit_family(a) != INCOMMENSURABLE && unit_family(a) == unit_family(b);
+      check(same_kind ? fabs(there * back - 1) < 1e-12 : !there && !back,
+            string(unit_name(a)) + " <-> " + unit_name(b));
+    }
+  }
+  check(conversion_factor(IN, PX) == 96, "in -> px");
+  check(conversion_factor(SEC, MSEC) == 1000, "s -> ms");
+  check(fabs(conversion_factor(TURN, DEG) - 360) < 1e-12, "turn -> deg");
+  check(fabs(conversion_factor(DPPX, DPI) - 96) < 1e-12, "dppx -> dpi");
+
+  // names round-trip, and other units are interned once
+  for (Unit u = UNITLESS; u < KNOWN_UNITS; ++u) check(intern_unit(unit_name(u)) == u, unit_name(u));
+  Unit foo = intern_unit("foo");
+  check(foo >= KNOWN_UNITS && intern_unit("foo") == foo && string(unit_name(foo)) == "foo", "foo");
+  check(intern_unit("bar") != foo, "bar");
+  // case matters
+  check(intern_unit("hz") >= KNOWN_UNITS && !conversion_factor(intern_unit("khz"), HZ), "hz");
+  check(string(unit_name(intern_unit("PX"))) == "PX" && !conversion_factor(intern_unit("PX"), PX), "PX");
+
+  check(units("", "").to_string() == "", "unitless");
+  check(units("px", "").to_string() == "px", "px");
+  check(units("px em", "s").to_string() == "px*em/s", "px*em/s");
+  check(units("", "px").to_string() == "/px", "/px");
+  check(units("px", "") == units("px", ""), "px == px");
+  check(units("px", "") != units("", "px"), "px != /px");
+  check(units("px em", "") != units("em px", ""), "order matters");
+
+  normalized("px", "", 1, "", "px", 1);
+  normalized("in", "", 1, "px", "px", 96);
+  normalized("px", "in", 96, "", "", 1);
+  normalized("em px", "em", 3, "", "px", 3);
+  normalized("px em cm", "", 1, "", "em*px*px", 96 / 2.54);
+  normalized("cm em px", "", 1, "", "cm*cm*em", 2.54 / 96);
+  normalized("s", "ms", 1, "", "", 1000);
+  normalized("px s", "in ms", 1, "", "", 1000.0 / 96);
+  normalized("deg", "turn", 180, "", "", 0.5);
+  normalized("foo bar", "foo", 6, "", "bar", 6);
+  normalized("px px px px px px", "px px px px px", 1, "", "px", 1);
+  normalized("px px px px px px", "", 1, "", "px*px*px*px*px*px", 1);
+
+  // more than fit inline
+  Units many;
+  for (size_t i = 0; i < 20; ++i) many.multiply(i % 2 ? PX : EM);
+  Units copy(many);
+  check(copy == many && copy.numerators() == 20, "copied");
+  copy.divide(many);
+  check(copy.numerators() == 20 && copy.denominators() == 20, "divided");
+  copy.normalize(1);
+  check(copy.empty(), "cancelled");
+
+  size_t n = 1000000;
+  double total = 0;
+  Units px(PX), in(IN);
+  clock_t start = clock();
+  for (size_t i = 0; i < n; ++i) {
+    Units u(px);
+    u.multiply(in);
+    u.divide(px);
+    total += u.normalize(double(i), PX);
+  }
+  cout << n << " multiply/divide/normalize in "
+       << double(clock() - start) / CLOCKS_PER_SEC << "s (" << total << ")" << endl;
+
+  cout << failures << " failures" << endl;
+  return failures ? 1 : 0;
+}
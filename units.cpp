@@ -1,8 +1,37 @@
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <map>
+
 #include "units.hpp"
 
+#ifndef SASS_MUTEX
+#include "mutex.hpp"
+#endif
+
 namespace Sass {
 
-  double conversion_factors[6][6] = {
+  static const struct {
+    const char* name;
+    Unit_Family family;
+  } known_units[KNOWN_UNITS] = {
+    { "",     INCOMMENSURABLE },
+    { "in",   LENGTH },     { "cm",   LENGTH },     { "pc",   LENGTH },
+    { "mm",   LENGTH },     { "pt",   LENGTH },     { "px",   LENGTH },
+    { "deg",  ANGLE },      { "grad", ANGLE },      { "rad",  ANGLE },
+    { "turn", ANGLE },
+    { "s",    TIME },       { "ms",   TIME },
+    { "Hz",   FREQUENCY },  { "kHz",  FREQUENCY },
+    { "dpi",  RESOLUTION }, { "dpcm", RESOLUTION }, { "dppx", RESOLUTION },
+    { "em",   INCOMMENSURABLE }, { "rem",  INCOMMENSURABLE }, { "%",    INCOMMENSURABLE },
+    { "ex",   INCOMMENSURABLE }, { "ch",   INCOMMENSURABLE }, { "vw",   INCOMMENSURABLE },
+    { "vh",   INCOMMENSURABLE }, { "vmin", INCOMMENSURABLE }, { "vmax", INCOMMENSURABLE },
+    { "fr",   INCOMMENSURABLE }
+  };
+
+  static const double PI = 3.14159265358979323846;
+
+  static const double lengths[6][6] = {
              /*  in         cm         pc         mm         pt         px     */
     /* in */ { 1,         2.54,      6,         25.4,      72,        96        },
     /* cm */ { 1.0/2.54,  1,         6.0/2.54,  10,        72.0/2.54, 96.0/2.54 },
@@ -12,33 +41,235 @@ namespace Sass {
     /* px */ { 1.0/96.0,  2.54/96.0, 6.0/96.0,  25.4/96.0, 72.0/96.0, 1         }
   };
 
-  Unit string_to_unit(const string& s)
+  static const double angles[4][4] = {
+               /*  deg        grad       rad        turn      */
+    /* deg  */ { 1,         40.0/36.0, PI/180.0,  1.0/360.0 },
+    /* grad */ { 36.0/40.0, 1,         PI/200.0,  1.0/400.0 },
+    /* rad  */ { 180.0/PI,  200.0/PI,  1,         0.5/PI    },
+    /* turn */ { 360,       400,       2.0*PI,    1         }
+  };
+
+  static const double times[2][2] = {
+             /*  s          ms    */
+    /* s  */ { 1,         1000 },
+    /* ms */ { 1.0/1000,  1    }
+  };
+
+  static const double frequencies[2][2] = {
+              /*  Hz         kHz      */
+    /* Hz  */ { 1,         1.0/1000 },
+    /* kHz */ { 1000,      1        }
+  };
+
+  static const double resolutions[3][3] = {
+               /*  dpi        dpcm       dppx     */
+    /* dpi  */ { 1,         1.0/2.54,  1.0/96.0  },
+    /* dpcm */ { 2.54,      1,         2.54/96.0 },
+    /* dppx */ { 96,        96.0/2.54, 1         }
+  };
+
+  // the units that aren't CSS units, by id - KNOWN_UNITS; shared by the
+  // compiles on every thread
+  static deque<string>     other_units;
+  static map<string, Unit> other_ids;
+  static Mutex             other_lock;
+
+  Unit intern_unit(const string& s)
+  {
+    if (s.empty()) return UNITLESS;
+    for (Unit u = UNITLESS + 1; u < KNOWN_UNITS; ++u) {
+      if (known_units[u].name[0] == s[0] && s == known_units[u].name) return u;
+    }
+    other_lock.lock();
+    map<string, Unit>::iterator i = other_ids.find(s);
+    Unit u;
+    if (i != other_ids.end()) {
+      u = i->second;
+    }
+    else {
+      u = KNOWN_UNITS + other_units.size();
+      other_units.push_back(s);
+      other_ids[s] = u;
+    }
+    other_lock.unlock();
+    return u;
+  }
+
+  const char* unit_name(Unit u)
+  {
+    if (u < KNOWN_UNITS) return known_units[u].name;
+    // the strings stay put as the deque grows
+    other_lock.lock();
+    const char* name = other_units[u - KNOWN_UNITS].c_str();
+    other_lock.unlock();
+    return name;
+  }
+
+  Unit_Family unit_family(Unit u)
+  { return u < KNOWN_UNITS ? known_units[u].family : INCOMMENSURABLE; }
+
+  double conversion_factor(Unit from, Unit to)
+  {
+    Unit_Family family = unit_family(from);
+    if (family != unit_family(to)) return 0;
+    switch (family) {
+      case LENGTH:     return lengths[from - IN][to - IN];
+      case ANGLE:      return angles[from - DEG][to - DEG];
+      case TIME:       return times[from - SEC][to - SEC];
+      case FREQUENCY:  return frequencies[from - HZ][to - HZ];
+      case RESOLUTION: return resolutions[from - DPI][to - DPI];
+      default:         return 0;
+    }
+  }
+
+  Units::Units()
+  : ids_(inline_), numerators_(0), size_(0), capacity_(INLINE)
+  { }
+
+  Units::Units(Unit u)
+  : ids_(inline_), numerators_(0), size_(0), capacity_(INLINE)
+  {
+    if (u != UNITLESS) {
+      ids_[0] = u;
+      numerators_ = size_ = 1;
+    }
+  }
+
+  Units::Units(const Units& other)
+  : ids_(inline_), numerators_(0), size_(0), capacity_(INLINE)
+  { *this = other; }
+
+  Units::~Units()
+  { if (ids_ != inline_) delete[] ids_; }
+
+  Units& Units::operator=(const Units& other)
+  {
+    if (this != &other) {
+      reserve(other.size_);
+      std::copy(other.ids_, other.ids_ + other.size_, ids_);
+      numerators_ = other.numerators_;
+      size_ = other.size_;
+    }
+    return *this;
+  }
+
+  void Units::reserve(size_t n)
+  {
+    if (n <= capacity_) return;
+    size_t capacity = std::max(n, 2 * static_cast<size_t>(capacity_));
+    Unit* ids = new Unit[capacity];
+    std::copy(ids_, ids_ + size_, ids);
+    if (ids_ != inline_) delete[] ids_;
+    ids_ = ids;
+    capacity_ = capacity;
+  }
+
+  void Units::multiply(Unit u)
+  {
+    reserve(size_ + 1);
+    std::copy_backward(ids_ + numerators_, ids_ + size_, ids_ + size_ + 1);
+    ids_[numerators_++] = u;
+    ++size_;
+  }
+
+  void Units::divide(Unit u)
   {
-    if      (s == "in") return IN;
-    else if (s == "cm") return CM;
-    else if (s == "pc") return PC;
-    else if (s == "mm") return MM;
-    else if (s == "pt") return PT;
-    else if (s == "px") return PX;
-    else                return INCOMMENSURABLE;
+    reserve(size_ + 1);
+    ids_[size_++] = u;
   }
 
-  double conversion_factor(const string& s1, const string& s2)
+  void Units::multiply(const Units& other)
   {
-    Unit u1 = string_to_unit(s1);
-    Unit u2 = string_to_unit(s2);
-    double factor;
-    if (u1 == INCOMMENSURABLE || u2 == INCOMMENSURABLE)
-      factor = 0;
-    else
-      factor = conversion_factors[u1][u2];
-    return factor;
+    if (&other == this) {
+      Units copy(other);
+      multiply(copy);
+      return;
+    }
+    for (size_t i = 0, S = other.numerators(); i < S; ++i) multiply(other.numerator(i));
+    for (size_t i = 0, S = other.denominators(); i < S; ++i) divide(other.denominator(i));
   }
 
-  double convert(double n, const string& from, const string& to)
+  void Units::divide(const Units& other)
+  {
+    if (&other == this) {
+      Units copy(other);
+      divide(copy);
+      return;
+    }
+    for (size_t i = 0, S = other.numerators(); i < S; ++i) divide(other.numerator(i));
+    for (size_t i = 0, S = other.denominators(); i < S; ++i) multiply(other.denominator(i));
+  }
+
+  bool Units::operator==(const Units& other) const
+  {
+    return numerators_ == other.numerators_ &&
+           size_ == other.size_ &&
+           std::equal(ids_, ids_ + size_, other.ids_);
+  }
+
+  string Units::to_string() const
+  {
+    if (size_ == 1 && numerators_ == 1) return unit_name(ids_[0]);
+    string s;
+    for (size_t i = 0; i < numerators_; ++i) {
+      if (i) s += '*';
+      s += unit_name(ids_[i]);
+    }
+    if (numerators_ < size_) s += '/';
+    for (size_t i = numerators_; i < size_; ++i) {
+      if (i > numerators_) s += '*';
+      s += unit_name(ids_[i]);
+    }
+    return s;
+  }
+
+  Unit Units::convertible() const
+  {
+    for (size_t i = 0; i < size_; ++i) {
+      if (unit_family(ids_[i]) != INCOMMENSURABLE) return ids_[i];
+    }
+    return UNITLESS;
+  }
+
+  static bool by_name(Unit a, Unit b)
+  { return strcmp(unit_name(a), unit_name(b)) < 0; }
+
+  double Units::normalize(double value, Unit to)
   {
-    double factor = conversion_factor(from, to);
-    return factor ? factor * n : n;
+    Unit_Family family_of_to = unit_family(to);
+    for (size_t i = 0; i < size_; ++i) {
+      Unit_Family family = unit_family(ids_[i]);
+      if (family == INCOMMENSURABLE) continue;
+      Unit target = to;
+      if (family != family_of_to) {
+        // the first of its kind, which has been left as it is
+        size_t j = 0;
+        while (unit_family(ids_[j]) != family) ++j;
+        target = ids_[j];
+      }
+      if (i < numerators_) value *= conversion_factor(ids_[i], target);
+      else                 value /= conversion_factor(ids_[i], target);
+      ids_[i] = target;
+    }
+    // Now divide out identical units in the numerator and denominator.
+    size_t kept = 0;
+    for (size_t i = 0; i < numerators_; ++i) {
+      Unit* d = std::find(ids_ + numerators_, ids_ + size_, ids_[i]);
+      if (d != ids_ + size_) {
+        std::copy(d + 1, ids_ + size_, d);
+        --size_;
+      }
+      else {
+        ids_[kept++] = ids_[i];
+      }
+    }
+    std::copy(ids_ + numerators_, ids_ + size_, ids_ + kept);
+    size_ -= numerators_ - kept;
+    numerators_ = kept;
+    // Sort the units to make them pretty and, well, normal.
+    if (numerators_ > 1) std::sort(ids_, ids_ + numerators_, by_name);
+    if (size_ - numerators_ > 1) std::sort(ids_ + numerators_, ids_ + size_, by_name);
+    return value;
   }
 
 }
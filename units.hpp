@@ -1,11 +1,84 @@
+#define SASS_UNITS
+
 #include <string>
 
 namespace Sass {
   using namespace std;
 
-  enum Unit { IN, CM, PC, MM, PT, PX, INCOMMENSURABLE };
-  extern double conversion_factors[6][6];
-  Unit string_to_unit(const string&);
-  double conversion_factor(const string&, const string&);
-  double convert(double, const string&, const string&);
+  /////////////////////////////////////////////////////////////////////////////
+  // Units are interned: each one a number carries is a small id, so that
+  // they can be kept in place and compared without building strings. The
+  // CSS units have fixed ids; any other unit is given one the first time
+  // it's seen, which holds for the rest of the process. Names are matched
+  // exactly, as Sass does: `hz` or `PX` is a unit of its own, kept as
+  // written, and doesn't convert to `Hz` or `px`.
+  /////////////////////////////////////////////////////////////////////////////
+  typedef unsigned int Unit;
+
+  enum Known_Unit {
+    UNITLESS,
+    IN, CM, PC, MM, PT, PX,
+    DEG, GRAD, RAD, TURN,
+    SEC, MSEC,
+    HZ, KHZ,
+    DPI, DPCM, DPPX,
+    EM, REM, PERCENT, EX, CH, VW, VH, VMIN, VMAX, FR,
+    KNOWN_UNITS
+  };
+
+  enum Unit_Family { INCOMMENSURABLE, LENGTH, ANGLE, TIME, FREQUENCY, RESOLUTION };
+
+  Unit        intern_unit(const string&);
+  const char* unit_name(Unit);
+  Unit_Family unit_family(Unit);
+  // how many of `to` make one `from`; 0 if they can't be converted
+  double      conversion_factor(Unit from, Unit to);
+
+  /////////////////////////////////////////////////////////////////////////////
+  // The units of a number, the numerator's followed by the denominator's.
+  // Up to four are kept inline; more than that go to the heap.
+  /////////////////////////////////////////////////////////////////////////////
+  class Units {
+  public:
+    Units();
+    explicit Units(Unit u);
+    Units(const Units& other);
+    ~Units();
+    Units& operator=(const Units& other);
+
+    size_t numerators() const          { return numerators_; }
+    size_t denominators() const        { return size_ - numerators_; }
+    Unit   numerator(size_t i) const   { return ids_[i]; }
+    Unit   denominator(size_t i) const { return ids_[numerators_ + i]; }
+    bool   empty() const               { return !size_; }
+
+    void multiply(Unit u);
+    void divide(Unit u);
+    void multiply(const Units& other);
+    void divide(const Units& other);
+
+    // the same units in the same order
+    bool operator==(const Units& other) const;
+    bool operator!=(const Units& other) const { return !(*this == other); }
+
+    // e.g. "px", "em*px/s"
+    string to_string() const;
+    // the first unit that can be converted to others, or UNITLESS
+    Unit   convertible() const;
+    // Converts every unit that can be to `to`, if it's of the same kind, or
+    // else to the first of its kind here; divides out the units that are
+    // then on both sides and sorts the rest. Returns value in the new units.
+    double normalize(double value, Unit to = UNITLESS);
+
+  private:
+    enum { INLINE = 4 };
+    void reserve(size_t n);
+
+    Unit*        ids_;
+    unsigned int numerators_;
+    unsigned int size_;
+    unsigned int capacity_;
+    Unit         inline_[INLINE];
+  };
+
 }
@@ -0,0 +1,129 @@
+#include <cmath>
+
+#ifndef SASS_VALUE
+#include "value.hpp"
+#endif
+
+#ifndef SASS_AST
+#include "ast.hpp"
+#endif
+
+#include "context.hpp"
+
+namespace Sass {
+
+  Value boxed(Expression* e)
+  {
+    Value v = { Value::BOXED, UNITLESS, 0, e->path(), e };
+    return v;
+  }
+
+  Value unboxed_number(double number, Unit unit, const char* path, AST_Node* node)
+  {
+    Value v = { Value::NUMBER, unit, number, path, node };
+    return v;
+  }
+
+  static Value unboxed_boolean(bool b, const char* path, AST_Node* node)
+  {
+    Value v = { Value::BOOLEAN, UNITLESS, b ? 1.0 : 0.0, path, node };
+    return v;
+  }
+
+  Expression* box(const Value& v, Context& ctx)
+  {
+    switch (v.tag) {
+      case Value::NUMBER:  return new (ctx.mem) Number(v.path, v.node->position(), v.number, v.unit);
+      case Value::BOOLEAN: return new (ctx.mem) Boolean(v.path, v.node->position(), v.number != 0);
+      default:             return static_cast<Expression*>(v.node);
+    }
+  }
+
+  bool is_true(const Value& v)
+  {
+    switch (v.tag) {
+      case Value::NUMBER:  return true;
+      case Value::BOOLEAN: return v.number != 0;
+      default:             return *static_cast<Expression*>(v.node);
+    }
+  }
+
+  bool as_number(const Value& v, double& n, Unit& unit)
+  {
+    if (v.tag == Value::NUMBER) {
+      n = v.number;
+      unit = v.unit;
+      return true;
+    }
+    if (v.tag != Value::BOXED || static_cast<Expression*>(v.node)->concrete_type() != Expression::NUMBER) return false;
+    Number* number = static_cast<Number*>(v.node);
+    Units& units = number->units();
+    if (units.denominators() || units.numerators() > 1) return false;
+    unit = units.empty() ? UNITLESS : units.numerator(0);
+    n = number->value();
+    return true;
+  }
+
+  static bool as_boolean(const Value& v, bool& b)
+  {
+    if (v.tag == Value::BOOLEAN) {
+      b = v.number != 0;
+      return true;
+    }
+    if (v.tag != Value::BOXED || static_cast<Expression*>(v.node)->concrete_type() != Expression::BOOLEAN) return false;
+    b = static_cast<Boolean*>(v.node)->value();
+    return true;
+  }
+
+  // Mirrors op_numbers, eq and lt for the cases it takes on; the units
+  // these leave alone are never converted, so the values aren't either.
+  bool op_unboxed(Binary_Expression* b, const Value& l, const Value& r, Value& result)
+  {
+    Binary_Expression::Type op = b->type();
+    double x, y;
+    Unit lu, ru;
+    if (!as_number(l, x, lu) || !as_number(r, y, ru)) {
+      bool p, q;
+      if ((op == Binary_Expression::EQ || op == Binary_Expression::NEQ) && as_boolean(l, p) && as_boolean(r, q)) {
+        result = unboxed_boolean((p == q) == (op == Binary_Expression::EQ), b->path(), b);
+        return true;
+      }
+      return false;
+    }
+    switch (op) {
+      case Binary_Expression::ADD:
+      case Binary_Expression::SUB:
+        if (lu && ru && lu != ru) return false;
+        result = unboxed_number(op == Binary_Expression::ADD ? x + y : x - y, lu ? lu : ru, l.path, b);
+        return true;
+      case Binary_Expression::MUL:
+        if (lu && ru) return false;
+        result = unboxed_number(x * y, lu ? lu : ru, l.path, b);
+        return true;
+      case Binary_Expression::DIV:
+        if (!y || (ru && ru != lu)) return false;
+        result = unboxed_number(x / y, ru ? 0 : lu, l.path, b);
+        return true;
+      case Binary_Expression::MOD:
+        if (!y || (lu && ru && lu != ru)) return false;
+        result = unboxed_number(fmod(x, y), lu, l.path, b);
+        return true;
+      default:
+        break;
+    }
+    if (lu && ru && lu != ru) return false;
+    bool eq = lu == ru && x == y, lt = x < y, z = false;
+    switch (op) {
+      case Binary_Expression::EQ:  z = eq; break;
+      case Binary_Expression::NEQ: z = !eq; break;
+      case Binary_Expression::GT:  z = !lt && !eq; break;
+      case Binary_Expression::GTE: z = !lt; break;
+      case Binary_Expression::LT:  z = lt; break;
+      case Binary_Expression::LTE: z = lt || eq; break;
+      default:                     return false;
+    }
+    result = unboxed_boolean(z, b->path(), b);
+    return true;
+  }
+
+}
@@ -0,0 +1,45 @@
+#define SASS_VALUE
+
+#ifndef SASS_UNITS
+#include "units.hpp"
+#endif
+
+namespace Sass {
+
+  class AST_Node;
+  class Expression;
+  class Binary_Expression;
+  struct Context;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // A value in the middle of an evaluation, which needn't be a node. Numbers
+  // with at most one unit (in the numerator), and booleans, are kept
+  // unboxed; anything else is BOXED, with node pointing at it. An unboxed
+  // value keeps the path and the node whose position the node made for it
+  // would have, so that boxing it (when it escapes into a variable, an
+  // argument or the output) makes the node the operator would have made.
+  /////////////////////////////////////////////////////////////////////////////
+  struct Value {
+    enum Tag { UNSET, NUMBER, BOOLEAN, BOXED };
+    Tag         tag;
+    Unit        unit;   // NUMBER
+    double      number; // NUMBER: the number; BOOLEAN: 0 or 1
+    const char* path;
+    AST_Node*   node;
+  };
+
+  Value       boxed(Expression* e);
+  Value       unboxed_number(double number, Unit unit, const char* path, AST_Node* node);
+  Expression* box(const Value& v, Context& ctx);
+  bool        is_true(const Value& v);
+
+  // Sets n and unit if v is a number that could be unboxed.
+  bool as_number(const Value& v, double& n, Unit& unit);
+
+  // The result of op_binary, if it can be had without boxing: arithmetic
+  // and comparisons of numbers that have no unit or the same unit, or whose
+  // result can have at most one, and (in)equality of booleans. Division and
+  // modulo by zero are left to op_binary.
+  bool op_unboxed(Binary_Expression* b, const Value& l, const Value& r, Value& result);
+
+}